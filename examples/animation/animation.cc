@@ -0,0 +1,151 @@
+#include "examples/animation/animation.h"
+
+#include <algorithm>
+
+namespace bando {
+
+namespace {
+
+// Keys walked linearly from the cursor before giving up and binary
+// searching; covers normal playback at any sane frame rate.
+constexpr size_t kLinearProbe = 4;
+
+// Index of the last key at or before `time` (0 when `time` precedes every
+// key), starting from the cursor.
+size_t FindKey(const std::vector<float> &times, float time, uint32_t *cursor) {
+  size_t count = times.size();
+  size_t key = *cursor;
+  if (key >= count || times[key] > time) {
+    key = 0;
+  }
+  size_t probe_end = std::min(key + kLinearProbe, count);
+  while (key + 1 < probe_end && times[key + 1] <= time) {
+    ++key;
+  }
+  if (key + 1 == probe_end && probe_end < count &&
+      times[probe_end] <= time) {
+    key = static_cast<size_t>(
+              std::upper_bound(times.begin() + probe_end, times.end(), time) -
+              times.begin()) -
+          1;
+  }
+  *cursor = static_cast<uint32_t>(key);
+  return key;
+}
+
+template <int N>
+glm::vec<N, float> LoadValue(const float *values) {
+  glm::vec<N, float> value;
+  for (int c = 0; c < N; ++c) {
+    value[c] = values[c];
+  }
+  return value;
+}
+
+// Value of element `key` and the interpolation factor towards `key + 1`.
+// Cubic spline values are Hermite interpolated here; the other modes leave
+// blending (lerp or slerp) to the caller.
+template <int N>
+glm::vec<N, float> SampleChannel(const AnimationChannel &channel,
+                                 float time,
+                                 uint32_t *cursor,
+                                 glm::vec<N, float> *next,
+                                 float *factor) {
+  size_t count = channel.times.size();
+  size_t key = FindKey(channel.times, time, cursor);
+  bool cubic =
+      channel.interpolation == AnimationInterpolation::kCubicSpline;
+  // Cubic spline keys hold (in-tangent, value, out-tangent).
+  size_t key_stride = cubic ? 3 * N : N;
+  size_t value_offset = cubic ? N : 0;
+  const float *values = channel.values.data();
+  glm::vec<N, float> value =
+      LoadValue<N>(values + key * key_stride + value_offset);
+  *factor = 0.0f;
+  *next = value;
+  if (key + 1 >= count || time <= channel.times[key] ||
+      channel.interpolation == AnimationInterpolation::kStep) {
+    return value;
+  }
+  float t0 = channel.times[key];
+  float t1 = channel.times[key + 1];
+  float dt = t1 - t0;
+  float u = dt > 0.0f ? std::clamp((time - t0) / dt, 0.0f, 1.0f) : 0.0f;
+  glm::vec<N, float> next_value =
+      LoadValue<N>(values + (key + 1) * key_stride + value_offset);
+  if (!cubic) {
+    *next = next_value;
+    *factor = u;
+    return value;
+  }
+  glm::vec<N, float> out_tangent =
+      LoadValue<N>(values + key * key_stride + 2 * N) * dt;
+  glm::vec<N, float> in_tangent =
+      LoadValue<N>(values + (key + 1) * key_stride) * dt;
+  float u2 = u * u;
+  float u3 = u2 * u;
+  glm::vec<N, float> result =
+      value * (2.0f * u3 - 3.0f * u2 + 1.0f) +
+      out_tangent * (u3 - 2.0f * u2 + u) +
+      next_value * (-2.0f * u3 + 3.0f * u2) + in_tangent * (u3 - u2);
+  *next = result;
+  return result;
+}
+
+}  // namespace
+
+void SampleAnimation(const AnimationClip &clip,
+                     float time,
+                     AnimationCursor *cursor,
+                     JointTransform *pose) {
+  if (cursor->keys.size() != clip.channels.size()) {
+    cursor->keys.assign(clip.channels.size(), 0);
+  }
+  for (size_t i = 0; i < clip.channels.size(); ++i) {
+    const AnimationChannel &channel = clip.channels[i];
+    if (channel.joint < 0 || channel.times.empty()) {
+      continue;
+    }
+    JointTransform &joint = pose[channel.joint];
+    uint32_t *key = &cursor->keys[i];
+    float factor = 0.0f;
+    if (channel.path == AnimationPath::kRotation) {
+      glm::vec4 next;
+      glm::vec4 value = SampleChannel<4>(channel, time, key, &next, &factor);
+      glm::quat from(value.w, value.x, value.y, value.z);
+      glm::quat to(next.w, next.x, next.y, next.z);
+      joint.rotation = glm::normalize(
+          factor > 0.0f ? glm::slerp(from, to, factor) : from);
+      continue;
+    }
+    glm::vec3 next;
+    glm::vec3 value = SampleChannel<3>(channel, time, key, &next, &factor);
+    glm::vec3 result = value + (next - value) * factor;
+    if (channel.path == AnimationPath::kTranslation) {
+      joint.translation = result;
+    } else {
+      joint.scale = result;
+    }
+  }
+}
+
+void ComputeJointPalette(const Skeleton &skeleton,
+                         const JointTransform *pose,
+                         glm::mat4 *world,
+                         glm::mat4 *palette) {
+  for (size_t i = 0; i < skeleton.joint_count(); ++i) {
+    const JointTransform &joint = pose[i];
+    glm::mat3 rotation = glm::mat3_cast(joint.rotation);
+    glm::mat4 local(1.0f);
+    local[0] = glm::vec4(rotation[0] * joint.scale.x, 0.0f);
+    local[1] = glm::vec4(rotation[1] * joint.scale.y, 0.0f);
+    local[2] = glm::vec4(rotation[2] * joint.scale.z, 0.0f);
+    local[3] = glm::vec4(joint.translation, 1.0f);
+    int parent = skeleton.parents[i];
+    world[i] = (parent >= 0 ? world[parent] : skeleton.root_parents[i]) *
+               local;
+    palette[i] = world[i] * skeleton.inverse_bind[i];
+  }
+}
+
+}  // namespace bando
@@ -0,0 +1,90 @@
+#ifndef EXAMPLES_ANIMATION_ANIMATION_H_
+#define EXAMPLES_ANIMATION_ANIMATION_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Skeletal animation data and sampling, independent of the file format:
+// glTF skins and animations are converted into these by
+// //examples/sdl3/hello_3d:gltf_skin.
+
+namespace bando {
+
+struct JointTransform {
+  glm::vec3 translation = glm::vec3(0.0f);
+  glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+  glm::vec3 scale = glm::vec3(1.0f);
+};
+
+// Joints are stored in topological order, so a single forward pass turns
+// local transforms into world transforms.
+struct Skeleton {
+  // parents[i] < i, or -1 for a root joint.
+  std::vector<int> parents;
+  std::vector<JointTransform> rest_pose;
+  std::vector<glm::mat4> inverse_bind;
+  // World transform of the (non-joint) node a root joint hangs from.
+  // Identity for joints that are not roots.
+  std::vector<glm::mat4> root_parents;
+
+  size_t joint_count() const { return parents.size(); }
+};
+
+enum class AnimationPath : uint8_t {
+  kTranslation,
+  kRotation,
+  kScale,
+};
+
+enum class AnimationInterpolation : uint8_t {
+  kStep,
+  kLinear,
+  kCubicSpline,
+};
+
+struct AnimationChannel {
+  int joint = -1;
+  AnimationPath path = AnimationPath::kTranslation;
+  AnimationInterpolation interpolation = AnimationInterpolation::kLinear;
+  // Ascending key times in seconds.
+  std::vector<float> times;
+  // 3 floats per key for translation and scale, 4 (x, y, z, w) for
+  // rotation. Cubic spline keys store in-tangent, value and out-tangent.
+  std::vector<float> values;
+};
+
+struct AnimationClip {
+  std::vector<AnimationChannel> channels;
+  float duration = 0.0f;
+};
+
+// Key index each channel was last sampled at. Playback moves forward in
+// small steps, so sampling resumes the search from there and usually
+// advances by zero or one key instead of binary searching every channel
+// every frame; looping back falls back to a binary search.
+struct AnimationCursor {
+  std::vector<uint32_t> keys;
+};
+
+// Overwrites the joints `clip` animates in `pose` (one entry per skeleton
+// joint, usually starting from the rest pose) with their values at `time`,
+// which is clamped to the clip's keys.
+void SampleAnimation(const AnimationClip &clip,
+                     float time,
+                     AnimationCursor *cursor,
+                     JointTransform *pose);
+
+// Skinning matrices for `pose`: palette[i] = world(i) * inverse_bind[i].
+// `world` is scratch space for joint_count() matrices.
+void ComputeJointPalette(const Skeleton &skeleton,
+                         const JointTransform *pose,
+                         glm::mat4 *world,
+                         glm::mat4 *palette);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_ANIMATION_ANIMATION_H_
@@ -0,0 +1,346 @@
+#include "examples/animation/skinning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "examples/profiling/profile_zones.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BANDO_SKIN_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BANDO_SKIN_SSE2 1
+#endif
+
+namespace bando {
+
+namespace {
+
+// Vertices per WorkerPool range: large enough to amortize claiming a range,
+// small enough that a few big characters still split across every thread.
+constexpr size_t kSkinChunk = 2048;
+constexpr size_t kCharactersPerRange = 4;
+
+const float *PaletteFloats(const glm::mat4 *palette) {
+  return &palette[0][0][0];
+}
+
+float *Advance(float *pointer, size_t stride, size_t count) {
+  return pointer ? reinterpret_cast<float *>(
+                       reinterpret_cast<unsigned char *>(pointer) +
+                       stride * count)
+                 : nullptr;
+}
+
+SkinTarget OffsetTarget(const SkinTarget &target, size_t first) {
+  SkinTarget offset = target;
+  offset.positions = Advance(target.positions, target.stride, first);
+  offset.normals = Advance(target.normals, target.stride, first);
+  offset.uvs = Advance(target.uvs, target.stride, first);
+  return offset;
+}
+
+#if defined(BANDO_SKIN_SSE2)
+
+void Store3(float *out, __m128 value) {
+  _mm_storel_pi(reinterpret_cast<__m64 *>(out), value);
+  _mm_store_ss(out + 2, _mm_movehl_ps(value, value));
+}
+
+__m128 Normalize3(__m128 value) {
+  __m128 squares = _mm_mul_ps(value, value);
+  __m128 sum = _mm_add_ss(
+      squares, _mm_shuffle_ps(squares, squares, _MM_SHUFFLE(1, 1, 1, 1)));
+  sum = _mm_add_ss(sum, _mm_movehl_ps(squares, squares));
+  float length_squared = _mm_cvtss_f32(sum);
+  if (length_squared <= 0.0f) {
+    return value;
+  }
+  return _mm_mul_ps(value, _mm_set1_ps(1.0f / std::sqrt(length_squared)));
+}
+
+// Applies the blended matrix columns to one vertex and writes it out.
+void TransformVertex(__m128 c0,
+                     __m128 c1,
+                     __m128 c2,
+                     __m128 c3,
+                     const SkinnedVertex &vertex,
+                     float *position,
+                     float *normal) {
+  __m128 p = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(vertex.position[0])),
+                 _mm_mul_ps(c1, _mm_set1_ps(vertex.position[1]))),
+      _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(vertex.position[2])), c3));
+  __m128 n = _mm_add_ps(
+      _mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(vertex.normal[0])),
+                 _mm_mul_ps(c1, _mm_set1_ps(vertex.normal[1]))),
+      _mm_mul_ps(c2, _mm_set1_ps(vertex.normal[2])));
+  Store3(position, p);
+  Store3(normal, Normalize3(n));
+}
+
+void SkinOneVertex(const float *palette,
+                   const SkinnedVertex &vertex,
+                   float *position,
+                   float *normal) {
+  __m128 c0 = _mm_setzero_ps();
+  __m128 c1 = _mm_setzero_ps();
+  __m128 c2 = _mm_setzero_ps();
+  __m128 c3 = _mm_setzero_ps();
+  for (int k = 0; k < 4; ++k) {
+    float weight = vertex.weights[k];
+    if (weight == 0.0f) {
+      continue;
+    }
+    const float *m = palette + vertex.joints[k] * 16;
+    __m128 w = _mm_set1_ps(weight);
+    c0 = _mm_add_ps(c0, _mm_mul_ps(w, _mm_loadu_ps(m)));
+    c1 = _mm_add_ps(c1, _mm_mul_ps(w, _mm_loadu_ps(m + 4)));
+    c2 = _mm_add_ps(c2, _mm_mul_ps(w, _mm_loadu_ps(m + 8)));
+    c3 = _mm_add_ps(c3, _mm_mul_ps(w, _mm_loadu_ps(m + 12)));
+  }
+  TransformVertex(c0, c1, c2, c3, vertex, position, normal);
+}
+
+#endif  // BANDO_SKIN_SSE2
+
+#if defined(__AVX2__)
+
+__m256 Pair(__m128 low, __m128 high) {
+  return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+}
+
+__m256 MulAdd(__m256 a, __m256 b, __m256 c) {
+#if defined(__FMA__)
+  return _mm256_fmadd_ps(a, b, c);
+#else
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+// Blends the palettes of vertices `a` and `b` side by side: the low half
+// of each register holds a column of a's matrix, the high half b's.
+void SkinVertexPair(const float *palette,
+                    const SkinnedVertex &a,
+                    const SkinnedVertex &b,
+                    float *positions[2],
+                    float *normals[2]) {
+  __m256 c0 = _mm256_setzero_ps();
+  __m256 c1 = _mm256_setzero_ps();
+  __m256 c2 = _mm256_setzero_ps();
+  __m256 c3 = _mm256_setzero_ps();
+  for (int k = 0; k < 4; ++k) {
+    float weight_a = a.weights[k];
+    float weight_b = b.weights[k];
+    if (weight_a == 0.0f && weight_b == 0.0f) {
+      continue;
+    }
+    const float *ma = palette + a.joints[k] * 16;
+    const float *mb = palette + b.joints[k] * 16;
+    __m256 w = Pair(_mm_set1_ps(weight_a), _mm_set1_ps(weight_b));
+    c0 = MulAdd(w, Pair(_mm_loadu_ps(ma), _mm_loadu_ps(mb)), c0);
+    c1 = MulAdd(w, Pair(_mm_loadu_ps(ma + 4), _mm_loadu_ps(mb + 4)), c1);
+    c2 = MulAdd(w, Pair(_mm_loadu_ps(ma + 8), _mm_loadu_ps(mb + 8)), c2);
+    c3 = MulAdd(w, Pair(_mm_loadu_ps(ma + 12), _mm_loadu_ps(mb + 12)), c3);
+  }
+  TransformVertex(_mm256_castps256_ps128(c0), _mm256_castps256_ps128(c1),
+                  _mm256_castps256_ps128(c2), _mm256_castps256_ps128(c3), a,
+                  positions[0], normals[0]);
+  TransformVertex(_mm256_extractf128_ps(c0, 1), _mm256_extractf128_ps(c1, 1),
+                  _mm256_extractf128_ps(c2, 1), _mm256_extractf128_ps(c3, 1),
+                  b, positions[1], normals[1]);
+}
+
+#endif  // __AVX2__
+
+}  // namespace
+
+namespace skinning_scalar {
+
+void SkinVertices(const glm::mat4 *palette,
+                  const SkinnedVertex *vertices,
+                  size_t count,
+                  const SkinTarget &target) {
+  const float *matrices = PaletteFloats(palette);
+  for (size_t i = 0; i < count; ++i) {
+    const SkinnedVertex &vertex = vertices[i];
+    // Only the upper 3x4 of the blended matrix is needed.
+    float m[16] = {};
+    for (int k = 0; k < 4; ++k) {
+      float weight = vertex.weights[k];
+      if (weight == 0.0f) {
+        continue;
+      }
+      const float *joint = matrices + vertex.joints[k] * 16;
+      for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 3; ++row) {
+          m[column * 4 + row] += weight * joint[column * 4 + row];
+        }
+      }
+    }
+    const float *p = vertex.position;
+    const float *n = vertex.normal;
+    float position[3];
+    float normal[3];
+    for (int row = 0; row < 3; ++row) {
+      position[row] = m[row] * p[0] + m[4 + row] * p[1] +
+                      (m[8 + row] * p[2] + m[12 + row]);
+      normal[row] = m[row] * n[0] + m[4 + row] * n[1] + m[8 + row] * n[2];
+    }
+    float length_squared =
+        normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2];
+    if (length_squared > 0.0f) {
+      float scale = 1.0f / std::sqrt(length_squared);
+      normal[0] *= scale;
+      normal[1] *= scale;
+      normal[2] *= scale;
+    }
+    std::memcpy(Advance(target.positions, target.stride, i), position,
+                sizeof(position));
+    std::memcpy(Advance(target.normals, target.stride, i), normal,
+                sizeof(normal));
+    if (target.uvs) {
+      std::memcpy(Advance(target.uvs, target.stride, i), vertex.uv,
+                  sizeof(vertex.uv));
+    }
+  }
+}
+
+}  // namespace skinning_scalar
+
+#if defined(BANDO_SKIN_SSE2)
+
+void SkinVertices(const glm::mat4 *palette,
+                  const SkinnedVertex *vertices,
+                  size_t count,
+                  const SkinTarget &target) {
+  const float *matrices = PaletteFloats(palette);
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 2 <= count; i += 2) {
+    float *positions[2] = {Advance(target.positions, target.stride, i),
+                           Advance(target.positions, target.stride, i + 1)};
+    float *normals[2] = {Advance(target.normals, target.stride, i),
+                         Advance(target.normals, target.stride, i + 1)};
+    SkinVertexPair(matrices, vertices[i], vertices[i + 1], positions,
+                   normals);
+    if (target.uvs) {
+      std::memcpy(Advance(target.uvs, target.stride, i), vertices[i].uv,
+                  sizeof(vertices[i].uv));
+      std::memcpy(Advance(target.uvs, target.stride, i + 1),
+                  vertices[i + 1].uv, sizeof(vertices[i + 1].uv));
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    SkinOneVertex(matrices, vertices[i],
+                  Advance(target.positions, target.stride, i),
+                  Advance(target.normals, target.stride, i));
+    if (target.uvs) {
+      std::memcpy(Advance(target.uvs, target.stride, i), vertices[i].uv,
+                  sizeof(vertices[i].uv));
+    }
+  }
+}
+
+#else
+
+void SkinVertices(const glm::mat4 *palette,
+                  const SkinnedVertex *vertices,
+                  size_t count,
+                  const SkinTarget &target) {
+  skinning_scalar::SkinVertices(palette, vertices, count, target);
+}
+
+#endif
+
+const char *SkinningIsa() {
+#if defined(__AVX2__) && defined(__FMA__)
+  return "avx2+fma";
+#elif defined(__AVX2__)
+  return "avx2";
+#elif defined(BANDO_SKIN_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+SkinnedCrowd::SkinnedCrowd(WorkerPool *pool) : pool_(pool) {}
+
+size_t SkinnedCrowd::AddCharacter(const Skeleton *skeleton,
+                                  const std::vector<SkinnedVertex> *vertices,
+                                  const AnimationClip *clip,
+                                  float start_time) {
+  Character character;
+  character.skeleton = skeleton;
+  character.vertices = vertices;
+  character.clip = clip;
+  character.time = start_time;
+  character.first_vertex = vertex_count_;
+  character.pose = skeleton->rest_pose;
+  character.world.resize(skeleton->joint_count());
+  character.palette.resize(skeleton->joint_count());
+  vertex_count_ += vertices->size();
+  characters_.push_back(std::move(character));
+  return characters_.size() - 1;
+}
+
+void SkinnedCrowd::AnimateCharacter(Character *character, float dt) {
+  const Skeleton &skeleton = *character->skeleton;
+  std::copy(skeleton.rest_pose.begin(), skeleton.rest_pose.end(),
+            character->pose.begin());
+  if (character->clip && character->clip->duration > 0.0f) {
+    float duration = character->clip->duration;
+    character->time = std::fmod(character->time + dt, duration);
+    if (character->time < 0.0f) {
+      character->time += duration;
+    }
+    SampleAnimation(*character->clip, character->time, &character->cursor,
+                    character->pose.data());
+  }
+  ComputeJointPalette(skeleton, character->pose.data(),
+                      character->world.data(), character->palette.data());
+}
+
+void SkinnedCrowd::Update(float dt, const SkinTarget &target) {
+  {
+    BANDO_PROFILE_ZONE("AnimateCrowd");
+    pool_->ParallelFor(characters_.size(), kCharactersPerRange,
+                       [this, dt](size_t begin, size_t end) {
+                         for (size_t i = begin; i < end; ++i) {
+                           AnimateCharacter(&characters_[i], dt);
+                         }
+                       });
+  }
+  BANDO_PROFILE_ZONE("SkinCrowd");
+  pool_->ParallelFor(
+      vertex_count_, kSkinChunk, [this, &target](size_t begin, size_t end) {
+        // Last character starting at or before `begin`; a range may span
+        // several small characters.
+        auto next = std::upper_bound(
+            characters_.begin(), characters_.end(), begin,
+            [](size_t vertex, const Character &character) {
+              return vertex < character.first_vertex;
+            });
+        size_t index = static_cast<size_t>(next - characters_.begin()) - 1;
+        while (begin < end && index < characters_.size()) {
+          const Character &character = characters_[index++];
+          size_t character_end =
+              character.first_vertex + character.vertices->size();
+          size_t stop = std::min(end, character_end);
+          if (stop <= begin) {
+            continue;
+          }
+          SkinVertices(character.palette.data(),
+                       character.vertices->data() +
+                           (begin - character.first_vertex),
+                       stop - begin, OffsetTarget(target, begin));
+          begin = stop;
+        }
+      });
+}
+
+}  // namespace bando
@@ -0,0 +1,116 @@
+#ifndef EXAMPLES_ANIMATION_SKINNING_H_
+#define EXAMPLES_ANIMATION_SKINNING_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "examples/animation/animation.h"
+#include "examples/jobs/worker_pool.h"
+
+// CPU linear blend skinning for many animated characters. Joint palettes
+// are computed per character in parallel, then every character's vertices
+// are skinned in fixed-size chunks across a WorkerPool, so one big
+// character and hundreds of small ones both spread over all threads.
+//
+// The vertex kernel blends the (up to four) influencing palette matrices
+// with SSE2, or two vertices at a time with AVX2/FMA when compiled with
+// --define=bando_avx2=1, and falls back to scalar code elsewhere. The
+// scalar version stays available in bando::skinning_scalar for
+// verification.
+
+namespace bando {
+
+// Bind-pose vertex with up to four joint influences whose weights sum to 1.
+struct SkinnedVertex {
+  float position[3];
+  float normal[3];
+  float uv[2];
+  uint16_t joints[4];
+  float weights[4];
+};
+
+// Strided destination of skinned vertices, e.g. interleaved vertex structs
+// in a mapped transfer buffer. Positions, normals and uvs are written as 3,
+// 3 and 2 floats at the given pointers, advancing by `stride` bytes per
+// vertex. Output is only written, front to back, which suits
+// write-combined memory.
+struct SkinTarget {
+  float *positions = nullptr;
+  float *normals = nullptr;
+  float *uvs = nullptr;
+  size_t stride = 0;
+};
+
+// Skins `count` vertices with `palette`, writing vertex i to entry i of
+// `target`. Every joint index must be valid for `palette`.
+void SkinVertices(const glm::mat4 *palette,
+                  const SkinnedVertex *vertices,
+                  size_t count,
+                  const SkinTarget &target);
+
+// Name of the instruction set SkinVertices was compiled for.
+const char *SkinningIsa();
+
+namespace skinning_scalar {
+
+void SkinVertices(const glm::mat4 *palette,
+                  const SkinnedVertex *vertices,
+                  size_t count,
+                  const SkinTarget &target);
+
+}  // namespace skinning_scalar
+
+// Animated characters sharing one output vertex range: character i's
+// vertices follow those of characters 0..i-1 in the target.
+class SkinnedCrowd {
+ public:
+  explicit SkinnedCrowd(WorkerPool *pool);
+
+  SkinnedCrowd(const SkinnedCrowd &) = delete;
+  SkinnedCrowd &operator=(const SkinnedCrowd &) = delete;
+
+  // Adds a character playing `clip` (looping, may be null) from
+  // `start_time` seconds. Everything passed in must outlive the crowd.
+  // Returns the character's index.
+  size_t AddCharacter(const Skeleton *skeleton,
+                      const std::vector<SkinnedVertex> *vertices,
+                      const AnimationClip *clip,
+                      float start_time);
+
+  size_t character_count() const { return characters_.size(); }
+  size_t vertex_count() const { return vertex_count_; }
+  size_t first_vertex(size_t character) const {
+    return characters_[character].first_vertex;
+  }
+
+  // Advances every character by `dt` seconds, samples its clip and
+  // computes its joint palette (in parallel across characters), then skins
+  // all vertex_count() vertices into `target`.
+  void Update(float dt, const SkinTarget &target);
+
+ private:
+  struct Character {
+    const Skeleton *skeleton = nullptr;
+    const std::vector<SkinnedVertex> *vertices = nullptr;
+    const AnimationClip *clip = nullptr;
+    float time = 0.0f;
+    size_t first_vertex = 0;
+    AnimationCursor cursor;
+    std::vector<JointTransform> pose;
+    std::vector<glm::mat4> world;
+    std::vector<glm::mat4> palette;
+  };
+
+  void AnimateCharacter(Character *character, float dt);
+
+  WorkerPool *pool_;
+  std::vector<Character> characters_;
+  size_t vertex_count_ = 0;
+};
+
+}  // namespace bando
+
+#endif  // EXAMPLES_ANIMATION_SKINNING_H_
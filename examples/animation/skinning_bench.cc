@@ -0,0 +1,376 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "examples/animation/animation.h"
+#include "examples/animation/skinning.h"
+#include "examples/bench/bench_harness.h"
+#include "examples/jobs/worker_pool.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Animation sampling and CPU skinning benchmarks. The SIMD kernel, the
+// keyframe cursors and the threaded crowd update are checked against their
+// scalar / single-threaded equivalents before any benchmark runs:
+//   bazel run -c opt //examples/animation:skinning_bench
+//   bazel run -c opt --define=bando_avx2=1 //examples/animation:skinning_bench
+
+namespace {
+
+constexpr int kJoints = 64;
+constexpr int kKeys = 120;
+constexpr float kClipSeconds = 4.0f;
+// Vertices of one benchmark character.
+constexpr size_t kCharacterVertices = 8192;
+
+// Binary tree of joints, each offset one unit from its parent.
+bando::Skeleton MakeSkeleton(int joint_count) {
+  bando::Skeleton skeleton;
+  skeleton.parents.resize(joint_count);
+  skeleton.rest_pose.resize(joint_count);
+  skeleton.inverse_bind.resize(joint_count);
+  skeleton.root_parents.assign(joint_count, glm::mat4(1.0f));
+  std::vector<glm::mat4> world(joint_count);
+  std::vector<glm::mat4> palette(joint_count);
+  for (int i = 0; i < joint_count; ++i) {
+    skeleton.parents[i] = i == 0 ? -1 : (i - 1) / 2;
+    skeleton.rest_pose[i].translation =
+        i == 0 ? glm::vec3(0.0f)
+               : glm::vec3(i % 2 == 0 ? 0.5f : -0.5f, 1.0f, 0.0f);
+    skeleton.inverse_bind[i] = glm::mat4(1.0f);
+  }
+  bando::ComputeJointPalette(skeleton, skeleton.rest_pose.data(),
+                             world.data(), palette.data());
+  for (int i = 0; i < joint_count; ++i) {
+    skeleton.inverse_bind[i] = glm::inverse(world[i]);
+  }
+  return skeleton;
+}
+
+// A rotation channel per joint plus root motion, all linearly
+// interpolated over evenly spaced keys.
+bando::AnimationClip MakeClip(int joint_count, int key_count) {
+  bando::AnimationClip clip;
+  clip.duration = kClipSeconds;
+  uint32_t random = 777u;
+  for (int joint = 0; joint < joint_count; ++joint) {
+    bando::AnimationChannel channel;
+    channel.joint = joint;
+    channel.path = bando::AnimationPath::kRotation;
+    glm::vec3 axis =
+        glm::normalize(glm::vec3(bando::NextRange(&random, 1.0f), 1.0f,
+                                 bando::NextRange(&random, 1.0f)));
+    for (int key = 0; key < key_count; ++key) {
+      float t = kClipSeconds * key / (key_count - 1);
+      glm::quat rotation =
+          glm::angleAxis(0.6f * std::sin(t * 2.0f + joint), axis);
+      channel.times.push_back(t);
+      channel.values.insert(channel.values.end(),
+                            {rotation.x, rotation.y, rotation.z,
+                             rotation.w});
+    }
+    clip.channels.push_back(std::move(channel));
+  }
+  bando::AnimationChannel root;
+  root.joint = 0;
+  root.path = bando::AnimationPath::kTranslation;
+  for (int key = 0; key < key_count; ++key) {
+    float t = kClipSeconds * key / (key_count - 1);
+    root.times.push_back(t);
+    root.values.insert(root.values.end(), {std::sin(t), 0.0f, t});
+  }
+  clip.channels.push_back(std::move(root));
+  return clip;
+}
+
+std::vector<bando::SkinnedVertex> MakeVertices(size_t count,
+                                               int joint_count,
+                                               uint32_t seed) {
+  std::vector<bando::SkinnedVertex> vertices(count);
+  uint32_t random = seed;
+  for (bando::SkinnedVertex &vertex : vertices) {
+    glm::vec3 normal =
+        glm::normalize(glm::vec3(bando::NextRange(&random, 1.0f),
+                                 bando::NextRange(&random, 1.0f), 1.0f));
+    for (int c = 0; c < 3; ++c) {
+      vertex.position[c] = bando::NextRange(&random, 4.0f);
+      vertex.normal[c] = normal[c];
+    }
+    vertex.uv[0] = bando::NextUnit(&random);
+    vertex.uv[1] = bando::NextUnit(&random);
+    // Mostly two or three influences, like typical character meshes.
+    int influences = 1 + static_cast<int>(bando::NextUnit(&random) * 4.0f) % 4;
+    float total = 0.0f;
+    for (int k = 0; k < 4; ++k) {
+      vertex.joints[k] = static_cast<uint16_t>(
+          static_cast<int>(bando::NextUnit(&random) * joint_count) %
+          joint_count);
+      vertex.weights[k] =
+          k < influences ? 0.1f + bando::NextUnit(&random) : 0.0f;
+      total += vertex.weights[k];
+    }
+    for (float &weight : vertex.weights) {
+      weight /= total;
+    }
+  }
+  return vertices;
+}
+
+// Interleaved like hello_3d's vertex buffer.
+struct OutputVertex {
+  float position[3];
+  float normal[3];
+  float uv[2];
+};
+
+bando::SkinTarget TargetFor(std::vector<OutputVertex> *out) {
+  OutputVertex *first = out->data();
+  bando::SkinTarget target;
+  target.positions = first->position;
+  target.normals = first->normal;
+  target.uvs = first->uv;
+  target.stride = sizeof(OutputVertex);
+  return target;
+}
+
+bool Near(float a, float b) {
+  return std::fabs(a - b) <= 1e-4f * std::fmax(1.0f, std::fabs(b));
+}
+
+bool SameVertex(const OutputVertex &a, const OutputVertex &b) {
+  for (int c = 0; c < 3; ++c) {
+    if (!Near(a.position[c], b.position[c]) ||
+        !Near(a.normal[c], b.normal[c])) {
+      return false;
+    }
+  }
+  return a.uv[0] == b.uv[0] && a.uv[1] == b.uv[1];
+}
+
+bool Verify() {
+  bool ok = true;
+  bando::Skeleton skeleton = MakeSkeleton(kJoints);
+  bando::AnimationClip clip = MakeClip(kJoints, kKeys);
+  // Odd count so the scalar tail after the vector loop is covered too.
+  std::vector<bando::SkinnedVertex> vertices =
+      MakeVertices(4099, kJoints, 99u);
+  std::vector<glm::mat4> world(kJoints);
+  std::vector<glm::mat4> palette(kJoints);
+
+  // The rest pose must reproduce the bind pose.
+  bando::ComputeJointPalette(skeleton, skeleton.rest_pose.data(),
+                             world.data(), palette.data());
+  std::vector<OutputVertex> simd(vertices.size());
+  bando::SkinVertices(palette.data(), vertices.data(), vertices.size(),
+                      TargetFor(&simd));
+  for (size_t i = 0; i < vertices.size() && ok; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      if (std::fabs(simd[i].position[c] - vertices[i].position[c]) > 1e-3f) {
+        std::printf("Rest pose moved vertex %zu\n", i);
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  // Forward playback with cursors matches a fresh binary search per
+  // sample, including across the loop point.
+  bando::AnimationCursor cursor;
+  std::vector<bando::JointTransform> tracked = skeleton.rest_pose;
+  std::vector<bando::JointTransform> searched = skeleton.rest_pose;
+  for (int frame = 0; frame < 600 && ok; ++frame) {
+    float time = std::fmod(frame * (1.0f / 60.0f) * 1.7f, kClipSeconds);
+    bando::SampleAnimation(clip, time, &cursor, tracked.data());
+    bando::AnimationCursor fresh;
+    bando::SampleAnimation(clip, time, &fresh, searched.data());
+    for (int joint = 0; joint < kJoints; ++joint) {
+      const glm::quat &a = tracked[joint].rotation;
+      const glm::quat &b = searched[joint].rotation;
+      if (a.x != b.x || a.y != b.y || a.z != b.z || a.w != b.w ||
+          tracked[joint].translation != searched[joint].translation) {
+        std::printf("Cursor sample mismatch at frame %d joint %d\n", frame,
+                    joint);
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  // SIMD kernel against the scalar reference on an animated pose.
+  bando::ComputeJointPalette(skeleton, tracked.data(), world.data(),
+                             palette.data());
+  std::vector<OutputVertex> scalar(vertices.size());
+  bando::SkinVertices(palette.data(), vertices.data(), vertices.size(),
+                      TargetFor(&simd));
+  bando::skinning_scalar::SkinVertices(palette.data(), vertices.data(),
+                                       vertices.size(), TargetFor(&scalar));
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    if (!SameVertex(simd[i], scalar[i])) {
+      std::printf("SkinVertices mismatch at %zu\n", i);
+      ok = false;
+      break;
+    }
+  }
+
+  // Threaded crowd update against characters skinned one at a time.
+  bando::WorkerPool pool(4);
+  bando::SkinnedCrowd crowd(&pool);
+  std::vector<std::vector<bando::SkinnedVertex>> meshes;
+  meshes.push_back(MakeVertices(5000, kJoints, 1u));
+  meshes.push_back(MakeVertices(3, kJoints, 2u));
+  meshes.push_back(std::vector<bando::SkinnedVertex>());
+  meshes.push_back(MakeVertices(2047, kJoints, 3u));
+  for (size_t i = 0; i < meshes.size(); ++i) {
+    crowd.AddCharacter(&skeleton, &meshes[i], &clip, 0.37f * i);
+  }
+  std::vector<OutputVertex> crowd_out(crowd.vertex_count());
+  crowd.Update(0.5f, TargetFor(&crowd_out));
+  for (size_t i = 0; i < meshes.size() && ok; ++i) {
+    std::vector<bando::JointTransform> pose = skeleton.rest_pose;
+    bando::AnimationCursor fresh;
+    bando::SampleAnimation(clip, 0.37f * i + 0.5f, &fresh, pose.data());
+    bando::ComputeJointPalette(skeleton, pose.data(), world.data(),
+                               palette.data());
+    std::vector<OutputVertex> expected(meshes[i].size());
+    if (expected.empty()) {
+      continue;
+    }
+    bando::skinning_scalar::SkinVertices(palette.data(), meshes[i].data(),
+                                         meshes[i].size(),
+                                         TargetFor(&expected));
+    for (size_t v = 0; v < expected.size(); ++v) {
+      if (!SameVertex(crowd_out[crowd.first_vertex(i) + v], expected[v])) {
+        std::printf("SkinnedCrowd mismatch in character %zu vertex %zu\n", i,
+                    v);
+        ok = false;
+        break;
+      }
+    }
+  }
+  return ok;
+}
+
+struct PosedCharacter {
+  std::vector<glm::mat4> palette;
+  std::vector<bando::SkinnedVertex> vertices;
+};
+
+PosedCharacter MakePosedCharacter(size_t vertex_count) {
+  bando::Skeleton skeleton = MakeSkeleton(kJoints);
+  bando::AnimationClip clip = MakeClip(kJoints, kKeys);
+  std::vector<bando::JointTransform> pose = skeleton.rest_pose;
+  bando::AnimationCursor cursor;
+  bando::SampleAnimation(clip, 1.3f, &cursor, pose.data());
+  std::vector<glm::mat4> world(kJoints);
+  PosedCharacter character;
+  character.palette.resize(kJoints);
+  bando::ComputeJointPalette(skeleton, pose.data(), world.data(),
+                             character.palette.data());
+  character.vertices = MakeVertices(vertex_count, kJoints, 5u);
+  return character;
+}
+
+void BM_SkinVertices_Scalar(benchmark::State &state) {
+  PosedCharacter character =
+      MakePosedCharacter(static_cast<size_t>(state.range(0)));
+  std::vector<OutputVertex> out(character.vertices.size());
+  bando::SkinTarget target = TargetFor(&out);
+  for (auto _ : state) {
+    bando::skinning_scalar::SkinVertices(character.palette.data(),
+                                         character.vertices.data(),
+                                         character.vertices.size(), target);
+    benchmark::DoNotOptimize(out.data());
+  }
+  bando::SetItemsProcessed(state, character.vertices.size());
+}
+
+void BM_SkinVertices_Simd(benchmark::State &state) {
+  PosedCharacter character =
+      MakePosedCharacter(static_cast<size_t>(state.range(0)));
+  std::vector<OutputVertex> out(character.vertices.size());
+  bando::SkinTarget target = TargetFor(&out);
+  for (auto _ : state) {
+    bando::SkinVertices(character.palette.data(), character.vertices.data(),
+                        character.vertices.size(), target);
+    benchmark::DoNotOptimize(out.data());
+  }
+  bando::SetItemsProcessed(state, character.vertices.size());
+}
+
+// Sampling at 60 Hz with cursors kept between frames, against binary
+// searching every channel on every sample.
+void BM_SampleAnimation_Cursor(benchmark::State &state) {
+  bando::Skeleton skeleton = MakeSkeleton(kJoints);
+  bando::AnimationClip clip =
+      MakeClip(kJoints, static_cast<int>(state.range(0)));
+  std::vector<bando::JointTransform> pose = skeleton.rest_pose;
+  bando::AnimationCursor cursor;
+  float time = 0.0f;
+  for (auto _ : state) {
+    time = std::fmod(time + 1.0f / 60.0f, kClipSeconds);
+    bando::SampleAnimation(clip, time, &cursor, pose.data());
+    benchmark::DoNotOptimize(pose.data());
+  }
+  bando::SetItemsProcessed(state, clip.channels.size());
+}
+
+void BM_SampleAnimation_Search(benchmark::State &state) {
+  bando::Skeleton skeleton = MakeSkeleton(kJoints);
+  bando::AnimationClip clip =
+      MakeClip(kJoints, static_cast<int>(state.range(0)));
+  std::vector<bando::JointTransform> pose = skeleton.rest_pose;
+  bando::AnimationCursor cursor;
+  float time = 0.0f;
+  for (auto _ : state) {
+    time = std::fmod(time + 1.0f / 60.0f, kClipSeconds);
+    // Keys far from the next sample force the binary search every time.
+    std::fill(cursor.keys.begin(), cursor.keys.end(), 0u);
+    bando::SampleAnimation(clip, time, &cursor, pose.data());
+    benchmark::DoNotOptimize(pose.data());
+  }
+  bando::SetItemsProcessed(state, clip.channels.size());
+}
+
+// Full per-frame update of range(0) characters on range(1) threads.
+void BM_SkinnedCrowd(benchmark::State &state) {
+  size_t characters = static_cast<size_t>(state.range(0));
+  bando::Skeleton skeleton = MakeSkeleton(kJoints);
+  bando::AnimationClip clip = MakeClip(kJoints, kKeys);
+  std::vector<bando::SkinnedVertex> vertices =
+      MakeVertices(kCharacterVertices, kJoints, 11u);
+  bando::WorkerPool pool(static_cast<int>(state.range(1)));
+  bando::SkinnedCrowd crowd(&pool);
+  for (size_t i = 0; i < characters; ++i) {
+    crowd.AddCharacter(&skeleton, &vertices, &clip, 0.01f * i);
+  }
+  std::vector<OutputVertex> out(crowd.vertex_count());
+  bando::SkinTarget target = TargetFor(&out);
+  for (auto _ : state) {
+    crowd.Update(1.0f / 60.0f, target);
+    benchmark::DoNotOptimize(out.data());
+  }
+  bando::SetItemsProcessed(state, crowd.vertex_count());
+  state.counters["threads"] = static_cast<double>(pool.thread_count());
+}
+
+BENCHMARK(BM_SkinVertices_Scalar)->RangeMultiplier(8)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_SkinVertices_Simd)->RangeMultiplier(8)->Range(1 << 10, 1 << 20);
+BENCHMARK(BM_SampleAnimation_Cursor)->Arg(30)->Arg(120)->Arg(1200);
+BENCHMARK(BM_SampleAnimation_Search)->Arg(30)->Arg(120)->Arg(1200);
+BENCHMARK(BM_SkinnedCrowd)
+    ->ArgsProduct({{1, 16, 128, 512}, {1, 0}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  return bando::RunVerifiedBenchmarks(
+      argc, argv, std::string("Skinning (") + bando::SkinningIsa() + ")",
+      Verify);
+}
@@ -0,0 +1,31 @@
+#include "examples/bench/bench_harness.h"
+
+#include <cstdint>
+#include <cstdio>
+
+namespace bando {
+
+void SetItemsProcessed(benchmark::State &state, size_t per_iteration) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(per_iteration));
+}
+
+int RunVerifiedBenchmarks(int argc,
+                          char **argv,
+                          const std::string &subject,
+                          const std::function<bool()> &verify) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  if (!verify()) {
+    std::printf("%s disagrees with the reference\n", subject.c_str());
+    return 1;
+  }
+  std::printf("%s matches the reference\n", subject.c_str());
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
+
+}  // namespace bando
@@ -0,0 +1,32 @@
+#ifndef EXAMPLES_BENCH_BENCH_HARNESS_H_
+#define EXAMPLES_BENCH_BENCH_HARNESS_H_
+
+#include <benchmark/benchmark.h>
+
+#include "examples/bench/random.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Shared pieces of the example benchmarks: the deterministic generator
+// from random.h, item counters, and a main that checks the optimized code
+// against its reference before timing anything.
+
+namespace bando {
+
+// Reports `per_iteration` items for every iteration the benchmark ran.
+void SetItemsProcessed(benchmark::State &state, size_t per_iteration);
+
+// Initializes google benchmark from the command line, runs `verify` and
+// prints "<subject> matches the reference" (or "disagrees with"), then runs
+// the registered benchmarks only when verification passed. Returns the
+// process exit code.
+int RunVerifiedBenchmarks(int argc,
+                          char **argv,
+                          const std::string &subject,
+                          const std::function<bool()> &verify);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_BENCH_BENCH_HARNESS_H_
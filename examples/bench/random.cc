@@ -0,0 +1,16 @@
+#include "examples/bench/random.h"
+
+namespace bando {
+
+float NextUnit(uint32_t *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return static_cast<float>(*state >> 8) / static_cast<float>(1u << 24);
+}
+
+float NextSigned(uint32_t *state) { return NextUnit(state) * 2.0f - 1.0f; }
+
+float NextRange(uint32_t *state, float extent) {
+  return NextSigned(state) * extent;
+}
+
+}  // namespace bando
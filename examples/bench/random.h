@@ -0,0 +1,22 @@
+#ifndef EXAMPLES_BENCH_RANDOM_H_
+#define EXAMPLES_BENCH_RANDOM_H_
+
+#include <cstdint>
+
+// Tiny deterministic generator for benchmark inputs and demo content, so
+// every run sees the same values.
+
+namespace bando {
+
+// Linear congruential generator; returns values in [0, 1).
+float NextUnit(uint32_t *state);
+
+// Same sequence mapped to [-1, 1).
+float NextSigned(uint32_t *state);
+
+// Same sequence mapped to [-extent, extent).
+float NextRange(uint32_t *state, float extent);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_BENCH_RANDOM_H_
@@ -0,0 +1,254 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "examples/bench/bench_harness.h"
+#include "examples/culling/occlusion_buffer.h"
+#include "examples/jobs/worker_pool.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Software occlusion culling benchmarks on a street-level view of a city
+// block grid. The SIMD/threaded rasterizer is checked against the scalar
+// reference, and every culled box against the reference depth, before any
+// benchmark runs:
+//   bazel run -c opt //examples/culling:occlusion_bench
+//   bazel run -c opt --define=bando_avx2=1 //examples/culling:occlusion_bench
+
+namespace {
+
+constexpr int kWidth = 320;
+constexpr int kHeight = 192;
+constexpr int kBlocks = 16;
+constexpr float kBlockSpacing = 20.0f;
+constexpr size_t kObjects = 20000;
+
+struct City {
+  glm::mat4 clip_from_world = glm::mat4(1.0f);
+  // One box mesh per building, all in world space.
+  std::vector<std::vector<glm::vec3>> building_positions;
+  std::vector<uint32_t> box_indices;
+  std::vector<bando::Occluder> occluders;
+  std::vector<bando::OcclusionBox> objects;
+};
+
+std::vector<glm::vec3> BoxCorners(const glm::vec3 &low, const glm::vec3 &high) {
+  std::vector<glm::vec3> corners(8);
+  for (int corner = 0; corner < 8; ++corner) {
+    corners[corner] = glm::vec3((corner & 1) ? high.x : low.x,
+                                (corner & 2) ? high.y : low.y,
+                                (corner & 4) ? high.z : low.z);
+  }
+  return corners;
+}
+
+// Street-level camera looking down a grid of buildings, with small props
+// scattered between them.
+void MakeCity(City *city) {
+  glm::mat4 projection = glm::perspectiveRH_ZO(
+      glm::radians(60.0f), static_cast<float>(kWidth) / kHeight, 0.5f,
+      1000.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(3.0f, 2.0f, -15.0f),
+                               glm::vec3(0.0f, 4.0f, 100.0f),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+  city->clip_from_world = projection * view;
+  city->box_indices = {0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6,
+                       0, 1, 4, 1, 5, 4, 2, 6, 3, 3, 6, 7,
+                       0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5};
+  uint32_t state = 5u;
+  for (int bx = 0; bx < kBlocks; ++bx) {
+    for (int bz = 0; bz < kBlocks; ++bz) {
+      float half = 4.0f + 3.0f * bando::NextUnit(&state);
+      float height = 10.0f + 50.0f * bando::NextUnit(&state);
+      glm::vec3 center((bx - kBlocks / 2) * kBlockSpacing, 0.0f,
+                       bz * kBlockSpacing + 10.0f);
+      city->building_positions.push_back(
+          BoxCorners(center - glm::vec3(half, 0.0f, half),
+                     center + glm::vec3(half, height, half)));
+    }
+  }
+  for (const std::vector<glm::vec3> &positions : city->building_positions) {
+    bando::Occluder occluder;
+    occluder.clip_from_object = city->clip_from_world;
+    occluder.positions = &positions[0].x;
+    occluder.stride = sizeof(glm::vec3);
+    occluder.vertex_count = positions.size();
+    occluder.indices = city->box_indices.data();
+    occluder.index_count = city->box_indices.size();
+    city->occluders.push_back(occluder);
+  }
+  for (size_t i = 0; i < kObjects; ++i) {
+    bando::OcclusionBox box;
+    box.clip_from_object = city->clip_from_world;
+    glm::vec3 position(
+        (bando::NextUnit(&state) - 0.5f) * kBlocks * kBlockSpacing,
+        3.0f * bando::NextUnit(&state),
+        bando::NextUnit(&state) * kBlocks * kBlockSpacing + 10.0f);
+    float size = 0.5f + 1.5f * bando::NextUnit(&state);
+    box.min = position;
+    box.max = position + glm::vec3(size);
+    city->objects.push_back(box);
+  }
+}
+
+void RasterizeCity(const City &city,
+                   bando::OcclusionBuffer *buffer,
+                   bando::WorkerPool *pool) {
+  buffer->Begin();
+  for (const bando::Occluder &occluder : city.occluders) {
+    buffer->AddOccluder(occluder);
+  }
+  buffer->Rasterize(pool);
+}
+
+// A culled box must lie behind the reference depth wherever a point of its
+// surface lands on screen.
+bool BoxIsHidden(const bando::OcclusionBox &box,
+                 const std::vector<float> &depth) {
+  constexpr int kSteps = 6;
+  for (int axis = 0; axis < 3; ++axis) {
+    for (int side = 0; side < 2; ++side) {
+      for (int u = 0; u <= kSteps; ++u) {
+        for (int v = 0; v <= kSteps; ++v) {
+          glm::vec3 t;
+          t[axis] = static_cast<float>(side);
+          t[(axis + 1) % 3] = static_cast<float>(u) / kSteps;
+          t[(axis + 2) % 3] = static_cast<float>(v) / kSteps;
+          glm::vec3 point = box.min + (box.max - box.min) * t;
+          glm::vec4 clip = box.clip_from_object * glm::vec4(point, 1.0f);
+          float x = (clip.x / clip.w * 0.5f + 0.5f) * kWidth;
+          float y = (0.5f - clip.y / clip.w * 0.5f) * kHeight;
+          int px = static_cast<int>(std::floor(x));
+          int py = static_cast<int>(std::floor(y));
+          if (px < 0 || py < 0 || px >= kWidth || py >= kHeight) {
+            continue;
+          }
+          if (clip.z / clip.w < depth[static_cast<size_t>(py) * kWidth + px] -
+                                    1e-5f) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+bool Verify() {
+  City city;
+  MakeCity(&city);
+  bando::WorkerPool pool(4);
+  bando::OcclusionBuffer threaded(kWidth, kHeight);
+  bando::OcclusionBuffer serial(kWidth, kHeight);
+  RasterizeCity(city, &threaded, &pool);
+  RasterizeCity(city, &serial, nullptr);
+  std::vector<float> reference;
+  bando::occlusion_scalar::RasterizeOccluders(
+      city.occluders.data(), city.occluders.size(), kWidth, kHeight,
+      &reference);
+
+  size_t covered = 0;
+  size_t coverage_mismatches = 0;
+  for (size_t i = 0; i < reference.size(); ++i) {
+    if (threaded.depth()[i] != serial.depth()[i]) {
+      std::printf("Threaded depth differs at pixel %zu\n", i);
+      return false;
+    }
+    bool ours = threaded.depth()[i] < 1.0f;
+    bool theirs = reference[i] < 1.0f;
+    covered += theirs ? 1 : 0;
+    if (ours != theirs) {
+      ++coverage_mismatches;
+    } else if (std::fabs(threaded.depth()[i] - reference[i]) > 1e-4f) {
+      std::printf("Depth at pixel %zu is %f, reference %f\n", i,
+                  threaded.depth()[i], reference[i]);
+      return false;
+    }
+  }
+  // Edge functions may round differently right on triangle edges.
+  if (covered == 0 || coverage_mismatches > reference.size() / 1000) {
+    std::printf("%zu of %zu pixels covered, %zu coverage mismatches\n",
+                covered, reference.size(), coverage_mismatches);
+    return false;
+  }
+
+  std::vector<uint8_t> visible(city.objects.size());
+  threaded.TestBoxes(city.objects.data(), city.objects.size(),
+                     visible.data(), &pool);
+  size_t culled = 0;
+  for (size_t i = 0; i < city.objects.size(); ++i) {
+    if (visible[i] != (serial.IsVisible(city.objects[i]) ? 1 : 0)) {
+      std::printf("Threaded box test differs for box %zu\n", i);
+      return false;
+    }
+    if (!visible[i]) {
+      ++culled;
+      if (!BoxIsHidden(city.objects[i], reference)) {
+        std::printf("Box %zu was culled but is visible\n", i);
+        return false;
+      }
+    }
+  }
+  if (culled == 0 || culled == city.objects.size()) {
+    std::printf("Culled %zu of %zu boxes\n", culled, city.objects.size());
+    return false;
+  }
+  std::printf("Culled %zu of %zu boxes behind %zu occluder triangles\n",
+              culled, city.objects.size(), threaded.triangle_count());
+  return true;
+}
+
+// Rasterizing every building on range(0) threads (0: all cores).
+void BM_RasterizeOccluders(benchmark::State &state) {
+  City city;
+  MakeCity(&city);
+  bando::WorkerPool pool(static_cast<int>(state.range(0)));
+  bando::OcclusionBuffer buffer(kWidth, kHeight);
+  for (auto _ : state) {
+    RasterizeCity(city, &buffer, &pool);
+    benchmark::DoNotOptimize(buffer.depth());
+  }
+  bando::SetItemsProcessed(state, buffer.triangle_count());
+  state.counters["threads"] = static_cast<double>(pool.thread_count());
+}
+
+void BM_TestBoxes(benchmark::State &state) {
+  City city;
+  MakeCity(&city);
+  bando::WorkerPool pool(static_cast<int>(state.range(0)));
+  bando::OcclusionBuffer buffer(kWidth, kHeight);
+  RasterizeCity(city, &buffer, &pool);
+  std::vector<uint8_t> visible(city.objects.size());
+  for (auto _ : state) {
+    buffer.TestBoxes(city.objects.data(), city.objects.size(),
+                     visible.data(), &pool);
+    benchmark::DoNotOptimize(visible.data());
+  }
+  bando::SetItemsProcessed(state, city.objects.size());
+  state.counters["threads"] = static_cast<double>(pool.thread_count());
+}
+
+BENCHMARK(BM_RasterizeOccluders)
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK(BM_TestBoxes)
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  return bando::RunVerifiedBenchmarks(
+      argc, argv,
+      std::string("Occlusion culling (") + bando::OcclusionIsa() + ")",
+      Verify);
+}
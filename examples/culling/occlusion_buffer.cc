@@ -0,0 +1,517 @@
+#include "examples/culling/occlusion_buffer.h"
+
+#include <meshoptimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "examples/profiling/profile_zones.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BANDO_OCCLUSION_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BANDO_OCCLUSION_SSE2 1
+#endif
+
+namespace bando {
+
+namespace {
+
+// Triangles set up per WorkerPool range.
+constexpr size_t kSetupChunk = 256;
+constexpr size_t kBoxChunk = 64;
+// Clip w below this counts as behind the eye.
+constexpr float kMinClipW = 1e-5f;
+
+// Screen position of an object space point: pixels with y down, depth in
+// [0, 1]. False when the point is in front of the near plane.
+bool ProjectPoint(const glm::mat4 &clip_from_object,
+                  const glm::vec3 &point,
+                  int width,
+                  int height,
+                  glm::vec3 *screen) {
+  glm::vec4 clip = clip_from_object * glm::vec4(point, 1.0f);
+  if (clip.w <= kMinClipW || clip.z < 0.0f) {
+    return false;
+  }
+  float inverse_w = 1.0f / clip.w;
+  screen->x = (clip.x * inverse_w * 0.5f + 0.5f) * static_cast<float>(width);
+  screen->y =
+      (0.5f - clip.y * inverse_w * 0.5f) * static_cast<float>(height);
+  screen->z = clip.z * inverse_w;
+  return true;
+}
+
+glm::vec3 OccluderPosition(const Occluder &occluder, uint32_t index) {
+  const unsigned char *bytes =
+      reinterpret_cast<const unsigned char *>(occluder.positions) +
+      occluder.stride * index;
+  float position[3];
+  std::memcpy(position, bytes, sizeof(position));
+  return glm::vec3(position[0], position[1], position[2]);
+}
+
+// Clamps a screen coordinate to [-1, size + 1] so it converts to int
+// safely. NaN becomes -1, as std::max returns its first argument then.
+float ClampToScreen(float value, int size) {
+  return std::min(std::max(-1.0f, value), static_cast<float>(size) + 1.0f);
+}
+
+// First and last pixel whose center lies in [low, high], clamped to
+// [0, size). Empty when first > last.
+void PixelSpan(float low, float high, int size, int *first, int *last) {
+  low = ClampToScreen(low, size);
+  high = ClampToScreen(high, size);
+  *first = std::max(0, static_cast<int>(std::ceil(low - 0.5f)));
+  *last = std::min(size - 1, static_cast<int>(std::floor(high - 0.5f)));
+}
+
+// Keeps the nearer depth for every pixel of row[x_begin, x_end] whose
+// center is inside all three edges. `edge_row` and `depth_row` hold the
+// edge functions and depth at x = 0 of this row's pixel centers.
+void FillRow(const float edge_a[3],
+             const float edge_row[3],
+             float depth_a,
+             float depth_row,
+             int x_begin,
+             int x_end,
+             float *row) {
+#if defined(__AVX2__)
+  const __m256 lanes =
+      _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+  const __m256 zero = _mm256_setzero_ps();
+  __m256 a0 = _mm256_set1_ps(edge_a[0]);
+  __m256 a1 = _mm256_set1_ps(edge_a[1]);
+  __m256 a2 = _mm256_set1_ps(edge_a[2]);
+  __m256 r0 = _mm256_set1_ps(edge_row[0]);
+  __m256 r1 = _mm256_set1_ps(edge_row[1]);
+  __m256 r2 = _mm256_set1_ps(edge_row[2]);
+  __m256 za = _mm256_set1_ps(depth_a);
+  __m256 zr = _mm256_set1_ps(depth_row);
+  // Rows are whole tiles wide, so aligned 8-pixel groups never leave them.
+  for (int x = x_begin & ~7; x <= x_end; x += 8) {
+    __m256 fx = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), lanes);
+    __m256 e0 = _mm256_add_ps(_mm256_mul_ps(a0, fx), r0);
+    __m256 e1 = _mm256_add_ps(_mm256_mul_ps(a1, fx), r1);
+    __m256 e2 = _mm256_add_ps(_mm256_mul_ps(a2, fx), r2);
+    __m256 inside = _mm256_and_ps(
+        _mm256_and_ps(_mm256_cmp_ps(e0, zero, _CMP_GE_OQ),
+                      _mm256_cmp_ps(e1, zero, _CMP_GE_OQ)),
+        _mm256_cmp_ps(e2, zero, _CMP_GE_OQ));
+    if (_mm256_movemask_ps(inside) == 0) {
+      continue;
+    }
+    __m256 z = _mm256_add_ps(_mm256_mul_ps(za, fx), zr);
+    __m256 old_depth = _mm256_loadu_ps(row + x);
+    __m256 nearer = _mm256_min_ps(old_depth, z);
+    _mm256_storeu_ps(row + x, _mm256_blendv_ps(old_depth, nearer, inside));
+  }
+#elif defined(BANDO_OCCLUSION_SSE2)
+  const __m128 lanes = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+  const __m128 zero = _mm_setzero_ps();
+  __m128 a0 = _mm_set1_ps(edge_a[0]);
+  __m128 a1 = _mm_set1_ps(edge_a[1]);
+  __m128 a2 = _mm_set1_ps(edge_a[2]);
+  __m128 r0 = _mm_set1_ps(edge_row[0]);
+  __m128 r1 = _mm_set1_ps(edge_row[1]);
+  __m128 r2 = _mm_set1_ps(edge_row[2]);
+  __m128 za = _mm_set1_ps(depth_a);
+  __m128 zr = _mm_set1_ps(depth_row);
+  for (int x = x_begin & ~3; x <= x_end; x += 4) {
+    __m128 fx = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), lanes);
+    __m128 e0 = _mm_add_ps(_mm_mul_ps(a0, fx), r0);
+    __m128 e1 = _mm_add_ps(_mm_mul_ps(a1, fx), r1);
+    __m128 e2 = _mm_add_ps(_mm_mul_ps(a2, fx), r2);
+    __m128 inside =
+        _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)),
+                   _mm_cmpge_ps(e2, zero));
+    if (_mm_movemask_ps(inside) == 0) {
+      continue;
+    }
+    __m128 z = _mm_add_ps(_mm_mul_ps(za, fx), zr);
+    __m128 old_depth = _mm_loadu_ps(row + x);
+    __m128 nearer = _mm_min_ps(old_depth, z);
+    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearer),
+                                     _mm_andnot_ps(inside, old_depth)));
+  }
+#else
+  for (int x = x_begin; x <= x_end; ++x) {
+    float fx = static_cast<float>(x) + 0.5f;
+    if (edge_a[0] * fx + edge_row[0] >= 0.0f &&
+        edge_a[1] * fx + edge_row[1] >= 0.0f &&
+        edge_a[2] * fx + edge_row[2] >= 0.0f) {
+      row[x] = std::min(row[x], depth_a * fx + depth_row);
+    }
+  }
+#endif
+}
+
+}  // namespace
+
+OcclusionBuffer::OcclusionBuffer(int width, int height)
+    : width_((std::max(width, 1) + kTileSize - 1) / kTileSize * kTileSize),
+      height_((std::max(height, 1) + kTileSize - 1) / kTileSize * kTileSize),
+      tiles_x_(width_ / kTileSize),
+      tiles_y_(height_ / kTileSize),
+      depth_(static_cast<size_t>(width_) * height_, 1.0f),
+      tile_max_(static_cast<size_t>(tiles_x_) * tiles_y_, 1.0f),
+      first_triangles_(1, 0) {}
+
+void OcclusionBuffer::Begin() {
+  occluders_.clear();
+  first_triangles_.assign(1, 0);
+  triangle_total_ = 0;
+}
+
+void OcclusionBuffer::AddOccluder(const Occluder &occluder) {
+  occluders_.push_back(occluder);
+  triangle_total_ += occluder.index_count / 3;
+  first_triangles_.push_back(triangle_total_);
+}
+
+void OcclusionBuffer::SetupTriangles(size_t begin, size_t end) {
+  // Occluder owning `begin`; later ones are reached by walking forward.
+  size_t occluder_index = static_cast<size_t>(
+      std::upper_bound(first_triangles_.begin(), first_triangles_.end(),
+                       begin) -
+      first_triangles_.begin() - 1);
+  for (size_t t = begin; t < end; ++t) {
+    while (t >= first_triangles_[occluder_index + 1]) {
+      ++occluder_index;
+    }
+    const Occluder &occluder = occluders_[occluder_index];
+    Triangle &triangle = triangles_[t];
+    triangle.valid = false;
+    const uint32_t *corner_indices =
+        occluder.indices + (t - first_triangles_[occluder_index]) * 3;
+    glm::vec3 v[3];
+    bool projected = true;
+    for (int k = 0; k < 3 && projected; ++k) {
+      projected = corner_indices[k] < occluder.vertex_count &&
+                  ProjectPoint(occluder.clip_from_object,
+                               OccluderPosition(occluder, corner_indices[k]),
+                               width_, height_, &v[k]);
+    }
+    if (!projected) {
+      continue;
+    }
+    float area2 = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                  (v[2].x - v[0].x) * (v[1].y - v[0].y);
+    // Occluders are drawn double-sided: flip clockwise triangles.
+    if (area2 < 0.0f) {
+      std::swap(v[1], v[2]);
+      area2 = -area2;
+    }
+    if (area2 < 1e-8f) {
+      continue;
+    }
+    PixelSpan(std::min({v[0].x, v[1].x, v[2].x}),
+              std::max({v[0].x, v[1].x, v[2].x}), width_, &triangle.min_x,
+              &triangle.max_x);
+    PixelSpan(std::min({v[0].y, v[1].y, v[2].y}),
+              std::max({v[0].y, v[1].y, v[2].y}), height_, &triangle.min_y,
+              &triangle.max_y);
+    if (triangle.min_x > triangle.max_x || triangle.min_y > triangle.max_y) {
+      continue;
+    }
+    // Edge k is opposite vertex k, so edge k / area2 is vertex k's
+    // barycentric weight and the depth plane follows directly.
+    float inverse_area2 = 1.0f / area2;
+    triangle.depth_a = 0.0f;
+    triangle.depth_b = 0.0f;
+    triangle.depth_c = 0.0f;
+    for (int k = 0; k < 3; ++k) {
+      const glm::vec3 &a = v[(k + 1) % 3];
+      const glm::vec3 &b = v[(k + 2) % 3];
+      triangle.edge_a[k] = a.y - b.y;
+      triangle.edge_b[k] = b.x - a.x;
+      triangle.edge_c[k] = a.x * b.y - a.y * b.x;
+      float weight = v[k].z * inverse_area2;
+      triangle.depth_a += triangle.edge_a[k] * weight;
+      triangle.depth_b += triangle.edge_b[k] * weight;
+      triangle.depth_c += triangle.edge_c[k] * weight;
+    }
+    triangle.valid = true;
+  }
+}
+
+void OcclusionBuffer::RasterizeTileRow(int tile_row) {
+  int y_begin = tile_row * kTileSize;
+  int y_end = y_begin + kTileSize;
+  std::fill(depth_.begin() + static_cast<size_t>(y_begin) * width_,
+            depth_.begin() + static_cast<size_t>(y_end) * width_, 1.0f);
+  for (uint32_t b = bin_offsets_[tile_row]; b < bin_offsets_[tile_row + 1];
+       ++b) {
+    const Triangle &triangle = triangles_[bins_[b]];
+    int first_y = std::max(triangle.min_y, y_begin);
+    int last_y = std::min(triangle.max_y, y_end - 1);
+    for (int y = first_y; y <= last_y; ++y) {
+      float fy = static_cast<float>(y) + 0.5f;
+      float edge_row[3];
+      for (int k = 0; k < 3; ++k) {
+        edge_row[k] = triangle.edge_b[k] * fy + triangle.edge_c[k];
+      }
+      FillRow(triangle.edge_a, edge_row, triangle.depth_a,
+              triangle.depth_b * fy + triangle.depth_c, triangle.min_x,
+              triangle.max_x, &depth_[static_cast<size_t>(y) * width_]);
+    }
+  }
+  for (int tile_x = 0; tile_x < tiles_x_; ++tile_x) {
+    float farthest = 0.0f;
+    for (int y = y_begin; y < y_end; ++y) {
+      const float *row =
+          &depth_[static_cast<size_t>(y) * width_ + tile_x * kTileSize];
+      for (int x = 0; x < kTileSize; ++x) {
+        farthest = std::max(farthest, row[x]);
+      }
+    }
+    tile_max_[static_cast<size_t>(tile_row) * tiles_x_ + tile_x] = farthest;
+  }
+}
+
+void OcclusionBuffer::Rasterize(WorkerPool *pool) {
+  BANDO_PROFILE_ZONE("RasterizeOccluders");
+  triangles_.resize(triangle_total_);
+  auto setup = [this](size_t begin, size_t end) {
+    SetupTriangles(begin, end);
+  };
+  if (pool) {
+    pool->ParallelFor(triangle_total_, kSetupChunk, setup);
+  } else {
+    setup(0, triangle_total_);
+  }
+
+  // Bin triangles by the tile rows they touch: count, prefix sum, fill.
+  bin_offsets_.assign(tiles_y_ + 1, 0);
+  for (const Triangle &triangle : triangles_) {
+    if (triangle.valid) {
+      for (int row = triangle.min_y / kTileSize;
+           row <= triangle.max_y / kTileSize; ++row) {
+        ++bin_offsets_[row + 1];
+      }
+    }
+  }
+  for (int row = 0; row < tiles_y_; ++row) {
+    bin_offsets_[row + 1] += bin_offsets_[row];
+  }
+  bins_.resize(bin_offsets_[tiles_y_]);
+  std::vector<uint32_t> fill(bin_offsets_.begin(), bin_offsets_.end() - 1);
+  for (size_t t = 0; t < triangles_.size(); ++t) {
+    const Triangle &triangle = triangles_[t];
+    if (triangle.valid) {
+      for (int row = triangle.min_y / kTileSize;
+           row <= triangle.max_y / kTileSize; ++row) {
+        bins_[fill[row]++] = static_cast<uint32_t>(t);
+      }
+    }
+  }
+
+  auto rows = [this](size_t begin, size_t end) {
+    for (size_t row = begin; row < end; ++row) {
+      RasterizeTileRow(static_cast<int>(row));
+    }
+  };
+  if (pool) {
+    pool->ParallelFor(static_cast<size_t>(tiles_y_), 1, rows);
+  } else {
+    rows(0, static_cast<size_t>(tiles_y_));
+  }
+}
+
+bool OcclusionBuffer::IsVisible(const OcclusionBox &box) const {
+  glm::vec3 low(0.0f);
+  glm::vec3 high(0.0f);
+  for (int corner = 0; corner < 8; ++corner) {
+    glm::vec3 point((corner & 1) ? box.max.x : box.min.x,
+                    (corner & 2) ? box.max.y : box.min.y,
+                    (corner & 4) ? box.max.z : box.min.z);
+    glm::vec3 screen;
+    if (!ProjectPoint(box.clip_from_object, point, width_, height_,
+                      &screen)) {
+      return true;
+    }
+    low = corner == 0 ? screen : glm::min(low, screen);
+    high = corner == 0 ? screen : glm::max(high, screen);
+  }
+  if (!std::isfinite(low.x) || !std::isfinite(low.y) ||
+      !std::isfinite(high.x) || !std::isfinite(high.y) || high.x < 0.0f ||
+      high.y < 0.0f || low.x > static_cast<float>(width_) ||
+      low.y > static_cast<float>(height_)) {
+    return true;
+  }
+  // Every pixel the rectangle touches, not just those whose centers it
+  // covers.
+  int first_x =
+      std::max(0, static_cast<int>(std::floor(ClampToScreen(low.x, width_))));
+  int last_x = std::min(
+      width_ - 1, static_cast<int>(std::floor(ClampToScreen(high.x, width_))));
+  int first_y =
+      std::max(0, static_cast<int>(std::floor(ClampToScreen(low.y, height_))));
+  int last_y = std::min(height_ - 1, static_cast<int>(std::floor(
+                                         ClampToScreen(high.y, height_))));
+  float nearest = low.z;
+  for (int tile_y = first_y / kTileSize; tile_y <= last_y / kTileSize;
+       ++tile_y) {
+    for (int tile_x = first_x / kTileSize; tile_x <= last_x / kTileSize;
+         ++tile_x) {
+      if (tile_max_[static_cast<size_t>(tile_y) * tiles_x_ + tile_x] <
+          nearest) {
+        continue;
+      }
+      int y_end = std::min(last_y, tile_y * kTileSize + kTileSize - 1);
+      int x_begin = std::max(first_x, tile_x * kTileSize);
+      int x_end = std::min(last_x, tile_x * kTileSize + kTileSize - 1);
+      for (int y = std::max(first_y, tile_y * kTileSize); y <= y_end; ++y) {
+        const float *row = &depth_[static_cast<size_t>(y) * width_];
+        for (int x = x_begin; x <= x_end; ++x) {
+          if (row[x] >= nearest) {
+            return true;
+          }
+        }
+      }
+    }
+  }
+  return false;
+}
+
+void OcclusionBuffer::TestBoxes(const OcclusionBox *boxes,
+                                size_t count,
+                                uint8_t *visible,
+                                WorkerPool *pool) const {
+  BANDO_PROFILE_ZONE("TestOcclusion");
+  auto test = [this, boxes, visible](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      visible[i] = IsVisible(boxes[i]) ? 1 : 0;
+    }
+  };
+  if (pool) {
+    pool->ParallelFor(count, kBoxChunk, test);
+  } else {
+    test(0, count);
+  }
+}
+
+const char *OcclusionIsa() {
+#if defined(__AVX2__)
+  return "avx2";
+#elif defined(BANDO_OCCLUSION_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+namespace occlusion_scalar {
+
+void RasterizeOccluders(const Occluder *occluders,
+                        size_t count,
+                        int width,
+                        int height,
+                        std::vector<float> *depth) {
+  depth->assign(static_cast<size_t>(width) * height, 1.0f);
+  for (size_t o = 0; o < count; ++o) {
+    const Occluder &occluder = occluders[o];
+    for (size_t i = 0; i + 2 < occluder.index_count; i += 3) {
+      glm::vec3 v[3];
+      bool projected = true;
+      for (int k = 0; k < 3 && projected; ++k) {
+        uint32_t index = occluder.indices[i + k];
+        projected = index < occluder.vertex_count &&
+                    ProjectPoint(occluder.clip_from_object,
+                                 OccluderPosition(occluder, index), width,
+                                 height, &v[k]);
+      }
+      if (!projected) {
+        continue;
+      }
+      float area2 = (v[1].x - v[0].x) * (v[2].y - v[0].y) -
+                    (v[2].x - v[0].x) * (v[1].y - v[0].y);
+      if (area2 < 0.0f) {
+        std::swap(v[1], v[2]);
+        area2 = -area2;
+      }
+      if (area2 < 1e-8f) {
+        continue;
+      }
+      for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+          glm::vec2 p(static_cast<float>(x) + 0.5f,
+                      static_cast<float>(y) + 0.5f);
+          float weights[3];
+          bool inside = true;
+          for (int k = 0; k < 3; ++k) {
+            const glm::vec3 &a = v[(k + 1) % 3];
+            const glm::vec3 &b = v[(k + 2) % 3];
+            weights[k] = (a.y - b.y) * p.x + (b.x - a.x) * p.y +
+                         (a.x * b.y - a.y * b.x);
+            inside = inside && weights[k] >= 0.0f;
+          }
+          if (!inside) {
+            continue;
+          }
+          float z = (weights[0] * v[0].z + weights[1] * v[1].z +
+                     weights[2] * v[2].z) /
+                    area2;
+          float &pixel = (*depth)[static_cast<size_t>(y) * width + x];
+          pixel = std::min(pixel, z);
+        }
+      }
+    }
+  }
+}
+
+}  // namespace occlusion_scalar
+
+bool BuildOccluderMesh(const float *positions,
+                       size_t vertex_count,
+                       size_t stride,
+                       const uint32_t *indices,
+                       size_t index_count,
+                       size_t max_triangles,
+                       std::vector<glm::vec3> *out_positions,
+                       std::vector<uint32_t> *out_indices) {
+  BANDO_PROFILE_ZONE("BuildOccluderMesh");
+  index_count -= index_count % 3;
+  for (size_t i = 0; i < index_count; ++i) {
+    if (indices[i] >= vertex_count) {
+      return false;
+    }
+  }
+  // Relative to the mesh extent; keeps the occluder close to the surface
+  // it stands in for even when that stops short of `max_triangles`.
+  constexpr float kTargetError = 0.01f;
+  std::vector<uint32_t> simplified(index_count);
+  size_t target = std::min(index_count, max_triangles * 3);
+  size_t simplified_count = index_count;
+  if (target < index_count) {
+    simplified_count = meshopt_simplify(
+        simplified.data(), indices, index_count, positions, vertex_count,
+        stride, target, kTargetError, 0, nullptr);
+  } else {
+    std::copy(indices, indices + index_count, simplified.begin());
+  }
+  simplified.resize(simplified_count);
+
+  std::vector<uint32_t> remap(vertex_count, ~0u);
+  out_positions->clear();
+  out_indices->resize(simplified.size());
+  for (size_t i = 0; i < simplified.size(); ++i) {
+    uint32_t &slot = remap[simplified[i]];
+    if (slot == ~0u) {
+      slot = static_cast<uint32_t>(out_positions->size());
+      const unsigned char *bytes =
+          reinterpret_cast<const unsigned char *>(positions) +
+          stride * simplified[i];
+      float position[3];
+      std::memcpy(position, bytes, sizeof(position));
+      out_positions->emplace_back(position[0], position[1], position[2]);
+    }
+    (*out_indices)[i] = slot;
+  }
+  return !out_indices->empty();
+}
+
+}  // namespace bando
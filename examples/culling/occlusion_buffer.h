@@ -0,0 +1,154 @@
+#ifndef EXAMPLES_CULLING_OCCLUSION_BUFFER_H_
+#define EXAMPLES_CULLING_OCCLUSION_BUFFER_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "examples/jobs/worker_pool.h"
+
+// Software occlusion culling. A few large occluders are rasterized into a
+// small CPU depth buffer every frame, then object bounding boxes are tested
+// against it so hidden objects never reach the GPU.
+//
+// Rasterize() transforms and sets up the queued occluder triangles in
+// parallel, bins them into rows of 8x8 tiles and fills each tile row on its
+// own WorkerPool range, so threads never share pixels. Edge functions and
+// depth are evaluated 4 pixels at a time with SSE2, or 8 with AVX2 when
+// compiled with --define=bando_avx2=1, with a scalar fallback kept in
+// bando::occlusion_scalar for verification. Each tile row then stores the
+// farthest depth of its tiles, the coarse level of the hierarchy that lets
+// most box tests finish without touching pixels.
+//
+// Depth follows the renderer's zero-to-one convention: 0 at the near plane,
+// 1 (the clear value) at the far plane. Triangles crossing the near plane
+// are dropped and boxes crossing it are reported visible, so culling stays
+// conservative without clipping.
+
+namespace bando {
+
+// Triangle mesh drawn into the buffer. Pointers must stay valid until
+// Rasterize() returns.
+struct Occluder {
+  glm::mat4 clip_from_object = glm::mat4(1.0f);
+  const float *positions = nullptr;
+  size_t stride = 3 * sizeof(float);
+  size_t vertex_count = 0;
+  const uint32_t *indices = nullptr;
+  size_t index_count = 0;
+};
+
+struct OcclusionBox {
+  glm::mat4 clip_from_object = glm::mat4(1.0f);
+  glm::vec3 min = glm::vec3(0.0f);
+  glm::vec3 max = glm::vec3(0.0f);
+};
+
+class OcclusionBuffer {
+ public:
+  static constexpr int kTileSize = 8;
+
+  // Dimensions are rounded up to whole tiles.
+  OcclusionBuffer(int width, int height);
+
+  OcclusionBuffer(const OcclusionBuffer &) = delete;
+  OcclusionBuffer &operator=(const OcclusionBuffer &) = delete;
+
+  int width() const { return width_; }
+  int height() const { return height_; }
+  const float *depth() const { return depth_.data(); }
+  // Farthest depth of every tile, row-major.
+  const float *tile_max_depth() const { return tile_max_.data(); }
+
+  // Drops the queued occluders.
+  void Begin();
+  void AddOccluder(const Occluder &occluder);
+  size_t triangle_count() const { return triangle_total_; }
+
+  // Clears the buffer and rasterizes every queued occluder. `pool` may be
+  // null.
+  void Rasterize(WorkerPool *pool);
+
+  // False only when every pixel the box covers holds an occluder nearer
+  // than the box's nearest point. Boxes outside the buffer are reported
+  // visible; frustum culling is the caller's job.
+  bool IsVisible(const OcclusionBox &box) const;
+
+  // IsVisible for `count` boxes across the pool, writing 0/1 to `visible`.
+  void TestBoxes(const OcclusionBox *boxes,
+                 size_t count,
+                 uint8_t *visible,
+                 WorkerPool *pool) const;
+
+ private:
+  struct Triangle {
+    // Edge functions A * x + B * y + C, non-negative inside.
+    float edge_a[3];
+    float edge_b[3];
+    float edge_c[3];
+    // Depth plane z = a * x + b * y + c.
+    float depth_a;
+    float depth_b;
+    float depth_c;
+    int min_x;
+    int max_x;
+    int min_y;
+    int max_y;
+    bool valid;
+  };
+
+  void SetupTriangles(size_t begin, size_t end);
+  void RasterizeTileRow(int tile_row);
+
+  int width_;
+  int height_;
+  int tiles_x_;
+  int tiles_y_;
+  std::vector<float> depth_;
+  std::vector<float> tile_max_;
+
+  std::vector<Occluder> occluders_;
+  // First triangle of each occluder, plus the total at the end.
+  std::vector<size_t> first_triangles_;
+  size_t triangle_total_ = 0;
+  std::vector<Triangle> triangles_;
+  // Triangles touching each tile row, back to back.
+  std::vector<uint32_t> bin_offsets_;
+  std::vector<uint32_t> bins_;
+};
+
+// Name of the instruction set the rasterizer was compiled for.
+const char *OcclusionIsa();
+
+namespace occlusion_scalar {
+
+// Per-pixel reference rasterizer writing the same depth as
+// OcclusionBuffer::Rasterize (up to rounding) into `depth`, a width x
+// height buffer cleared to 1.
+void RasterizeOccluders(const Occluder *occluders,
+                        size_t count,
+                        int width,
+                        int height,
+                        std::vector<float> *depth);
+
+}  // namespace occlusion_scalar
+
+// Builds a cheap occluder from a render mesh: simplifies it toward
+// `max_triangles` triangles with meshoptimizer, within a small error so it
+// does not grow past the original silhouette by much, and keeps only the
+// positions the result uses. Returns false for out of range indices or
+// when nothing is left.
+bool BuildOccluderMesh(const float *positions,
+                       size_t vertex_count,
+                       size_t stride,
+                       const uint32_t *indices,
+                       size_t index_count,
+                       size_t max_triangles,
+                       std::vector<glm::vec3> *out_positions,
+                       std::vector<uint32_t> *out_indices);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_CULLING_OCCLUSION_BUFFER_H_
@@ -0,0 +1,450 @@
+#include "examples/glm/soa_math.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BANDO_SOA_SSE2 1
+#endif
+
+namespace bando {
+
+namespace {
+
+// Lane wrappers so the culling and reduction kernels are written once for
+// every vector width.
+#if defined(__AVX2__)
+struct Lanes {
+  using V = __m256;
+  static constexpr size_t kWidth = 8;
+  static V Load(const float *p) { return _mm256_loadu_ps(p); }
+  static V Set1(float value) { return _mm256_set1_ps(value); }
+  static V MulAdd(V a, V b, V c) {
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+  }
+  static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+  static V Min(V a, V b) { return _mm256_min_ps(a, b); }
+  static V Max(V a, V b) { return _mm256_max_ps(a, b); }
+  static V GreaterEqual(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+  static V And(V a, V b) { return _mm256_and_ps(a, b); }
+  static V AllOnes() { return _mm256_castsi256_ps(_mm256_set1_epi32(-1)); }
+  static int MoveMask(V a) { return _mm256_movemask_ps(a); }
+  static void Store(float *p, V a) { _mm256_storeu_ps(p, a); }
+};
+#elif defined(BANDO_SOA_SSE2)
+struct Lanes {
+  using V = __m128;
+  static constexpr size_t kWidth = 4;
+  static V Load(const float *p) { return _mm_loadu_ps(p); }
+  static V Set1(float value) { return _mm_set1_ps(value); }
+  static V MulAdd(V a, V b, V c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+  static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+  static V Min(V a, V b) { return _mm_min_ps(a, b); }
+  static V Max(V a, V b) { return _mm_max_ps(a, b); }
+  static V GreaterEqual(V a, V b) { return _mm_cmpge_ps(a, b); }
+  static V And(V a, V b) { return _mm_and_ps(a, b); }
+  static V AllOnes() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+  static int MoveMask(V a) { return _mm_movemask_ps(a); }
+  static void Store(float *p, V a) { _mm_storeu_ps(p, a); }
+};
+#endif
+
+float PlaneDistance(const FrustumPlanes &frustum,
+                    int plane,
+                    float x,
+                    float y,
+                    float z) {
+  return frustum.a[plane] * x + frustum.b[plane] * y + frustum.c[plane] * z +
+         frustum.d[plane];
+}
+
+#if defined(__AVX2__) || defined(BANDO_SOA_SSE2)
+
+void StoreMask(int mask, uint8_t *visible) {
+  for (size_t lane = 0; lane < Lanes::kWidth; ++lane) {
+    visible[lane] = static_cast<uint8_t>((mask >> lane) & 1);
+  }
+}
+
+size_t CullSpheresSimd(const FrustumPlanes &frustum,
+                       const float *x,
+                       const float *y,
+                       const float *z,
+                       const float *radius,
+                       size_t count,
+                       uint8_t *visible) {
+  using V = Lanes::V;
+  V zero = Lanes::Set1(0.0f);
+  size_t i = 0;
+  for (; i + Lanes::kWidth <= count; i += Lanes::kWidth) {
+    V px = Lanes::Load(x + i);
+    V py = Lanes::Load(y + i);
+    V pz = Lanes::Load(z + i);
+    V neg_radius = Lanes::Sub(zero, Lanes::Load(radius + i));
+    V inside = Lanes::AllOnes();
+    for (int plane = 0; plane < 6; ++plane) {
+      V distance = Lanes::MulAdd(
+          Lanes::Set1(frustum.a[plane]), px,
+          Lanes::MulAdd(Lanes::Set1(frustum.b[plane]), py,
+                        Lanes::MulAdd(Lanes::Set1(frustum.c[plane]), pz,
+                                      Lanes::Set1(frustum.d[plane]))));
+      inside = Lanes::And(inside, Lanes::GreaterEqual(distance, neg_radius));
+    }
+    StoreMask(Lanes::MoveMask(inside), visible + i);
+  }
+  return i;
+}
+
+size_t CullAabbsSimd(const FrustumPlanes &frustum,
+                     const float *min_x,
+                     const float *min_y,
+                     const float *min_z,
+                     const float *max_x,
+                     const float *max_y,
+                     const float *max_z,
+                     size_t count,
+                     uint8_t *visible) {
+  using V = Lanes::V;
+  // The corner furthest along each plane normal only depends on the plane,
+  // so the per-plane array choice is hoisted out of the object loop.
+  const float *px[6];
+  const float *py[6];
+  const float *pz[6];
+  for (int plane = 0; plane < 6; ++plane) {
+    px[plane] = frustum.a[plane] >= 0.0f ? max_x : min_x;
+    py[plane] = frustum.b[plane] >= 0.0f ? max_y : min_y;
+    pz[plane] = frustum.c[plane] >= 0.0f ? max_z : min_z;
+  }
+  V zero = Lanes::Set1(0.0f);
+  size_t i = 0;
+  for (; i + Lanes::kWidth <= count; i += Lanes::kWidth) {
+    V inside = Lanes::AllOnes();
+    for (int plane = 0; plane < 6; ++plane) {
+      V distance = Lanes::MulAdd(
+          Lanes::Set1(frustum.a[plane]), Lanes::Load(px[plane] + i),
+          Lanes::MulAdd(Lanes::Set1(frustum.b[plane]),
+                        Lanes::Load(py[plane] + i),
+                        Lanes::MulAdd(Lanes::Set1(frustum.c[plane]),
+                                      Lanes::Load(pz[plane] + i),
+                                      Lanes::Set1(frustum.d[plane]))));
+      inside = Lanes::And(inside, Lanes::GreaterEqual(distance, zero));
+    }
+    StoreMask(Lanes::MoveMask(inside), visible + i);
+  }
+  return i;
+}
+
+size_t ReduceAabbSimd(const float *x,
+                      const float *y,
+                      const float *z,
+                      size_t count,
+                      float min_out[3],
+                      float max_out[3]) {
+  using V = Lanes::V;
+  if (count < Lanes::kWidth) {
+    return 0;
+  }
+  V min_x = Lanes::Load(x);
+  V min_y = Lanes::Load(y);
+  V min_z = Lanes::Load(z);
+  V max_x = min_x;
+  V max_y = min_y;
+  V max_z = min_z;
+  size_t i = Lanes::kWidth;
+  for (; i + Lanes::kWidth <= count; i += Lanes::kWidth) {
+    V vx = Lanes::Load(x + i);
+    V vy = Lanes::Load(y + i);
+    V vz = Lanes::Load(z + i);
+    min_x = Lanes::Min(min_x, vx);
+    min_y = Lanes::Min(min_y, vy);
+    min_z = Lanes::Min(min_z, vz);
+    max_x = Lanes::Max(max_x, vx);
+    max_y = Lanes::Max(max_y, vy);
+    max_z = Lanes::Max(max_z, vz);
+  }
+  float lanes[6][Lanes::kWidth];
+  Lanes::Store(lanes[0], min_x);
+  Lanes::Store(lanes[1], min_y);
+  Lanes::Store(lanes[2], min_z);
+  Lanes::Store(lanes[3], max_x);
+  Lanes::Store(lanes[4], max_y);
+  Lanes::Store(lanes[5], max_z);
+  for (int axis = 0; axis < 3; ++axis) {
+    min_out[axis] =
+        *std::min_element(lanes[axis], lanes[axis] + Lanes::kWidth);
+    max_out[axis] =
+        *std::max_element(lanes[axis + 3], lanes[axis + 3] + Lanes::kWidth);
+  }
+  return i;
+}
+
+#endif  // __AVX2__ || BANDO_SOA_SSE2
+
+}  // namespace
+
+FrustumPlanes ExtractFrustumPlanes(const float *view_projection,
+                                   bool zero_to_one) {
+  // Row r of a column-major matrix is (m[r], m[4 + r], m[8 + r], m[12 + r]).
+  auto row = [view_projection](int r, int c) {
+    return view_projection[c * 4 + r];
+  };
+  FrustumPlanes frustum = {};
+  for (int plane = 0; plane < 6; ++plane) {
+    int axis = plane / 2;
+    float sign = (plane % 2 == 0) ? 1.0f : -1.0f;
+    float values[4];
+    for (int c = 0; c < 4; ++c) {
+      if (plane == 4 && zero_to_one) {
+        values[c] = row(2, c);
+      } else {
+        values[c] = row(3, c) + sign * row(axis, c);
+      }
+    }
+    float length = std::sqrt(values[0] * values[0] + values[1] * values[1] +
+                             values[2] * values[2]);
+    float scale = length > 0.0f ? 1.0f / length : 0.0f;
+    frustum.a[plane] = values[0] * scale;
+    frustum.b[plane] = values[1] * scale;
+    frustum.c[plane] = values[2] * scale;
+    frustum.d[plane] = values[3] * scale;
+  }
+  return frustum;
+}
+
+namespace soa_scalar {
+
+void MultiplyMat4Batch(const float *left,
+                       const float *right,
+                       size_t count,
+                       float *out) {
+  for (size_t i = 0; i < count; ++i) {
+    const float *r = right + i * 16;
+    float *o = out + i * 16;
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        o[column * 4 + row] = left[row] * r[column * 4] +
+                              left[4 + row] * r[column * 4 + 1] +
+                              left[8 + row] * r[column * 4 + 2] +
+                              left[12 + row] * r[column * 4 + 3];
+      }
+    }
+  }
+}
+
+void CullSpheres(const FrustumPlanes &frustum,
+                 const float *x,
+                 const float *y,
+                 const float *z,
+                 const float *radius,
+                 size_t count,
+                 uint8_t *visible) {
+  for (size_t i = 0; i < count; ++i) {
+    uint8_t inside = 1;
+    for (int plane = 0; plane < 6; ++plane) {
+      if (PlaneDistance(frustum, plane, x[i], y[i], z[i]) < -radius[i]) {
+        inside = 0;
+        break;
+      }
+    }
+    visible[i] = inside;
+  }
+}
+
+void CullAabbs(const FrustumPlanes &frustum,
+               const float *min_x,
+               const float *min_y,
+               const float *min_z,
+               const float *max_x,
+               const float *max_y,
+               const float *max_z,
+               size_t count,
+               uint8_t *visible) {
+  for (size_t i = 0; i < count; ++i) {
+    uint8_t inside = 1;
+    for (int plane = 0; plane < 6; ++plane) {
+      float px = frustum.a[plane] >= 0.0f ? max_x[i] : min_x[i];
+      float py = frustum.b[plane] >= 0.0f ? max_y[i] : min_y[i];
+      float pz = frustum.c[plane] >= 0.0f ? max_z[i] : min_z[i];
+      if (PlaneDistance(frustum, plane, px, py, pz) < 0.0f) {
+        inside = 0;
+        break;
+      }
+    }
+    visible[i] = inside;
+  }
+}
+
+void ReduceAabb(const float *x,
+                const float *y,
+                const float *z,
+                size_t count,
+                float min_out[3],
+                float max_out[3]) {
+  if (count == 0) {
+    return;
+  }
+  float lo[3] = {x[0], y[0], z[0]};
+  float hi[3] = {x[0], y[0], z[0]};
+  for (size_t i = 1; i < count; ++i) {
+    lo[0] = std::min(lo[0], x[i]);
+    lo[1] = std::min(lo[1], y[i]);
+    lo[2] = std::min(lo[2], z[i]);
+    hi[0] = std::max(hi[0], x[i]);
+    hi[1] = std::max(hi[1], y[i]);
+    hi[2] = std::max(hi[2], z[i]);
+  }
+  for (int axis = 0; axis < 3; ++axis) {
+    min_out[axis] = lo[axis];
+    max_out[axis] = hi[axis];
+  }
+}
+
+}  // namespace soa_scalar
+
+#if defined(__AVX2__)
+
+void MultiplyMat4Batch(const float *left,
+                       const float *right,
+                       size_t count,
+                       float *out) {
+  // Each 256-bit register holds two columns of the right-hand matrix; the
+  // left-hand columns are duplicated into both halves so one in-lane
+  // permute per term broadcasts the matching right-hand element.
+  __m256 l0 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(left));
+  __m256 l1 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(left + 4));
+  __m256 l2 = _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(left + 8));
+  __m256 l3 =
+      _mm256_broadcast_ps(reinterpret_cast<const __m128 *>(left + 12));
+  for (size_t i = 0; i < count; ++i) {
+    const float *r = right + i * 16;
+    float *o = out + i * 16;
+    for (int half = 0; half < 2; ++half) {
+      __m256 columns = _mm256_loadu_ps(r + half * 8);
+      __m256 result = _mm256_mul_ps(
+          l0, _mm256_permute_ps(columns, _MM_SHUFFLE(0, 0, 0, 0)));
+      result = Lanes::MulAdd(
+          l1, _mm256_permute_ps(columns, _MM_SHUFFLE(1, 1, 1, 1)), result);
+      result = Lanes::MulAdd(
+          l2, _mm256_permute_ps(columns, _MM_SHUFFLE(2, 2, 2, 2)), result);
+      result = Lanes::MulAdd(
+          l3, _mm256_permute_ps(columns, _MM_SHUFFLE(3, 3, 3, 3)), result);
+      _mm256_storeu_ps(o + half * 8, result);
+    }
+  }
+}
+
+#elif defined(BANDO_SOA_SSE2)
+
+void MultiplyMat4Batch(const float *left,
+                       const float *right,
+                       size_t count,
+                       float *out) {
+  __m128 l0 = _mm_loadu_ps(left);
+  __m128 l1 = _mm_loadu_ps(left + 4);
+  __m128 l2 = _mm_loadu_ps(left + 8);
+  __m128 l3 = _mm_loadu_ps(left + 12);
+  for (size_t i = 0; i < count; ++i) {
+    const float *r = right + i * 16;
+    float *o = out + i * 16;
+    for (int column = 0; column < 4; ++column) {
+      const float *c = r + column * 4;
+      __m128 result = _mm_mul_ps(l0, _mm_set1_ps(c[0]));
+      result = _mm_add_ps(result, _mm_mul_ps(l1, _mm_set1_ps(c[1])));
+      result = _mm_add_ps(result, _mm_mul_ps(l2, _mm_set1_ps(c[2])));
+      result = _mm_add_ps(result, _mm_mul_ps(l3, _mm_set1_ps(c[3])));
+      _mm_storeu_ps(o + column * 4, result);
+    }
+  }
+}
+
+#else
+
+void MultiplyMat4Batch(const float *left,
+                       const float *right,
+                       size_t count,
+                       float *out) {
+  soa_scalar::MultiplyMat4Batch(left, right, count, out);
+}
+
+#endif
+
+void CullSpheres(const FrustumPlanes &frustum,
+                 const float *x,
+                 const float *y,
+                 const float *z,
+                 const float *radius,
+                 size_t count,
+                 uint8_t *visible) {
+  size_t done = 0;
+#if defined(__AVX2__) || defined(BANDO_SOA_SSE2)
+  done = CullSpheresSimd(frustum, x, y, z, radius, count, visible);
+#endif
+  soa_scalar::CullSpheres(frustum, x + done, y + done, z + done, radius + done,
+                          count - done, visible + done);
+}
+
+void CullAabbs(const FrustumPlanes &frustum,
+               const float *min_x,
+               const float *min_y,
+               const float *min_z,
+               const float *max_x,
+               const float *max_y,
+               const float *max_z,
+               size_t count,
+               uint8_t *visible) {
+  size_t done = 0;
+#if defined(__AVX2__) || defined(BANDO_SOA_SSE2)
+  done = CullAabbsSimd(frustum, min_x, min_y, min_z, max_x, max_y, max_z,
+                       count, visible);
+#endif
+  soa_scalar::CullAabbs(frustum, min_x + done, min_y + done, min_z + done,
+                        max_x + done, max_y + done, max_z + done,
+                        count - done, visible + done);
+}
+
+void ReduceAabb(const float *x,
+                const float *y,
+                const float *z,
+                size_t count,
+                float min_out[3],
+                float max_out[3]) {
+  size_t done = 0;
+#if defined(__AVX2__) || defined(BANDO_SOA_SSE2)
+  done = ReduceAabbSimd(x, y, z, count, min_out, max_out);
+#endif
+  if (done == 0) {
+    soa_scalar::ReduceAabb(x, y, z, count, min_out, max_out);
+    return;
+  }
+  float tail_min[3];
+  float tail_max[3];
+  if (done < count) {
+    soa_scalar::ReduceAabb(x + done, y + done, z + done, count - done,
+                           tail_min, tail_max);
+    for (int axis = 0; axis < 3; ++axis) {
+      min_out[axis] = std::min(min_out[axis], tail_min[axis]);
+      max_out[axis] = std::max(max_out[axis], tail_max[axis]);
+    }
+  }
+}
+
+const char *SoaMathIsa() {
+#if defined(__AVX2__) && defined(__FMA__)
+  return "avx2+fma";
+#elif defined(__AVX2__)
+  return "avx2";
+#elif defined(BANDO_SOA_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+}  // namespace bando
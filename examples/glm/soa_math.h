@@ -0,0 +1,111 @@
+#ifndef EXAMPLES_GLM_SOA_MATH_H_
+#define EXAMPLES_GLM_SOA_MATH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Batched math kernels for per-object work that does not vectorize well
+// through scalar glm calls: matrix products, frustum tests and bounds
+// reductions over thousands of objects.
+//
+// Matrices are 16 floats in column-major order, the same layout as
+// glm::mat4, so glm::value_ptr / reinterpret_cast of a glm::mat4 array can
+// be passed directly. Object data is struct-of-arrays: one array per
+// component.
+//
+// The kernels use AVX2/FMA when compiled with them (--define=bando_avx2=1 on
+// //examples/glm:soa_math), SSE2 on other x86-64 builds and scalar code
+// everywhere else. The scalar reference versions stay available in
+// bando::soa_scalar for verification.
+
+namespace bando {
+
+// Six normalized planes (a, b, c, d) with a*x + b*y + c*z + d >= 0 inside.
+// Order: left, right, bottom, top, near, far.
+struct FrustumPlanes {
+  float a[6];
+  float b[6];
+  float c[6];
+  float d[6];
+};
+
+// Extracts the frustum planes of a view-projection matrix. `zero_to_one`
+// selects a [0, 1] clip-space depth range (Vulkan/SDL_GPU, glm *_ZO) instead
+// of OpenGL's [-1, 1].
+FrustumPlanes ExtractFrustumPlanes(const float *view_projection,
+                                   bool zero_to_one);
+
+// out[i] = left * right[i] for `count` matrices. `out` must not alias
+// `right`.
+void MultiplyMat4Batch(const float *left,
+                       const float *right,
+                       size_t count,
+                       float *out);
+
+// visible[i] = 1 when the sphere (x, y, z, radius) is at least partly inside
+// the frustum, 0 otherwise.
+void CullSpheres(const FrustumPlanes &frustum,
+                 const float *x,
+                 const float *y,
+                 const float *z,
+                 const float *radius,
+                 size_t count,
+                 uint8_t *visible);
+
+// visible[i] = 1 unless the box lies completely outside one of the planes.
+void CullAabbs(const FrustumPlanes &frustum,
+               const float *min_x,
+               const float *min_y,
+               const float *min_z,
+               const float *max_x,
+               const float *max_y,
+               const float *max_z,
+               size_t count,
+               uint8_t *visible);
+
+// Component-wise min/max of `count` points. Leaves the outputs untouched
+// when `count` is 0.
+void ReduceAabb(const float *x,
+                const float *y,
+                const float *z,
+                size_t count,
+                float min_out[3],
+                float max_out[3]);
+
+// Name of the instruction set the kernels were compiled for.
+const char *SoaMathIsa();
+
+namespace soa_scalar {
+
+void MultiplyMat4Batch(const float *left,
+                       const float *right,
+                       size_t count,
+                       float *out);
+void CullSpheres(const FrustumPlanes &frustum,
+                 const float *x,
+                 const float *y,
+                 const float *z,
+                 const float *radius,
+                 size_t count,
+                 uint8_t *visible);
+void CullAabbs(const FrustumPlanes &frustum,
+               const float *min_x,
+               const float *min_y,
+               const float *min_z,
+               const float *max_x,
+               const float *max_y,
+               const float *max_z,
+               size_t count,
+               uint8_t *visible);
+void ReduceAabb(const float *x,
+                const float *y,
+                const float *z,
+                size_t count,
+                float min_out[3],
+                float max_out[3]);
+
+}  // namespace soa_scalar
+
+}  // namespace bando
+
+#endif  // EXAMPLES_GLM_SOA_MATH_H_
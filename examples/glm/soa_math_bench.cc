@@ -0,0 +1,347 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "examples/bench/bench_harness.h"
+#include "examples/glm/soa_math.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Compares the batched kernels against the per-object glm code they
+// replace. The kernels are checked against glm before any benchmark runs:
+//   bazel run -c opt //examples/glm:soa_math_bench
+//   bazel run -c opt --define=bando_avx2=1 //examples/glm:soa_math_bench
+
+namespace {
+
+constexpr float kWorldExtent = 500.0f;
+
+struct Scene {
+  glm::mat4 view_projection;
+  bando::FrustumPlanes frustum;
+  std::vector<glm::mat4> models;
+  // Bounding spheres and boxes in SoA form.
+  std::vector<float> x, y, z, radius;
+  std::vector<float> min_x, min_y, min_z, max_x, max_y, max_z;
+  // The same data as glm objects, laid out like per-object scene data.
+  std::vector<glm::vec4> spheres;
+  std::vector<glm::vec3> box_min, box_max;
+};
+
+Scene MakeScene(size_t count) {
+  Scene scene;
+  glm::mat4 projection =
+      glm::perspectiveRH_ZO(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+  glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 20.0f, 0.0f),
+                               glm::vec3(100.0f, 0.0f, 100.0f),
+                               glm::vec3(0.0f, 1.0f, 0.0f));
+  scene.view_projection = projection * view;
+  scene.frustum =
+      bando::ExtractFrustumPlanes(glm::value_ptr(scene.view_projection), true);
+  uint32_t random = 12345u;
+  for (size_t i = 0; i < count; ++i) {
+    glm::vec3 center(bando::NextRange(&random, kWorldExtent),
+                     bando::NextRange(&random, 50.0f),
+                     bando::NextRange(&random, kWorldExtent));
+    float size = 0.5f + bando::NextUnit(&random) * 4.0f;
+    glm::vec3 extent(size, size * 0.5f, size * 0.75f);
+    float angle = bando::NextUnit(&random) * 6.28f;
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), center) *
+                      glm::rotate(glm::mat4(1.0f), angle,
+                                  glm::vec3(0.0f, 1.0f, 0.0f));
+    scene.models.push_back(model);
+    scene.x.push_back(center.x);
+    scene.y.push_back(center.y);
+    scene.z.push_back(center.z);
+    scene.radius.push_back(glm::length(extent));
+    scene.spheres.push_back(glm::vec4(center, glm::length(extent)));
+    scene.min_x.push_back(center.x - extent.x);
+    scene.min_y.push_back(center.y - extent.y);
+    scene.min_z.push_back(center.z - extent.z);
+    scene.max_x.push_back(center.x + extent.x);
+    scene.max_y.push_back(center.y + extent.y);
+    scene.max_z.push_back(center.z + extent.z);
+    scene.box_min.push_back(center - extent);
+    scene.box_max.push_back(center + extent);
+  }
+  return scene;
+}
+
+glm::vec4 Plane(const bando::FrustumPlanes &frustum, int plane) {
+  return glm::vec4(frustum.a[plane], frustum.b[plane], frustum.c[plane],
+                   frustum.d[plane]);
+}
+
+// Per-object glm reference implementations.
+bool SphereVisibleGlm(const glm::vec4 *planes, const glm::vec4 &sphere) {
+  for (int plane = 0; plane < 6; ++plane) {
+    if (glm::dot(planes[plane], glm::vec4(glm::vec3(sphere), 1.0f)) <
+        -sphere.w) {
+      return false;
+    }
+  }
+  return true;
+}
+
+float BoxDistance(const glm::vec4 &plane,
+                  const glm::vec3 &box_min,
+                  const glm::vec3 &box_max) {
+  glm::vec3 normal(plane);
+  glm::vec3 corner(normal.x >= 0.0f ? box_max.x : box_min.x,
+                   normal.y >= 0.0f ? box_max.y : box_min.y,
+                   normal.z >= 0.0f ? box_max.z : box_min.z);
+  return glm::dot(normal, corner) + plane.w;
+}
+
+bool BoxVisibleGlm(const glm::vec4 *planes,
+                   const glm::vec3 &box_min,
+                   const glm::vec3 &box_max) {
+  for (int plane = 0; plane < 6; ++plane) {
+    if (BoxDistance(planes[plane], box_min, box_max) < 0.0f) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Smallest absolute plane distance of a test, used to ignore mismatches
+// that only come from rounding right at a plane.
+float SphereMargin(const glm::vec4 *planes, const glm::vec4 &sphere) {
+  float margin = INFINITY;
+  for (int plane = 0; plane < 6; ++plane) {
+    float distance =
+        glm::dot(planes[plane], glm::vec4(glm::vec3(sphere), 1.0f)) + sphere.w;
+    margin = std::fmin(margin, std::fabs(distance));
+  }
+  return margin;
+}
+
+float BoxMargin(const glm::vec4 *planes,
+                const glm::vec3 &box_min,
+                const glm::vec3 &box_max) {
+  float margin = INFINITY;
+  for (int plane = 0; plane < 6; ++plane) {
+    margin = std::fmin(margin,
+                       std::fabs(BoxDistance(planes[plane], box_min, box_max)));
+  }
+  return margin;
+}
+
+bool VerifyAgainstGlm() {
+  // Odd count so the scalar tail after the vector loops is covered too.
+  Scene scene = MakeScene(4099);
+  const size_t count = scene.models.size();
+  glm::vec4 planes[6];
+  for (int plane = 0; plane < 6; ++plane) {
+    planes[plane] = Plane(scene.frustum, plane);
+  }
+  bool ok = true;
+
+  std::vector<glm::mat4> products(count);
+  bando::MultiplyMat4Batch(glm::value_ptr(scene.view_projection),
+                           glm::value_ptr(scene.models[0]), count,
+                           glm::value_ptr(products[0]));
+  for (size_t i = 0; i < count && ok; ++i) {
+    glm::mat4 expected = scene.view_projection * scene.models[i];
+    for (int c = 0; c < 4; ++c) {
+      for (int r = 0; r < 4; ++r) {
+        float tolerance = 1e-4f * std::fmax(1.0f, std::fabs(expected[c][r]));
+        if (std::fabs(products[i][c][r] - expected[c][r]) > tolerance) {
+          std::printf("MultiplyMat4Batch mismatch at %zu [%d][%d]\n", i, c, r);
+          ok = false;
+        }
+      }
+    }
+  }
+
+  std::vector<uint8_t> visible(count);
+  bando::CullSpheres(scene.frustum, scene.x.data(), scene.y.data(),
+                     scene.z.data(), scene.radius.data(), count,
+                     visible.data());
+  size_t visible_count = 0;
+  for (size_t i = 0; i < count; ++i) {
+    bool expected = SphereVisibleGlm(planes, scene.spheres[i]);
+    visible_count += visible[i];
+    if ((visible[i] != 0) != expected &&
+        SphereMargin(planes, scene.spheres[i]) > 1e-3f) {
+      std::printf("CullSpheres mismatch at %zu\n", i);
+      ok = false;
+    }
+  }
+  if (visible_count == 0 || visible_count == count) {
+    std::printf("CullSpheres test scene is degenerate (%zu visible)\n",
+                visible_count);
+    ok = false;
+  }
+
+  bando::CullAabbs(scene.frustum, scene.min_x.data(), scene.min_y.data(),
+                   scene.min_z.data(), scene.max_x.data(), scene.max_y.data(),
+                   scene.max_z.data(), count, visible.data());
+  for (size_t i = 0; i < count; ++i) {
+    bool expected = BoxVisibleGlm(planes, scene.box_min[i], scene.box_max[i]);
+    if ((visible[i] != 0) != expected &&
+        BoxMargin(planes, scene.box_min[i], scene.box_max[i]) > 1e-3f) {
+      std::printf("CullAabbs mismatch at %zu\n", i);
+      ok = false;
+    }
+  }
+
+  glm::vec3 expected_min(INFINITY);
+  glm::vec3 expected_max(-INFINITY);
+  for (size_t i = 0; i < count; ++i) {
+    glm::vec3 point(scene.x[i], scene.y[i], scene.z[i]);
+    expected_min = glm::min(expected_min, point);
+    expected_max = glm::max(expected_max, point);
+  }
+  float min_out[3];
+  float max_out[3];
+  bando::ReduceAabb(scene.x.data(), scene.y.data(), scene.z.data(), count,
+                    min_out, max_out);
+  if (glm::vec3(min_out[0], min_out[1], min_out[2]) != expected_min ||
+      glm::vec3(max_out[0], max_out[1], max_out[2]) != expected_max) {
+    std::printf("ReduceAabb mismatch\n");
+    ok = false;
+  }
+  return ok;
+}
+
+void BM_Mat4Multiply_Glm(benchmark::State &state) {
+  Scene scene = MakeScene(static_cast<size_t>(state.range(0)));
+  std::vector<glm::mat4> out(scene.models.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < scene.models.size(); ++i) {
+      out[i] = scene.view_projection * scene.models[i];
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  bando::SetItemsProcessed(state, scene.models.size());
+}
+
+void BM_Mat4Multiply_Soa(benchmark::State &state) {
+  Scene scene = MakeScene(static_cast<size_t>(state.range(0)));
+  std::vector<glm::mat4> out(scene.models.size());
+  for (auto _ : state) {
+    bando::MultiplyMat4Batch(glm::value_ptr(scene.view_projection),
+                             glm::value_ptr(scene.models[0]),
+                             scene.models.size(), glm::value_ptr(out[0]));
+    benchmark::DoNotOptimize(out.data());
+  }
+  bando::SetItemsProcessed(state, scene.models.size());
+}
+
+void BM_CullSpheres_Glm(benchmark::State &state) {
+  Scene scene = MakeScene(static_cast<size_t>(state.range(0)));
+  glm::vec4 planes[6];
+  for (int plane = 0; plane < 6; ++plane) {
+    planes[plane] = Plane(scene.frustum, plane);
+  }
+  std::vector<uint8_t> visible(scene.spheres.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < scene.spheres.size(); ++i) {
+      visible[i] = SphereVisibleGlm(planes, scene.spheres[i]) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(visible.data());
+  }
+  bando::SetItemsProcessed(state, scene.spheres.size());
+}
+
+void BM_CullSpheres_Soa(benchmark::State &state) {
+  Scene scene = MakeScene(static_cast<size_t>(state.range(0)));
+  std::vector<uint8_t> visible(scene.x.size());
+  for (auto _ : state) {
+    bando::CullSpheres(scene.frustum, scene.x.data(), scene.y.data(),
+                       scene.z.data(), scene.radius.data(), scene.x.size(),
+                       visible.data());
+    benchmark::DoNotOptimize(visible.data());
+  }
+  bando::SetItemsProcessed(state, scene.x.size());
+}
+
+void BM_CullAabbs_Glm(benchmark::State &state) {
+  Scene scene = MakeScene(static_cast<size_t>(state.range(0)));
+  glm::vec4 planes[6];
+  for (int plane = 0; plane < 6; ++plane) {
+    planes[plane] = Plane(scene.frustum, plane);
+  }
+  std::vector<uint8_t> visible(scene.box_min.size());
+  for (auto _ : state) {
+    for (size_t i = 0; i < scene.box_min.size(); ++i) {
+      visible[i] =
+          BoxVisibleGlm(planes, scene.box_min[i], scene.box_max[i]) ? 1 : 0;
+    }
+    benchmark::DoNotOptimize(visible.data());
+  }
+  bando::SetItemsProcessed(state, scene.box_min.size());
+}
+
+void BM_CullAabbs_Soa(benchmark::State &state) {
+  Scene scene = MakeScene(static_cast<size_t>(state.range(0)));
+  std::vector<uint8_t> visible(scene.min_x.size());
+  for (auto _ : state) {
+    bando::CullAabbs(scene.frustum, scene.min_x.data(), scene.min_y.data(),
+                     scene.min_z.data(), scene.max_x.data(),
+                     scene.max_y.data(), scene.max_z.data(),
+                     scene.min_x.size(), visible.data());
+    benchmark::DoNotOptimize(visible.data());
+  }
+  bando::SetItemsProcessed(state, scene.min_x.size());
+}
+
+// Mirrors ComputeBounds in hello_3d: glm::min/glm::max over AoS points.
+void BM_ReduceAabb_Glm(benchmark::State &state) {
+  Scene scene = MakeScene(static_cast<size_t>(state.range(0)));
+  std::vector<glm::vec3> points;
+  for (const glm::vec4 &sphere : scene.spheres) {
+    points.push_back(glm::vec3(sphere));
+  }
+  for (auto _ : state) {
+    glm::vec3 min_pos(INFINITY);
+    glm::vec3 max_pos(-INFINITY);
+    for (const glm::vec3 &point : points) {
+      min_pos = glm::min(min_pos, point);
+      max_pos = glm::max(max_pos, point);
+    }
+    benchmark::DoNotOptimize(min_pos);
+    benchmark::DoNotOptimize(max_pos);
+  }
+  bando::SetItemsProcessed(state, points.size());
+}
+
+void BM_ReduceAabb_Soa(benchmark::State &state) {
+  Scene scene = MakeScene(static_cast<size_t>(state.range(0)));
+  for (auto _ : state) {
+    float min_out[3];
+    float max_out[3];
+    bando::ReduceAabb(scene.x.data(), scene.y.data(), scene.z.data(),
+                      scene.x.size(), min_out, max_out);
+    benchmark::DoNotOptimize(min_out);
+    benchmark::DoNotOptimize(max_out);
+  }
+  bando::SetItemsProcessed(state, scene.x.size());
+}
+
+#define BANDO_SOA_BENCHMARK(name) \
+  BENCHMARK(name)->RangeMultiplier(8)->Range(1 << 10, 1 << 19)
+
+BANDO_SOA_BENCHMARK(BM_Mat4Multiply_Glm);
+BANDO_SOA_BENCHMARK(BM_Mat4Multiply_Soa);
+BANDO_SOA_BENCHMARK(BM_CullSpheres_Glm);
+BANDO_SOA_BENCHMARK(BM_CullSpheres_Soa);
+BANDO_SOA_BENCHMARK(BM_CullAabbs_Glm);
+BANDO_SOA_BENCHMARK(BM_CullAabbs_Soa);
+BANDO_SOA_BENCHMARK(BM_ReduceAabb_Glm);
+BANDO_SOA_BENCHMARK(BM_ReduceAabb_Soa);
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  return bando::RunVerifiedBenchmarks(
+      argc, argv, std::string("SoA math (") + bando::SoaMathIsa() + ")",
+      VerifyAgainstGlm);
+}
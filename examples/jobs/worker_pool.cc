@@ -0,0 +1,96 @@
+#include "examples/jobs/worker_pool.h"
+
+#include <algorithm>
+
+#include "examples/profiling/profile_zones.h"
+
+namespace bando {
+
+WorkerPool::WorkerPool(int threads) {
+  size_t thread_count =
+      threads > 0 ? static_cast<size_t>(threads)
+                  : std::max(std::thread::hardware_concurrency(), 1u);
+  threads_.reserve(thread_count - 1);
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads_.emplace_back([this]() {
+      BANDO_PROFILE_THREAD_NAME("pool_worker");
+      WorkerLoop();
+    });
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_ready_.notify_all();
+  for (std::thread &thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkerPool::ParallelFor(size_t count,
+                             size_t grain,
+                             const std::function<void(size_t, size_t)> &body) {
+  if (count == 0) {
+    return;
+  }
+  grain = std::max<size_t>(grain, 1);
+  // Not worth waking anyone for a single range.
+  if (threads_.empty() || count <= grain) {
+    for (size_t begin = 0; begin < count; begin += grain) {
+      body(begin, std::min(begin + grain, count));
+    }
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    body_ = &body;
+    count_ = count;
+    grain_ = grain;
+    next_.store(0, std::memory_order_relaxed);
+    busy_workers_ = threads_.size();
+    ++generation_;
+  }
+  work_ready_.notify_all();
+  RunRanges();
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [this]() { return busy_workers_ == 0; });
+  body_ = nullptr;
+}
+
+void WorkerPool::WorkerLoop() {
+  uint64_t seen_generation = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_ready_.wait(lock, [this, seen_generation]() {
+        return stopping_ || generation_ != seen_generation;
+      });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+    }
+    RunRanges();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--busy_workers_ == 0) {
+        work_done_.notify_one();
+      }
+    }
+  }
+}
+
+void WorkerPool::RunRanges() {
+  for (;;) {
+    size_t begin = next_.fetch_add(grain_, std::memory_order_relaxed);
+    if (begin >= count_) {
+      return;
+    }
+    (*body_)(begin, std::min(begin + grain_, count_));
+  }
+}
+
+}  // namespace bando
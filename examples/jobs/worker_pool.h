@@ -0,0 +1,63 @@
+#ifndef EXAMPLES_JOBS_WORKER_POOL_H_
+#define EXAMPLES_JOBS_WORKER_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads for data-parallel work that repeats every frame
+// (animation, skinning, culling). Unlike the one-shot loads in
+// //examples/textures:texture_cache, per-frame work cannot afford to start
+// threads each time, so the pool keeps them parked on a condition variable
+// between calls.
+
+namespace bando {
+
+class WorkerPool {
+ public:
+  // `threads` counts the calling thread, which always takes part in
+  // ParallelFor; 0 uses std::thread::hardware_concurrency().
+  explicit WorkerPool(int threads = 0);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  size_t thread_count() const { return threads_.size() + 1; }
+
+  // Calls body(begin, end) for consecutive ranges of at most `grain` items
+  // covering [0, count) and returns once all of them ran. Ranges are
+  // claimed through an atomic counter, so uneven ranges balance out. Must
+  // not be called concurrently or from inside `body`.
+  void ParallelFor(size_t count,
+                   size_t grain,
+                   const std::function<void(size_t, size_t)> &body);
+
+ private:
+  void WorkerLoop();
+  void RunRanges();
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable work_ready_;
+  std::condition_variable work_done_;
+  // Bumped for every ParallelFor so parked workers can tell a new batch
+  // from a spurious wakeup.
+  uint64_t generation_ = 0;
+  size_t busy_workers_ = 0;
+  bool stopping_ = false;
+
+  const std::function<void(size_t, size_t)> *body_ = nullptr;
+  size_t count_ = 0;
+  size_t grain_ = 1;
+  std::atomic<size_t> next_{0};
+};
+
+}  // namespace bando
+
+#endif  // EXAMPLES_JOBS_WORKER_POOL_H_
@@ -0,0 +1,188 @@
+#include "examples/jolt/batch_query.h"
+
+#include <Jolt/Physics/Collision/CastResult.h>
+#include <Jolt/Physics/Collision/CollisionCollectorImpl.h>
+#include <Jolt/Physics/Collision/NarrowPhaseQuery.h>
+
+#include "examples/profiling/profile_zones.h"
+
+#include <algorithm>
+
+namespace bando {
+
+namespace {
+
+// Keeps a few jobs per worker so uneven query costs still balance out.
+constexpr int kJobsPerThread = 4;
+
+// Default filters are stateless, so a single shared instance can serve every
+// worker thread.
+const JPH::BroadPhaseLayerFilter kDefaultBroadPhaseLayerFilter{};
+const JPH::ObjectLayerFilter kDefaultObjectLayerFilter{};
+const JPH::BodyFilter kDefaultBodyFilter{};
+const JPH::ShapeFilter kDefaultShapeFilter{};
+
+struct ResolvedFilters {
+  const JPH::BroadPhaseLayerFilter &broad_phase_layer;
+  const JPH::ObjectLayerFilter &object_layer;
+  const JPH::BodyFilter &body;
+  const JPH::ShapeFilter &shape;
+};
+
+ResolvedFilters Resolve(const BatchQueryFilters &filters) {
+  return ResolvedFilters{
+      filters.broad_phase_layer_filter ? *filters.broad_phase_layer_filter
+                                       : kDefaultBroadPhaseLayerFilter,
+      filters.object_layer_filter ? *filters.object_layer_filter
+                                  : kDefaultObjectLayerFilter,
+      filters.body_filter ? *filters.body_filter : kDefaultBodyFilter,
+      filters.shape_filter ? *filters.shape_filter : kDefaultShapeFilter};
+}
+
+}  // namespace
+
+void RayHitBatch::Resize(size_t count) {
+  hit.resize(count);
+  fraction.resize(count);
+  body_id.resize(count);
+  position_x.resize(count);
+  position_y.resize(count);
+  position_z.resize(count);
+}
+
+void ShapeCastHitBatch::Resize(size_t count) {
+  hit.resize(count);
+  fraction.resize(count);
+  body_id.resize(count);
+  contact_x.resize(count);
+  contact_y.resize(count);
+  contact_z.resize(count);
+  normal_x.resize(count);
+  normal_y.resize(count);
+  normal_z.resize(count);
+}
+
+BatchQuery::BatchQuery(const JPH::PhysicsSystem *system,
+                       JPH::JobSystem *job_system)
+    : system_(system), job_system_(job_system) {}
+
+template <typename RunRange>
+void BatchQuery::Dispatch(size_t count, const RunRange &run_range) {
+  if (count == 0) {
+    return;
+  }
+  size_t max_jobs = 1;
+  if (job_system_) {
+    max_jobs = static_cast<size_t>(
+        std::max(1, job_system_->GetMaxConcurrency() * kJobsPerThread));
+  }
+  size_t job_count = std::min(
+      max_jobs, (count + min_queries_per_job_ - 1) / min_queries_per_job_);
+  if (job_count <= 1) {
+    run_range(0, count);
+    return;
+  }
+
+  size_t per_job = (count + job_count - 1) / job_count;
+  jobs_.clear();
+  jobs_.reserve(job_count);
+  for (size_t first = 0; first < count; first += per_job) {
+    // The lambda only captures a pointer and two 32-bit indices so it fits
+    // the small buffer of the job function and does not allocate.
+    uint32_t begin = static_cast<uint32_t>(first);
+    uint32_t end = static_cast<uint32_t>(std::min(count, first + per_job));
+    const RunRange *run = &run_range;
+    jobs_.push_back(job_system_->CreateJob(
+        "BatchQuery", JPH::Color::sGreen,
+        [run, begin, end]() { (*run)(begin, end); }));
+  }
+  JPH::JobSystem::Barrier *barrier = job_system_->CreateBarrier();
+  barrier->AddJobs(jobs_.data(), static_cast<JPH::uint>(jobs_.size()));
+  job_system_->WaitForJobs(barrier);
+  job_system_->DestroyBarrier(barrier);
+  jobs_.clear();
+}
+
+void BatchQuery::CastRays(const JPH::RRayCast *rays,
+                          size_t count,
+                          RayHitBatch *hits,
+                          const BatchQueryFilters &filters) {
+  if (!rays || !hits) {
+    return;
+  }
+  hits->Resize(count);
+  const JPH::NarrowPhaseQuery &query = system_->GetNarrowPhaseQuery();
+  ResolvedFilters resolved = Resolve(filters);
+  auto run_range = [&](size_t begin, size_t end) {
+    BANDO_PROFILE_ZONE("BatchQuery::CastRays");
+    for (size_t i = begin; i < end; ++i) {
+      JPH::RayCastResult result;
+      bool hit = query.CastRay(rays[i], result, resolved.broad_phase_layer,
+                               resolved.object_layer, resolved.body);
+      hits->hit[i] = hit ? 1 : 0;
+      if (!hit) {
+        hits->fraction[i] = 1.0f;
+        hits->body_id[i] = JPH::BodyID::cInvalidBodyID;
+        hits->position_x[i] = 0.0f;
+        hits->position_y[i] = 0.0f;
+        hits->position_z[i] = 0.0f;
+        continue;
+      }
+      JPH::RVec3 position = rays[i].GetPointOnRay(result.mFraction);
+      hits->fraction[i] = result.mFraction;
+      hits->body_id[i] = result.mBodyID.GetIndexAndSequenceNumber();
+      hits->position_x[i] = static_cast<float>(position.GetX());
+      hits->position_y[i] = static_cast<float>(position.GetY());
+      hits->position_z[i] = static_cast<float>(position.GetZ());
+    }
+  };
+  Dispatch(count, run_range);
+}
+
+void BatchQuery::CastShapes(const JPH::RShapeCast *casts,
+                            size_t count,
+                            const JPH::ShapeCastSettings &settings,
+                            ShapeCastHitBatch *hits,
+                            const BatchQueryFilters &filters) {
+  if (!casts || !hits) {
+    return;
+  }
+  hits->Resize(count);
+  const JPH::NarrowPhaseQuery &query = system_->GetNarrowPhaseQuery();
+  ResolvedFilters resolved = Resolve(filters);
+  auto run_range = [&](size_t begin, size_t end) {
+    BANDO_PROFILE_ZONE("BatchQuery::CastShapes");
+    for (size_t i = begin; i < end; ++i) {
+      JPH::ClosestHitCollisionCollector<JPH::CastShapeCollector> collector;
+      query.CastShape(casts[i], settings, JPH::RVec3::sZero(), collector,
+                      resolved.broad_phase_layer, resolved.object_layer,
+                      resolved.body, resolved.shape);
+      hits->hit[i] = collector.HadHit() ? 1 : 0;
+      if (!collector.HadHit()) {
+        hits->fraction[i] = 1.0f;
+        hits->body_id[i] = JPH::BodyID::cInvalidBodyID;
+        hits->contact_x[i] = 0.0f;
+        hits->contact_y[i] = 0.0f;
+        hits->contact_z[i] = 0.0f;
+        hits->normal_x[i] = 0.0f;
+        hits->normal_y[i] = 0.0f;
+        hits->normal_z[i] = 0.0f;
+        continue;
+      }
+      const JPH::ShapeCastResult &result = collector.mHit;
+      JPH::Vec3 normal =
+          -result.mPenetrationAxis.NormalizedOr(JPH::Vec3::sZero());
+      hits->fraction[i] = result.mFraction;
+      hits->body_id[i] = result.mBodyID2.GetIndexAndSequenceNumber();
+      hits->contact_x[i] = static_cast<float>(result.mContactPointOn2.GetX());
+      hits->contact_y[i] = static_cast<float>(result.mContactPointOn2.GetY());
+      hits->contact_z[i] = static_cast<float>(result.mContactPointOn2.GetZ());
+      hits->normal_x[i] = normal.GetX();
+      hits->normal_y[i] = normal.GetY();
+      hits->normal_z[i] = normal.GetZ();
+    }
+  };
+  Dispatch(count, run_range);
+}
+
+}  // namespace bando
@@ -0,0 +1,103 @@
+#ifndef EXAMPLES_JOLT_BATCH_QUERY_H_
+#define EXAMPLES_JOLT_BATCH_QUERY_H_
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Physics/Body/BodyFilter.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseLayer.h>
+#include <Jolt/Physics/Collision/ObjectLayer.h>
+#include <Jolt/Physics/Collision/RayCast.h>
+#include <Jolt/Physics/Collision/ShapeCast.h>
+#include <Jolt/Physics/Collision/ShapeFilter.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bando {
+
+// Closest-hit results of a ray batch, one entry per input ray. Stored as
+// separate arrays so consumers that only look at `hit` or `fraction` do not
+// pull the rest into cache.
+struct RayHitBatch {
+  std::vector<uint8_t> hit;
+  std::vector<float> fraction;
+  std::vector<uint32_t> body_id;
+  std::vector<float> position_x;
+  std::vector<float> position_y;
+  std::vector<float> position_z;
+
+  void Resize(size_t count);
+  size_t size() const { return hit.size(); }
+};
+
+// Closest-hit results of a shape cast batch, one entry per input cast.
+struct ShapeCastHitBatch {
+  std::vector<uint8_t> hit;
+  std::vector<float> fraction;
+  std::vector<uint32_t> body_id;
+  std::vector<float> contact_x;
+  std::vector<float> contact_y;
+  std::vector<float> contact_z;
+  std::vector<float> normal_x;
+  std::vector<float> normal_y;
+  std::vector<float> normal_z;
+
+  void Resize(size_t count);
+  size_t size() const { return hit.size(); }
+};
+
+// Optional filters shared by every query of a batch. Null members use the
+// accept-everything defaults. Filters are called concurrently from worker
+// threads and must be thread safe.
+struct BatchQueryFilters {
+  const JPH::BroadPhaseLayerFilter *broad_phase_layer_filter = nullptr;
+  const JPH::ObjectLayerFilter *object_layer_filter = nullptr;
+  const JPH::BodyFilter *body_filter = nullptr;
+  const JPH::ShapeFilter *shape_filter = nullptr;
+};
+
+// Runs many closest-hit queries against a PhysicsSystem by splitting them into
+// contiguous ranges executed as jobs on a JobSystem. Each job writes straight
+// into its slice of the result arrays using stack-allocated collectors, so a
+// batch does not allocate once the result arrays and the job handle scratch
+// have grown to size.
+//
+// The physics system must not be updated while a batch is running.
+class BatchQuery {
+ public:
+  BatchQuery(const JPH::PhysicsSystem *system, JPH::JobSystem *job_system);
+
+  BatchQuery(const BatchQuery &) = delete;
+  BatchQuery &operator=(const BatchQuery &) = delete;
+
+  void CastRays(const JPH::RRayCast *rays,
+                size_t count,
+                RayHitBatch *hits,
+                const BatchQueryFilters &filters = {});
+  void CastShapes(const JPH::RShapeCast *casts,
+                  size_t count,
+                  const JPH::ShapeCastSettings &settings,
+                  ShapeCastHitBatch *hits,
+                  const BatchQueryFilters &filters = {});
+
+  // Lower bound on the number of queries handed to a single job. Small
+  // batches run inline on the calling thread.
+  void set_min_queries_per_job(size_t value) {
+    min_queries_per_job_ = value ? value : 1;
+  }
+
+ private:
+  template <typename RunRange>
+  void Dispatch(size_t count, const RunRange &run_range);
+
+  const JPH::PhysicsSystem *system_;
+  JPH::JobSystem *job_system_;
+  size_t min_queries_per_job_ = 64;
+  std::vector<JPH::JobHandle> jobs_;
+};
+
+}  // namespace bando
+
+#endif  // EXAMPLES_JOLT_BATCH_QUERY_H_
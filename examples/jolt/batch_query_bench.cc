@@ -0,0 +1,131 @@
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Physics/Collision/Shape/SphereShape.h>
+#include <Jolt/Physics/PhysicsSettings.h>
+#include <Jolt/RegisterTypes.h>
+
+#include <benchmark/benchmark.h>
+
+#include "examples/bench/bench_harness.h"
+#include "examples/jolt/batch_query.h"
+#include "examples/jolt/jolt_profile.h"
+#include "examples/jolt/jolt_world.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Measures batched closest-hit queries per second against the demo stack
+// scene for a range of worker thread counts:
+//   bazel run -c opt //examples/jolt:batch_query_bench
+
+namespace {
+
+constexpr int kStackCount = 256;
+constexpr float kSceneExtent = 24.0f;
+
+bando::JoltWorld *g_world = nullptr;
+
+std::vector<JPH::RRayCast> MakeRays(size_t count) {
+  std::vector<JPH::RRayCast> rays;
+  rays.reserve(count);
+  uint32_t random = 7u;
+  for (size_t i = 0; i < count; ++i) {
+    float x = bando::NextRange(&random, kSceneExtent);
+    float z = bando::NextRange(&random, kSceneExtent);
+    float dx = bando::NextRange(&random, 5.0f);
+    float dz = bando::NextRange(&random, 5.0f);
+    rays.push_back(JPH::RRayCast{JPH::RVec3(x, 20.0f, z),
+                                 JPH::Vec3(dx, -40.0f, dz)});
+  }
+  return rays;
+}
+
+std::vector<JPH::RShapeCast> MakeSphereCasts(const JPH::Shape *sphere,
+                                             size_t count) {
+  std::vector<JPH::RShapeCast> casts;
+  casts.reserve(count);
+  for (const JPH::RRayCast &ray : MakeRays(count)) {
+    casts.push_back(JPH::RShapeCast(
+        sphere, JPH::Vec3::sReplicate(1.0f),
+        JPH::RMat44::sTranslation(ray.mOrigin), ray.mDirection));
+  }
+  return casts;
+}
+
+void BM_BatchCastRays(benchmark::State &state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  const int threads = static_cast<int>(state.range(1));
+  JPH::JobSystemThreadPool job_system;
+  bando::InitJoltJobSystem(&job_system, JPH::cMaxPhysicsJobs,
+                           JPH::cMaxPhysicsBarriers, threads);
+  bando::BatchQuery query(&g_world->physics_system(), &job_system);
+  std::vector<JPH::RRayCast> rays = MakeRays(count);
+  bando::RayHitBatch hits;
+  for (auto _ : state) {
+    query.CastRays(rays.data(), rays.size(), &hits);
+    benchmark::DoNotOptimize(hits.hit.data());
+  }
+  state.counters["queries_per_second"] = benchmark::Counter(
+      static_cast<double>(count),
+      benchmark::Counter::kIsIterationInvariantRate);
+}
+
+void BM_BatchCastSpheres(benchmark::State &state) {
+  const size_t count = static_cast<size_t>(state.range(0));
+  const int threads = static_cast<int>(state.range(1));
+  JPH::JobSystemThreadPool job_system;
+  bando::InitJoltJobSystem(&job_system, JPH::cMaxPhysicsJobs,
+                           JPH::cMaxPhysicsBarriers, threads);
+  bando::BatchQuery query(&g_world->physics_system(), &job_system);
+  JPH::RefConst<JPH::Shape> sphere = new JPH::SphereShape(0.25f);
+  std::vector<JPH::RShapeCast> casts = MakeSphereCasts(sphere, count);
+  JPH::ShapeCastSettings settings;
+  bando::ShapeCastHitBatch hits;
+  for (auto _ : state) {
+    query.CastShapes(casts.data(), casts.size(), settings, &hits);
+    benchmark::DoNotOptimize(hits.hit.data());
+  }
+  state.counters["queries_per_second"] = benchmark::Counter(
+      static_cast<double>(count),
+      benchmark::Counter::kIsIterationInvariantRate);
+}
+
+// Thread counts are worker threads; the calling thread helps out as well.
+BENCHMARK(BM_BatchCastRays)
+    ->ArgNames({"queries", "threads"})
+    ->ArgsProduct({{1024, 16384}, {0, 1, 3, 7, 15}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK(BM_BatchCastSpheres)
+    ->ArgNames({"queries", "threads"})
+    ->ArgsProduct({{1024, 16384}, {0, 1, 3, 7, 15}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+
+  JPH::RegisterDefaultAllocator();
+  JPH::Factory::sInstance = new JPH::Factory();
+  JPH::RegisterTypes();
+  {
+    auto world = std::make_unique<bando::JoltWorld>();
+    bando::BuildDemoScene(&world->physics_system(), kStackCount);
+    g_world = world.get();
+    benchmark::RunSpecifiedBenchmarks();
+    g_world = nullptr;
+  }
+  benchmark::Shutdown();
+
+  JPH::UnregisterTypes();
+  delete JPH::Factory::sInstance;
+  JPH::Factory::sInstance = nullptr;
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include "examples/jolt/jolt_profile.h"
+
+#include "examples/profiling/profile_zones.h"
+
+#include <new>
+
+namespace bando {
+
+void InitJoltJobSystem(JPH::JobSystemThreadPool *job_system,
+                       JPH::uint max_jobs,
+                       JPH::uint max_barriers,
+                       int thread_count) {
+  job_system->SetThreadInitFunction(
+      [](int) { BANDO_PROFILE_THREAD_NAME("jolt_worker"); });
+  job_system->Init(max_jobs, max_barriers, thread_count);
+}
+
+}  // namespace bando
+
+#if defined(JPH_EXTERNAL_PROFILE)
+
+// A static Jolt build leaves these to the application. Jolt passes string
+// literals or function names, so the zone can keep the pointer.
+namespace JPH {
+
+#if defined(BANDO_PROFILING)
+
+ExternalProfileMeasurement::ExternalProfileMeasurement(const char *inName,
+                                                       uint32) {
+  static_assert(sizeof(bando::ProfileZone) <= sizeof(mUserData) &&
+                    alignof(bando::ProfileZone) <= 16,
+                "ProfileZone must fit Jolt's measurement storage");
+  new (mUserData) bando::ProfileZone(inName);
+}
+
+ExternalProfileMeasurement::~ExternalProfileMeasurement() {
+  std::launder(reinterpret_cast<bando::ProfileZone *>(mUserData))
+      ->~ProfileZone();
+}
+
+#else
+
+ExternalProfileMeasurement::ExternalProfileMeasurement(const char *,
+                                                       uint32) {}
+ExternalProfileMeasurement::~ExternalProfileMeasurement() {}
+
+#endif
+
+}  // namespace JPH
+
+#endif  // defined(JPH_EXTERNAL_PROFILE)
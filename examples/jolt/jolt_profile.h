@@ -0,0 +1,24 @@
+#ifndef EXAMPLES_JOLT_JOLT_PROFILE_H_
+#define EXAMPLES_JOLT_JOLT_PROFILE_H_
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+
+// Under --define=bando_profiling=1 Jolt is built with JPH_EXTERNAL_PROFILE,
+// and this library implements its measurement hooks as BANDO_PROFILE_ZONE
+// scopes. PhysicsSystem::Update then shows up in the trace as Jolt's own
+// per-job zones on every worker thread instead of a single opaque zone on
+// the caller.
+
+namespace bando {
+
+// JobSystemThreadPool::Init, with each worker naming itself "jolt_worker"
+// in profiling traces before it takes jobs.
+void InitJoltJobSystem(JPH::JobSystemThreadPool *job_system,
+                       JPH::uint max_jobs,
+                       JPH::uint max_barriers,
+                       int thread_count = -1);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_JOLT_JOLT_PROFILE_H_
@@ -0,0 +1,229 @@
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/Factory.h>
+#include <Jolt/Core/JobSystemThreadPool.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/PhysicsSettings.h>
+#include <Jolt/RegisterTypes.h>
+
+#include "examples/jolt/jolt_profile.h"
+#include "examples/jolt/jolt_world.h"
+#include "examples/jolt/physics_replay.h"
+#include "examples/profiling/profile_zones.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr const char *kSceneTag = "demo_stacks";
+constexpr int kStackCount = 64;
+constexpr float kDeltaTime = 1.0f / 60.0f;
+constexpr int kImpulseInterval = 30;
+
+struct Options {
+  std::string record_path;
+  std::string replay_path;
+  std::string timings_path;
+  std::string trace_path;
+  int steps = 600;
+  int threads = -1;
+};
+
+bool StartsWith(const std::string &value, const std::string &prefix) {
+  return value.rfind(prefix, 0) == 0;
+}
+
+void PrintUsage(const char *argv0) {
+  std::printf(
+      "Usage: %s --record=PATH [--steps=N] [--threads=N] [--trace=PATH]\n"
+      "       %s --replay=PATH [--timings=CSV] [--threads=N] [--trace=PATH]\n",
+      argv0, argv0);
+}
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      PrintUsage(argv[0]);
+      std::exit(0);
+    }
+    if (StartsWith(arg, "--record=")) {
+      options.record_path = arg.substr(std::strlen("--record="));
+      continue;
+    }
+    if (StartsWith(arg, "--replay=")) {
+      options.replay_path = arg.substr(std::strlen("--replay="));
+      continue;
+    }
+    if (StartsWith(arg, "--timings=")) {
+      options.timings_path = arg.substr(std::strlen("--timings="));
+      continue;
+    }
+    if (StartsWith(arg, "--trace=")) {
+      options.trace_path = arg.substr(std::strlen("--trace="));
+      continue;
+    }
+    if (StartsWith(arg, "--steps=")) {
+      options.steps = std::atoi(arg.c_str() + std::strlen("--steps="));
+      continue;
+    }
+    if (StartsWith(arg, "--threads=")) {
+      options.threads = std::atoi(arg.c_str() + std::strlen("--threads="));
+      continue;
+    }
+    std::printf("Unknown argument: %s\n", arg.c_str());
+  }
+  return options;
+}
+
+// Deterministic stand-in for gameplay input: periodically kicks a box.
+uint32_t NextRandom(uint32_t *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return *state;
+}
+
+int Record(const Options &options,
+           JPH::TempAllocator *temp_allocator,
+           JPH::JobSystem *job_system) {
+  bando::JoltWorld world;
+  JPH::PhysicsSystem &system = world.physics_system();
+  bando::BuildDemoScene(&system, kStackCount);
+
+  JPH::BodyIDVector body_ids;
+  system.GetBodies(body_ids);
+  bando::PhysicsRecorder recorder(&system, kSceneTag);
+  recorder.Begin();
+  uint32_t random = 1u;
+  for (int step = 0; step < options.steps; ++step) {
+    if (step % kImpulseInterval == 0 && body_ids.size() > 1) {
+      bando::PhysicsInput input;
+      // Body 0 is the static floor.
+      size_t target = 1 + NextRandom(&random) % (body_ids.size() - 1);
+      input.body_id = body_ids[target].GetIndexAndSequenceNumber();
+      input.type = bando::PhysicsInputType::kAddImpulse;
+      input.value[0] = static_cast<float>(NextRandom(&random) % 200) - 100.0f;
+      input.value[1] = 50.0f;
+      input.value[2] = static_cast<float>(NextRandom(&random) % 200) - 100.0f;
+      recorder.AddInput(input);
+    }
+    recorder.Step(kDeltaTime, 1, temp_allocator, job_system);
+  }
+
+  std::string error;
+  if (!bando::WritePhysicsCapture(options.record_path, recorder.capture(),
+                                  &error)) {
+    std::printf("%s\n", error.c_str());
+    return 1;
+  }
+  std::printf("Recorded %d steps of %u bodies to %s\n", options.steps,
+              recorder.capture().body_count, options.record_path.c_str());
+  return 0;
+}
+
+int Replay(const Options &options,
+           JPH::TempAllocator *temp_allocator,
+           JPH::JobSystem *job_system) {
+  bando::PhysicsCapture capture;
+  std::string error;
+  if (!bando::ReadPhysicsCapture(options.replay_path, &capture, &error)) {
+    std::printf("%s\n", error.c_str());
+    return 1;
+  }
+  if (capture.scene_tag != kSceneTag) {
+    std::printf("Capture scene '%s' is not known to this binary\n",
+                capture.scene_tag.c_str());
+    return 1;
+  }
+
+  bando::JoltWorld world;
+  JPH::PhysicsSystem &system = world.physics_system();
+  bando::BuildDemoScene(&system, kStackCount);
+  bando::ReplayReport report;
+  if (!bando::ReplayPhysicsCapture(capture, &system, temp_allocator,
+                                   job_system, &report, &error)) {
+    std::printf("%s\n", error.c_str());
+    return 1;
+  }
+
+  if (!options.timings_path.empty()) {
+    std::ofstream timings(options.timings_path);
+    timings << "step,ms\n";
+    for (size_t i = 0; i < report.step_ms.size(); ++i) {
+      timings << i << "," << report.step_ms[i] << "\n";
+    }
+  }
+
+  std::vector<double> sorted = report.step_ms;
+  std::sort(sorted.begin(), sorted.end());
+  if (!sorted.empty()) {
+    size_t slowest = static_cast<size_t>(
+        std::max_element(report.step_ms.begin(), report.step_ms.end()) -
+        report.step_ms.begin());
+    std::printf("Replayed %zu steps: median %.3f ms, p99 %.3f ms, "
+                "max %.3f ms (step %zu)\n",
+                sorted.size(), sorted[sorted.size() / 2],
+                sorted[sorted.size() * 99 / 100], sorted.back(), slowest);
+  }
+  if (report.failed_step >= 0) {
+    std::printf("Physics update failed at step %d (error 0x%x)\n",
+                report.failed_step,
+                static_cast<unsigned>(report.update_error));
+    return 1;
+  }
+  if (report.first_divergent_step >= 0) {
+    std::printf("Replay diverged from the capture at step %d\n",
+                report.first_divergent_step);
+    return 1;
+  }
+  std::printf("Replay is bit-exact\n");
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options options = ParseOptions(argc, argv);
+  if (options.record_path.empty() == options.replay_path.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  BANDO_PROFILE_THREAD_NAME("main");
+
+  JPH::RegisterDefaultAllocator();
+  JPH::Factory::sInstance = new JPH::Factory();
+  JPH::RegisterTypes();
+
+  int result = 0;
+  {
+    JPH::TempAllocatorImpl temp_allocator(32 * 1024 * 1024);
+    JPH::JobSystemThreadPool job_system;
+    bando::InitJoltJobSystem(&job_system, JPH::cMaxPhysicsJobs,
+                             JPH::cMaxPhysicsBarriers, options.threads);
+    if (!options.record_path.empty()) {
+      result = Record(options, &temp_allocator, &job_system);
+    } else {
+      result = Replay(options, &temp_allocator, &job_system);
+    }
+  }
+  if (!options.trace_path.empty()) {
+    std::string error;
+    if (bando::WriteChromeTrace(options.trace_path, &error)) {
+      std::printf("Wrote profiling trace to %s\n", options.trace_path.c_str());
+    } else {
+      std::printf("%s\n", error.c_str());
+      result = 1;
+    }
+  }
+
+  JPH::UnregisterTypes();
+  delete JPH::Factory::sInstance;
+  JPH::Factory::sInstance = nullptr;
+  return result;
+}
@@ -0,0 +1,97 @@
+#include "examples/jolt/jolt_world.h"
+
+#include <Jolt/Physics/Body/BodyCreationSettings.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/Collision/Shape/BoxShape.h>
+
+namespace bando {
+
+namespace {
+
+constexpr uint32_t kNumBodyMutexes = 0;
+constexpr uint32_t kMaxBodyPairs = 65536;
+constexpr uint32_t kMaxContactConstraints = 10240;
+constexpr int kBoxesPerStack = 10;
+constexpr float kBoxHalfExtent = 0.5f;
+constexpr float kStackSpacing = 3.0f;
+
+}  // namespace
+
+JPH::uint BroadPhaseLayerInterfaceImpl::GetNumBroadPhaseLayers() const {
+  return BroadPhaseLayers::kCount;
+}
+
+JPH::BroadPhaseLayer BroadPhaseLayerInterfaceImpl::GetBroadPhaseLayer(
+    JPH::ObjectLayer layer) const {
+  return layer == ObjectLayers::kNonMoving ? BroadPhaseLayers::kNonMoving
+                                           : BroadPhaseLayers::kMoving;
+}
+
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+const char *BroadPhaseLayerInterfaceImpl::GetBroadPhaseLayerName(
+    JPH::BroadPhaseLayer layer) const {
+  return layer == BroadPhaseLayers::kNonMoving ? "NON_MOVING" : "MOVING";
+}
+#endif
+
+bool ObjectVsBroadPhaseLayerFilterImpl::ShouldCollide(
+    JPH::ObjectLayer layer,
+    JPH::BroadPhaseLayer broad_phase_layer) const {
+  if (layer == ObjectLayers::kNonMoving) {
+    return broad_phase_layer == BroadPhaseLayers::kMoving;
+  }
+  return true;
+}
+
+bool ObjectLayerPairFilterImpl::ShouldCollide(JPH::ObjectLayer left,
+                                              JPH::ObjectLayer right) const {
+  if (left == ObjectLayers::kNonMoving) {
+    return right == ObjectLayers::kMoving;
+  }
+  return true;
+}
+
+JoltWorld::JoltWorld(uint32_t max_bodies) {
+  physics_system_.Init(max_bodies, kNumBodyMutexes, kMaxBodyPairs,
+                       kMaxContactConstraints, broad_phase_layers_,
+                       object_vs_broad_phase_filter_,
+                       object_layer_pair_filter_);
+}
+
+void BuildDemoScene(JPH::PhysicsSystem *system, int stack_count) {
+  if (!system) {
+    return;
+  }
+  JPH::BodyInterface &bodies = system->GetBodyInterface();
+
+  JPH::BodyCreationSettings floor_settings(
+      new JPH::BoxShape(JPH::Vec3(200.0f, 1.0f, 200.0f)),
+      JPH::RVec3(0.0, -1.0, 0.0), JPH::Quat::sIdentity(),
+      JPH::EMotionType::Static, ObjectLayers::kNonMoving);
+  bodies.CreateAndAddBody(floor_settings, JPH::EActivation::DontActivate);
+
+  JPH::RefConst<JPH::Shape> box_shape =
+      new JPH::BoxShape(JPH::Vec3::sReplicate(kBoxHalfExtent));
+  int side = 1;
+  while (side * side < stack_count) {
+    ++side;
+  }
+  for (int stack = 0; stack < stack_count; ++stack) {
+    double x = (stack % side - side / 2) * kStackSpacing;
+    double z = (stack / side - side / 2) * kStackSpacing;
+    for (int level = 0; level < kBoxesPerStack; ++level) {
+      // Offset alternate levels slightly so stacks topple over time.
+      double jitter = (level % 2) * 0.05;
+      JPH::BodyCreationSettings box_settings(
+          box_shape,
+          JPH::RVec3(x + jitter, kBoxHalfExtent + level * 2.0 * kBoxHalfExtent,
+                     z),
+          JPH::Quat::sIdentity(), JPH::EMotionType::Dynamic,
+          ObjectLayers::kMoving);
+      bodies.CreateAndAddBody(box_settings, JPH::EActivation::Activate);
+    }
+  }
+  system->OptimizeBroadPhase();
+}
+
+}  // namespace bando
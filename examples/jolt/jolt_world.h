@@ -0,0 +1,76 @@
+#ifndef EXAMPLES_JOLT_JOLT_WORLD_H_
+#define EXAMPLES_JOLT_JOLT_WORLD_H_
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Physics/Collision/BroadPhase/BroadPhaseLayer.h>
+#include <Jolt/Physics/Collision/ObjectLayer.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+
+#include <cstdint>
+
+namespace bando {
+
+namespace ObjectLayers {
+constexpr JPH::ObjectLayer kNonMoving = 0;
+constexpr JPH::ObjectLayer kMoving = 1;
+constexpr JPH::ObjectLayer kCount = 2;
+}  // namespace ObjectLayers
+
+namespace BroadPhaseLayers {
+constexpr JPH::BroadPhaseLayer kNonMoving(0);
+constexpr JPH::BroadPhaseLayer kMoving(1);
+constexpr uint32_t kCount = 2;
+}  // namespace BroadPhaseLayers
+
+class BroadPhaseLayerInterfaceImpl final
+    : public JPH::BroadPhaseLayerInterface {
+ public:
+  JPH::uint GetNumBroadPhaseLayers() const override;
+  JPH::BroadPhaseLayer GetBroadPhaseLayer(
+      JPH::ObjectLayer layer) const override;
+#if defined(JPH_EXTERNAL_PROFILE) || defined(JPH_PROFILE_ENABLED)
+  const char *GetBroadPhaseLayerName(
+      JPH::BroadPhaseLayer layer) const override;
+#endif
+};
+
+class ObjectVsBroadPhaseLayerFilterImpl final
+    : public JPH::ObjectVsBroadPhaseLayerFilter {
+ public:
+  bool ShouldCollide(JPH::ObjectLayer layer,
+                     JPH::BroadPhaseLayer broad_phase_layer) const override;
+};
+
+class ObjectLayerPairFilterImpl final : public JPH::ObjectLayerPairFilter {
+ public:
+  bool ShouldCollide(JPH::ObjectLayer left,
+                     JPH::ObjectLayer right) const override;
+};
+
+// Owns a PhysicsSystem together with the layer tables it references, so the
+// tables are guaranteed to outlive the system.
+class JoltWorld {
+ public:
+  explicit JoltWorld(uint32_t max_bodies = 65536);
+
+  JoltWorld(const JoltWorld &) = delete;
+  JoltWorld &operator=(const JoltWorld &) = delete;
+
+  JPH::PhysicsSystem &physics_system() { return physics_system_; }
+  const JPH::PhysicsSystem &physics_system() const { return physics_system_; }
+
+ private:
+  BroadPhaseLayerInterfaceImpl broad_phase_layers_;
+  ObjectVsBroadPhaseLayerFilterImpl object_vs_broad_phase_filter_;
+  ObjectLayerPairFilterImpl object_layer_pair_filter_;
+  JPH::PhysicsSystem physics_system_;
+};
+
+// Adds a static floor and `stack_count` stacks of dynamic boxes. Bodies are
+// created in a fixed order so the resulting BodyIDs are identical between
+// runs, which snapshot replay relies on.
+void BuildDemoScene(JPH::PhysicsSystem *system, int stack_count);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_JOLT_JOLT_WORLD_H_
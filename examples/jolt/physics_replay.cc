@@ -0,0 +1,340 @@
+#include "examples/jolt/physics_replay.h"
+
+#include <Jolt/Physics/Body/BodyID.h>
+#include <Jolt/Physics/StateRecorderImpl.h>
+
+#include "examples/profiling/profile_zones.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <utility>
+
+namespace bando {
+
+namespace {
+
+// File layout (little endian):
+//   char[4]  magic "BPHR"
+//   uint32   version
+//   uint32   scene tag length, followed by the tag bytes
+//   uint32   body count
+//   uint64   snapshot length, followed by the snapshot bytes
+//   uint32   step count, followed by the steps
+// Each step is:
+//   float    delta time
+//   uint8    collision steps
+//   uint64   state hash
+//   uint16   input count, followed by 17 byte inputs
+//            (uint32 body id, uint8 type, float[3] value)
+constexpr char kCaptureMagic[4] = {'B', 'P', 'H', 'R'};
+constexpr uint32_t kCaptureVersion = 1;
+// Encoded sizes used to bound counts read from a file by its remaining
+// bytes.
+constexpr uint64_t kStepHeaderBytes = sizeof(float) + sizeof(uint8_t) +
+                                      sizeof(uint64_t) + sizeof(uint16_t);
+constexpr uint64_t kInputBytes = sizeof(uint32_t) + sizeof(uint8_t) +
+                                 3 * sizeof(float);
+
+template <typename T>
+void WritePod(std::ofstream *file, const T &value) {
+  file->write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadPod(std::ifstream *file, T *value) {
+  file->read(reinterpret_cast<char *>(value), sizeof(T));
+  return file->good();
+}
+
+// Bytes between the read position and `file_size`, 0 on a failed stream.
+uint64_t BytesLeft(std::ifstream *file, uint64_t file_size) {
+  std::streamoff position = file->tellg();
+  if (position < 0 || static_cast<uint64_t>(position) > file_size) {
+    return 0;
+  }
+  return file_size - static_cast<uint64_t>(position);
+}
+
+// `size` comes from the file, so it is checked against the bytes left
+// before anything is allocated.
+bool ReadBytes(std::ifstream *file,
+               uint64_t file_size,
+               uint64_t size,
+               std::string *out) {
+  if (size > BytesLeft(file, file_size)) {
+    return false;
+  }
+  out->resize(static_cast<size_t>(size));
+  if (size == 0) {
+    return true;
+  }
+  file->read(&(*out)[0], static_cast<std::streamsize>(size));
+  return file->good();
+}
+
+uint64_t Fnv1a(const std::string &data) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+bool SetError(std::string *error, const char *message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+}  // namespace
+
+void ApplyPhysicsInput(JPH::BodyInterface *bodies, const PhysicsInput &input) {
+  if (!bodies) {
+    return;
+  }
+  JPH::BodyID body_id(input.body_id);
+  JPH::Vec3 value(input.value[0], input.value[1], input.value[2]);
+  switch (input.type) {
+    case PhysicsInputType::kSetLinearVelocity:
+      bodies->SetLinearVelocity(body_id, value);
+      break;
+    case PhysicsInputType::kSetAngularVelocity:
+      bodies->SetAngularVelocity(body_id, value);
+      break;
+    case PhysicsInputType::kAddForce:
+      bodies->AddForce(body_id, value);
+      break;
+    case PhysicsInputType::kAddImpulse:
+      bodies->AddImpulse(body_id, value);
+      break;
+  }
+}
+
+uint64_t HashPhysicsState(const JPH::PhysicsSystem &system) {
+  BANDO_PROFILE_ZONE("HashPhysicsState");
+  JPH::StateRecorderImpl recorder;
+  system.SaveState(recorder, JPH::EStateRecorderState::Bodies);
+  return Fnv1a(recorder.GetData());
+}
+
+PhysicsRecorder::PhysicsRecorder(JPH::PhysicsSystem *system,
+                                 std::string scene_tag)
+    : system_(system) {
+  capture_.scene_tag = std::move(scene_tag);
+}
+
+void PhysicsRecorder::Begin() {
+  JPH::StateRecorderImpl recorder;
+  system_->SaveState(recorder);
+  capture_.snapshot = recorder.GetData();
+  capture_.body_count = system_->GetNumBodies();
+  capture_.steps.clear();
+  pending_inputs_.clear();
+}
+
+void PhysicsRecorder::AddInput(const PhysicsInput &input) {
+  pending_inputs_.push_back(input);
+}
+
+JPH::EPhysicsUpdateError PhysicsRecorder::Step(
+    float delta_time,
+    int collision_steps,
+    JPH::TempAllocator *temp_allocator,
+    JPH::JobSystem *job_system) {
+  PhysicsStep step;
+  step.delta_time = delta_time;
+  step.collision_steps = static_cast<uint32_t>(collision_steps);
+  step.inputs = std::move(pending_inputs_);
+  pending_inputs_.clear();
+
+  JPH::BodyInterface &bodies = system_->GetBodyInterface();
+  for (const PhysicsInput &input : step.inputs) {
+    ApplyPhysicsInput(&bodies, input);
+  }
+  JPH::EPhysicsUpdateError result = JPH::EPhysicsUpdateError::None;
+  {
+    BANDO_PROFILE_ZONE("PhysicsSystem::Update");
+    result = system_->Update(delta_time, collision_steps, temp_allocator,
+                             job_system);
+  }
+  if (hash_steps_) {
+    step.state_hash = HashPhysicsState(*system_);
+  }
+  capture_.steps.push_back(std::move(step));
+  return result;
+}
+
+bool WritePhysicsCapture(const std::string &path,
+                         const PhysicsCapture &capture,
+                         std::string *error) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return SetError(error, "Failed to open capture file for writing");
+  }
+  file.write(kCaptureMagic, sizeof(kCaptureMagic));
+  WritePod(&file, kCaptureVersion);
+  WritePod(&file, static_cast<uint32_t>(capture.scene_tag.size()));
+  file.write(capture.scene_tag.data(),
+             static_cast<std::streamsize>(capture.scene_tag.size()));
+  WritePod(&file, capture.body_count);
+  WritePod(&file, static_cast<uint64_t>(capture.snapshot.size()));
+  file.write(capture.snapshot.data(),
+             static_cast<std::streamsize>(capture.snapshot.size()));
+  WritePod(&file, static_cast<uint32_t>(capture.steps.size()));
+  for (const PhysicsStep &step : capture.steps) {
+    if (step.collision_steps > std::numeric_limits<uint8_t>::max() ||
+        step.inputs.size() > std::numeric_limits<uint16_t>::max()) {
+      return SetError(error, "Capture step exceeds file format limits");
+    }
+    WritePod(&file, step.delta_time);
+    WritePod(&file, static_cast<uint8_t>(step.collision_steps));
+    WritePod(&file, step.state_hash);
+    WritePod(&file, static_cast<uint16_t>(step.inputs.size()));
+    for (const PhysicsInput &input : step.inputs) {
+      WritePod(&file, input.body_id);
+      WritePod(&file, static_cast<uint8_t>(input.type));
+      file.write(reinterpret_cast<const char *>(input.value),
+                 sizeof(input.value));
+    }
+  }
+  if (!file.good()) {
+    return SetError(error, "Failed to write capture file");
+  }
+  return true;
+}
+
+bool ReadPhysicsCapture(const std::string &path,
+                        PhysicsCapture *capture,
+                        std::string *error) {
+  if (!capture) {
+    return false;
+  }
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return SetError(error, "Failed to open capture file");
+  }
+  std::streamoff end = file.tellg();
+  file.seekg(0);
+  if (end < 0 || !file) {
+    return SetError(error, "Failed to read capture file");
+  }
+  const uint64_t file_size = static_cast<uint64_t>(end);
+  char magic[sizeof(kCaptureMagic)] = {};
+  file.read(magic, sizeof(magic));
+  uint32_t version = 0;
+  if (!file.good() || std::memcmp(magic, kCaptureMagic, sizeof(magic)) != 0 ||
+      !ReadPod(&file, &version)) {
+    return SetError(error, "Not a physics capture file");
+  }
+  if (version != kCaptureVersion) {
+    return SetError(error, "Unsupported physics capture version");
+  }
+  uint32_t tag_size = 0;
+  uint64_t snapshot_size = 0;
+  uint32_t step_count = 0;
+  if (!ReadPod(&file, &tag_size) ||
+      !ReadBytes(&file, file_size, tag_size, &capture->scene_tag) ||
+      !ReadPod(&file, &capture->body_count) ||
+      !ReadPod(&file, &snapshot_size) ||
+      !ReadBytes(&file, file_size, snapshot_size, &capture->snapshot) ||
+      !ReadPod(&file, &step_count)) {
+    return SetError(error, "Truncated physics capture header");
+  }
+  if (step_count > BytesLeft(&file, file_size) / kStepHeaderBytes) {
+    return SetError(error, "Truncated physics capture step");
+  }
+  capture->steps.clear();
+  capture->steps.reserve(step_count);
+  for (uint32_t i = 0; i < step_count; ++i) {
+    PhysicsStep step;
+    uint8_t collision_steps = 0;
+    uint16_t input_count = 0;
+    if (!ReadPod(&file, &step.delta_time) ||
+        !ReadPod(&file, &collision_steps) ||
+        !ReadPod(&file, &step.state_hash) ||
+        !ReadPod(&file, &input_count)) {
+      return SetError(error, "Truncated physics capture step");
+    }
+    if (input_count > BytesLeft(&file, file_size) / kInputBytes) {
+      return SetError(error, "Truncated physics capture input");
+    }
+    step.collision_steps = collision_steps;
+    step.inputs.resize(input_count);
+    for (PhysicsInput &input : step.inputs) {
+      uint8_t type = 0;
+      if (!ReadPod(&file, &input.body_id) || !ReadPod(&file, &type)) {
+        return SetError(error, "Truncated physics capture input");
+      }
+      if (type > static_cast<uint8_t>(PhysicsInputType::kAddImpulse)) {
+        return SetError(error, "Unknown physics capture input type");
+      }
+      input.type = static_cast<PhysicsInputType>(type);
+      file.read(reinterpret_cast<char *>(input.value), sizeof(input.value));
+      if (!file.good()) {
+        return SetError(error, "Truncated physics capture input");
+      }
+    }
+    capture->steps.push_back(std::move(step));
+  }
+  return true;
+}
+
+bool ReplayPhysicsCapture(const PhysicsCapture &capture,
+                          JPH::PhysicsSystem *system,
+                          JPH::TempAllocator *temp_allocator,
+                          JPH::JobSystem *job_system,
+                          ReplayReport *report,
+                          std::string *error) {
+  if (!system || !report) {
+    return false;
+  }
+  if (system->GetNumBodies() != capture.body_count) {
+    return SetError(error, "Scene body count does not match the capture");
+  }
+  JPH::StateRecorderImpl snapshot;
+  snapshot.WriteBytes(capture.snapshot.data(), capture.snapshot.size());
+  snapshot.Rewind();
+  if (!system->RestoreState(snapshot)) {
+    return SetError(error, "Failed to restore physics snapshot");
+  }
+
+  report->step_ms.clear();
+  report->step_ms.reserve(capture.steps.size());
+  report->first_divergent_step = -1;
+  report->failed_step = -1;
+  report->update_error = JPH::EPhysicsUpdateError::None;
+  JPH::BodyInterface &bodies = system->GetBodyInterface();
+  for (size_t i = 0; i < capture.steps.size(); ++i) {
+    const PhysicsStep &step = capture.steps[i];
+    for (const PhysicsInput &input : step.inputs) {
+      ApplyPhysicsInput(&bodies, input);
+    }
+    JPH::EPhysicsUpdateError result = JPH::EPhysicsUpdateError::None;
+    auto start = std::chrono::steady_clock::now();
+    {
+      BANDO_PROFILE_ZONE("ReplayStep");
+      result = system->Update(step.delta_time,
+                              static_cast<int>(step.collision_steps),
+                              temp_allocator, job_system);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (result != JPH::EPhysicsUpdateError::None) {
+      report->failed_step = static_cast<int>(i);
+      report->update_error = result;
+      break;
+    }
+    report->step_ms.push_back(
+        std::chrono::duration<double, std::milli>(end - start).count());
+    if (step.state_hash != 0 && report->first_divergent_step < 0 &&
+        HashPhysicsState(*system) != step.state_hash) {
+      report->first_divergent_step = static_cast<int>(i);
+    }
+  }
+  return true;
+}
+
+}  // namespace bando
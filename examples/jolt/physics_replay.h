@@ -0,0 +1,116 @@
+#ifndef EXAMPLES_JOLT_PHYSICS_REPLAY_H_
+#define EXAMPLES_JOLT_PHYSICS_REPLAY_H_
+
+#include <Jolt/Jolt.h>
+#include <Jolt/Core/JobSystem.h>
+#include <Jolt/Core/TempAllocator.h>
+#include <Jolt/Physics/Body/BodyInterface.h>
+#include <Jolt/Physics/EPhysicsUpdateError.h>
+#include <Jolt/Physics/PhysicsSystem.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bando {
+
+enum class PhysicsInputType : uint8_t {
+  kSetLinearVelocity = 0,
+  kSetAngularVelocity = 1,
+  kAddForce = 2,
+  kAddImpulse = 3,
+};
+
+// A single externally driven change to a body, applied right before the
+// physics step it was recorded with.
+struct PhysicsInput {
+  uint32_t body_id = 0;
+  PhysicsInputType type = PhysicsInputType::kAddImpulse;
+  float value[3] = {0.0f, 0.0f, 0.0f};
+};
+
+struct PhysicsStep {
+  float delta_time = 0.0f;
+  uint32_t collision_steps = 1;
+  std::vector<PhysicsInput> inputs;
+  // Hash of the body state after the step, 0 if it was not recorded.
+  uint64_t state_hash = 0;
+};
+
+// A snapshot of the full simulation state followed by every step taken from
+// it. Bodies are not part of the snapshot: the replaying side has to rebuild
+// the same scene (same bodies, created in the same order) before restoring.
+struct PhysicsCapture {
+  std::string scene_tag;
+  uint32_t body_count = 0;
+  std::string snapshot;
+  std::vector<PhysicsStep> steps;
+};
+
+struct ReplayReport {
+  // Wall time of each PhysicsSystem::Update call, in milliseconds.
+  std::vector<double> step_ms;
+  // Index of the first step whose state hash differs from the capture, or -1
+  // if the replay was bit-exact.
+  int first_divergent_step = -1;
+  // Index of the step whose PhysicsSystem::Update returned `update_error`,
+  // or -1. The replay stops there and records no timing for that step.
+  int failed_step = -1;
+  JPH::EPhysicsUpdateError update_error = JPH::EPhysicsUpdateError::None;
+};
+
+void ApplyPhysicsInput(JPH::BodyInterface *bodies, const PhysicsInput &input);
+
+// FNV-1a hash over the serialized body state of `system`.
+uint64_t HashPhysicsState(const JPH::PhysicsSystem &system);
+
+// Records a snapshot and the inputs of every subsequent step of a running
+// simulation. Inputs added with AddInput are applied and recorded at the next
+// Step call.
+class PhysicsRecorder {
+ public:
+  PhysicsRecorder(JPH::PhysicsSystem *system, std::string scene_tag);
+
+  // Captures the current state as the start of the recording and discards
+  // any previously recorded steps.
+  void Begin();
+  void AddInput(const PhysicsInput &input);
+  JPH::EPhysicsUpdateError Step(float delta_time,
+                                int collision_steps,
+                                JPH::TempAllocator *temp_allocator,
+                                JPH::JobSystem *job_system);
+
+  // Hashing the state after each step lets replays detect divergence but
+  // costs a full state serialization per step. Enabled by default.
+  void set_hash_steps(bool hash_steps) { hash_steps_ = hash_steps; }
+  const PhysicsCapture &capture() const { return capture_; }
+
+ private:
+  JPH::PhysicsSystem *system_;
+  PhysicsCapture capture_;
+  std::vector<PhysicsInput> pending_inputs_;
+  bool hash_steps_ = true;
+};
+
+bool WritePhysicsCapture(const std::string &path,
+                         const PhysicsCapture &capture,
+                         std::string *error);
+bool ReadPhysicsCapture(const std::string &path,
+                        PhysicsCapture *capture,
+                        std::string *error);
+
+// Restores the capture snapshot into `system`, which must already contain the
+// captured scene, then re-runs every step headlessly while timing each
+// PhysicsSystem::Update call. Hashing, when present in the capture, happens
+// outside the timed region. Stops at the first step whose update fails; see
+// ReplayReport::failed_step.
+bool ReplayPhysicsCapture(const PhysicsCapture &capture,
+                          JPH::PhysicsSystem *system,
+                          JPH::TempAllocator *temp_allocator,
+                          JPH::JobSystem *job_system,
+                          ReplayReport *report,
+                          std::string *error);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_JOLT_PHYSICS_REPLAY_H_
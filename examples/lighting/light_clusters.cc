@@ -0,0 +1,401 @@
+#include "examples/lighting/light_clusters.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "examples/profiling/profile_zones.h"
+
+namespace bando {
+
+namespace {
+
+// Lights converted and bounded per WorkerPool range.
+constexpr size_t kLightChunk = 256;
+
+struct GridBoundaries {
+  float slice_scale = 0.0f;
+  float slice_bias = 0.0f;
+  std::vector<float> slice_depths;
+  std::vector<float> tile_x_slopes;
+  std::vector<float> tile_y_slopes;
+};
+
+void ComputeBoundaries(const ClusterGridDesc &desc,
+                       const ClusterCamera &camera,
+                       GridBoundaries *grid) {
+  float near_plane = std::max(camera.near_plane, 1e-4f);
+  float far_plane = std::max(camera.far_plane, near_plane * 1.001f);
+  float log_ratio = std::log(far_plane / near_plane);
+  grid->slice_scale = static_cast<float>(desc.slices) / log_ratio;
+  grid->slice_bias = -std::log(near_plane) * grid->slice_scale;
+  grid->slice_depths.resize(desc.slices + 1);
+  for (int s = 0; s <= desc.slices; ++s) {
+    grid->slice_depths[s] =
+        near_plane * std::exp(log_ratio * static_cast<float>(s) /
+                              static_cast<float>(desc.slices));
+  }
+  grid->tile_x_slopes.resize(desc.tiles_x + 1);
+  for (int x = 0; x <= desc.tiles_x; ++x) {
+    grid->tile_x_slopes[x] =
+        (2.0f * static_cast<float>(x) / static_cast<float>(desc.tiles_x) -
+         1.0f) /
+        camera.x_scale;
+  }
+  // Top of the screen first, so slopes decrease with the tile row.
+  grid->tile_y_slopes.resize(desc.tiles_y + 1);
+  for (int y = 0; y <= desc.tiles_y; ++y) {
+    grid->tile_y_slopes[y] =
+        (1.0f -
+         2.0f * static_cast<float>(y) / static_cast<float>(desc.tiles_y)) /
+        std::fabs(camera.y_scale);
+  }
+}
+
+// View space sphere (x, y, depth along the view direction, radius) around
+// everything the light reaches. Cones narrower than 90 degrees get the
+// smallest sphere around their spherical sector.
+glm::vec4 LightSphere(const Light &light, const glm::mat4 &view) {
+  glm::vec3 center = light.position;
+  float radius = light.range;
+  if (light.type == LightType::kSpot && light.outer_cone_cos > 0.0f) {
+    float cos_outer = std::min(light.outer_cone_cos, 1.0f);
+    if (cos_outer < 0.70710678f) {
+      center += light.direction * (light.range * cos_outer);
+      radius = light.range * std::sqrt(1.0f - cos_outer * cos_outer);
+    } else {
+      radius = light.range / (2.0f * cos_outer);
+      center += light.direction * radius;
+    }
+  }
+  glm::vec4 view_center = view * glm::vec4(center, 1.0f);
+  return glm::vec4(view_center.x, view_center.y, -view_center.z, radius);
+}
+
+GpuLight ToGpuLight(const Light &light) {
+  GpuLight gpu;
+  gpu.position_range = glm::vec4(light.position, light.range);
+  float spot_scale = 1.0f;
+  float cos_outer = -2.0f;
+  glm::vec3 direction(0.0f);
+  if (light.type == LightType::kSpot) {
+    direction = light.direction;
+    cos_outer = light.outer_cone_cos;
+    spot_scale =
+        1.0f / std::max(light.inner_cone_cos - light.outer_cone_cos, 1e-4f);
+  }
+  gpu.color_spot_scale =
+      glm::vec4(light.color * light.intensity, spot_scale);
+  gpu.direction_cos_outer = glm::vec4(direction, cos_outer);
+  return gpu;
+}
+
+// Squared distance from `value` to [low, high].
+float AxisDistanceSquared(float value, float low, float high) {
+  float clamped = std::min(std::max(value, low), high);
+  float distance = value - clamped;
+  return distance * distance;
+}
+
+// View space extent of every tile column (or row) of the slice between
+// `near_depth` and `far_depth`: the tile between boundary slopes k and k + 1
+// spans [bounds[2 * k], bounds[2 * k + 1]].
+void TileBounds(const std::vector<float> &slopes,
+                float near_depth,
+                float far_depth,
+                std::vector<float> *bounds) {
+  bounds->resize(2 * (slopes.size() - 1));
+  for (size_t k = 0; k + 1 < slopes.size(); ++k) {
+    float low = std::min(slopes[k], slopes[k + 1]);
+    float high = std::max(slopes[k], slopes[k + 1]);
+    (*bounds)[2 * k] = std::min(low * near_depth, low * far_depth);
+    (*bounds)[2 * k + 1] = std::max(high * near_depth, high * far_depth);
+  }
+}
+
+// Sphere against a froxel's bounding box, from the squared distances along
+// each axis. The per-axis terms are separable, so both the binner and the
+// reference evaluate exactly this sum.
+bool WithinRadius(float dx2, float dy2, float dz2, float radius_squared) {
+  return dx2 + dy2 + dz2 <= radius_squared;
+}
+
+int ClampIndex(float value, int count) {
+  if (!(value > 0.0f)) {
+    return 0;
+  }
+  return std::min(static_cast<int>(value), count - 1);
+}
+
+// Candidate slice and tile ranges come from continuous grid coordinates
+// (slice or tile index plus fraction). They are padded by a sliver of a
+// cell so rounding never loses a froxel the exact test would accept.
+constexpr float kIndexPadding = 0.01f;
+
+int FirstIndex(float value, int count) {
+  return ClampIndex(value - kIndexPadding, count);
+}
+
+int LastIndex(float value, int count) {
+  return ClampIndex(value + kIndexPadding, count);
+}
+
+}  // namespace
+
+LightClusters::LightClusters(const ClusterGridDesc &desc) : desc_(desc) {
+  desc_.tiles_x = std::max(desc_.tiles_x, 1);
+  desc_.tiles_y = std::max(desc_.tiles_y, 1);
+  desc_.slices = std::max(desc_.slices, 1);
+}
+
+void LightClusters::PrepareLights(const Light *lights,
+                                  size_t begin,
+                                  size_t end) {
+  for (size_t i = begin; i < end; ++i) {
+    gpu_lights_[i] = ToGpuLight(lights[i]);
+    glm::vec4 sphere = LightSphere(lights[i], camera_.view);
+    spheres_[i] = sphere;
+    float nearest = sphere.z - sphere.w;
+    float farthest = sphere.z + sphere.w;
+    if (farthest < slice_depths_.front() || nearest > slice_depths_.back()) {
+      first_slices_[i] = 1;
+      last_slices_[i] = 0;
+      continue;
+    }
+    float first = std::log(std::max(nearest, 1e-6f)) * slice_scale_ +
+                  slice_bias_;
+    float last = std::log(farthest) * slice_scale_ + slice_bias_;
+    first_slices_[i] = FirstIndex(first, desc_.slices);
+    last_slices_[i] = LastIndex(last, desc_.slices);
+  }
+}
+
+void LightClusters::BinSlice(int slice_index) {
+  Slice &slice = slices_[slice_index];
+  slice.hit_froxels.clear();
+  slice.hit_lights.clear();
+  float near_depth = slice_depths_[slice_index];
+  float far_depth = slice_depths_[slice_index + 1];
+  float x_scale = camera_.x_scale;
+  float y_scale = std::fabs(camera_.y_scale);
+  TileBounds(tile_x_slopes_, near_depth, far_depth, &slice.x_bounds);
+  TileBounds(tile_y_slopes_, near_depth, far_depth, &slice.y_bounds);
+  slice.column_distances.resize(desc_.tiles_x);
+  for (uint32_t b = slice_offsets_[slice_index];
+       b < slice_offsets_[slice_index + 1]; ++b) {
+    uint32_t light = slice_lights_[b];
+    const glm::vec4 &sphere = spheres_[light];
+    // Slope ranges the sphere can cover anywhere in the slice give the
+    // candidate tiles.
+    float left = sphere.x - sphere.w;
+    float right = sphere.x + sphere.w;
+    float bottom = sphere.y - sphere.w;
+    float top = sphere.y + sphere.w;
+    float min_x = std::min(left / near_depth, left / far_depth);
+    float max_x = std::max(right / near_depth, right / far_depth);
+    float min_y = std::min(bottom / near_depth, bottom / far_depth);
+    float max_y = std::max(top / near_depth, top / far_depth);
+    int first_x = FirstIndex((min_x * x_scale + 1.0f) * 0.5f * desc_.tiles_x,
+                             desc_.tiles_x);
+    int last_x = LastIndex((max_x * x_scale + 1.0f) * 0.5f * desc_.tiles_x,
+                           desc_.tiles_x);
+    int first_y = FirstIndex((1.0f - max_y * y_scale) * 0.5f * desc_.tiles_y,
+                             desc_.tiles_y);
+    int last_y = LastIndex((1.0f - min_y * y_scale) * 0.5f * desc_.tiles_y,
+                           desc_.tiles_y);
+    float radius_squared = sphere.w * sphere.w;
+    float dz2 = AxisDistanceSquared(sphere.z, near_depth, far_depth);
+    for (int x = first_x; x <= last_x; ++x) {
+      slice.column_distances[x] = AxisDistanceSquared(
+          sphere.x, slice.x_bounds[2 * x], slice.x_bounds[2 * x + 1]);
+    }
+    for (int y = first_y; y <= last_y; ++y) {
+      float dy2 = AxisDistanceSquared(sphere.y, slice.y_bounds[2 * y],
+                                      slice.y_bounds[2 * y + 1]);
+      if (dy2 + dz2 > radius_squared) {
+        continue;
+      }
+      for (int x = first_x; x <= last_x; ++x) {
+        if (WithinRadius(slice.column_distances[x], dy2, dz2,
+                         radius_squared)) {
+          slice.hit_froxels.push_back(
+              static_cast<uint32_t>(y * desc_.tiles_x + x));
+          slice.hit_lights.push_back(light);
+        }
+      }
+    }
+  }
+
+  // Counting sort by froxel. Hits arrive in light order, so every list
+  // stays ascending and the cap drops the highest indices.
+  size_t froxels = static_cast<size_t>(desc_.tiles_x) * desc_.tiles_y;
+  slice.ranges.assign(froxels, ClusterRange());
+  for (uint32_t froxel : slice.hit_froxels) {
+    ++slice.ranges[froxel].count;
+  }
+  uint32_t offset = 0;
+  slice.dropped = 0;
+  for (ClusterRange &range : slice.ranges) {
+    if (range.count > desc_.max_lights_per_cluster) {
+      slice.dropped += range.count - desc_.max_lights_per_cluster;
+      range.count = desc_.max_lights_per_cluster;
+    }
+    range.offset = offset;
+    offset += range.count;
+  }
+  slice.indices.resize(offset);
+  slice.written.assign(froxels, 0);
+  for (size_t h = 0; h < slice.hit_froxels.size(); ++h) {
+    uint32_t froxel = slice.hit_froxels[h];
+    const ClusterRange &range = slice.ranges[froxel];
+    if (slice.written[froxel] < range.count) {
+      slice.indices[range.offset + slice.written[froxel]++] =
+          slice.hit_lights[h];
+    }
+  }
+}
+
+void LightClusters::Build(const Light *lights,
+                          size_t count,
+                          const ClusterCamera &camera,
+                          WorkerPool *pool) {
+  BANDO_PROFILE_ZONE("BuildLightClusters");
+  camera_ = camera;
+  GridBoundaries grid;
+  ComputeBoundaries(desc_, camera_, &grid);
+  slice_scale_ = grid.slice_scale;
+  slice_bias_ = grid.slice_bias;
+  slice_depths_ = std::move(grid.slice_depths);
+  tile_x_slopes_ = std::move(grid.tile_x_slopes);
+  tile_y_slopes_ = std::move(grid.tile_y_slopes);
+
+  gpu_lights_.resize(count);
+  spheres_.resize(count);
+  first_slices_.resize(count);
+  last_slices_.resize(count);
+  auto prepare = [this, lights](size_t begin, size_t end) {
+    PrepareLights(lights, begin, end);
+  };
+  if (pool) {
+    pool->ParallelFor(count, kLightChunk, prepare);
+  } else {
+    prepare(0, count);
+  }
+
+  // Lights of every depth slice, in light order: count, prefix sum, fill.
+  int slice_count = desc_.slices;
+  slice_offsets_.assign(slice_count + 1, 0);
+  for (size_t i = 0; i < count; ++i) {
+    for (int s = first_slices_[i]; s <= last_slices_[i]; ++s) {
+      ++slice_offsets_[s + 1];
+    }
+  }
+  for (int s = 0; s < slice_count; ++s) {
+    slice_offsets_[s + 1] += slice_offsets_[s];
+  }
+  slice_lights_.resize(slice_offsets_[slice_count]);
+  {
+    std::vector<uint32_t> fill(slice_offsets_.begin(),
+                               slice_offsets_.end() - 1);
+    for (size_t i = 0; i < count; ++i) {
+      for (int s = first_slices_[i]; s <= last_slices_[i]; ++s) {
+        slice_lights_[fill[s]++] = static_cast<uint32_t>(i);
+      }
+    }
+  }
+
+  slices_.resize(slice_count);
+  auto bin = [this](size_t begin, size_t end) {
+    for (size_t s = begin; s < end; ++s) {
+      BinSlice(static_cast<int>(s));
+    }
+  };
+  if (pool) {
+    pool->ParallelFor(static_cast<size_t>(slice_count), 1, bin);
+  } else {
+    bin(0, static_cast<size_t>(slice_count));
+  }
+
+  // Concatenate the slices' lists in slice order.
+  std::vector<uint32_t> bases(slice_count + 1, 0);
+  dropped_ = 0;
+  for (int s = 0; s < slice_count; ++s) {
+    bases[s + 1] =
+        bases[s] + static_cast<uint32_t>(slices_[s].indices.size());
+    dropped_ += slices_[s].dropped;
+  }
+  light_indices_.resize(bases[slice_count]);
+  clusters_.resize(cluster_count());
+  size_t froxels = static_cast<size_t>(desc_.tiles_x) * desc_.tiles_y;
+  auto gather = [this, &bases, froxels](size_t begin, size_t end) {
+    for (size_t s = begin; s < end; ++s) {
+      const Slice &slice = slices_[s];
+      if (!slice.indices.empty()) {
+        std::memcpy(&light_indices_[bases[s]], slice.indices.data(),
+                    slice.indices.size() * sizeof(uint32_t));
+      }
+      for (size_t f = 0; f < froxels; ++f) {
+        ClusterRange &range = clusters_[s * froxels + f];
+        range.offset = slice.ranges[f].offset + bases[s];
+        range.count = slice.ranges[f].count;
+      }
+    }
+  };
+  if (pool) {
+    pool->ParallelFor(static_cast<size_t>(slice_count), 1, gather);
+  } else {
+    gather(0, static_cast<size_t>(slice_count));
+  }
+}
+
+namespace light_clusters_scalar {
+
+void BuildClusters(const ClusterGridDesc &desc,
+                   const Light *lights,
+                   size_t count,
+                   const ClusterCamera &camera,
+                   std::vector<ClusterRange> *clusters,
+                   std::vector<uint32_t> *light_indices) {
+  GridBoundaries grid;
+  ComputeBoundaries(desc, camera, &grid);
+  std::vector<glm::vec4> spheres(count);
+  for (size_t i = 0; i < count; ++i) {
+    spheres[i] = LightSphere(lights[i], camera.view);
+  }
+  clusters->clear();
+  light_indices->clear();
+  std::vector<float> x_bounds;
+  std::vector<float> y_bounds;
+  for (int s = 0; s < desc.slices; ++s) {
+    float near_depth = grid.slice_depths[s];
+    float far_depth = grid.slice_depths[s + 1];
+    TileBounds(grid.tile_x_slopes, near_depth, far_depth, &x_bounds);
+    TileBounds(grid.tile_y_slopes, near_depth, far_depth, &y_bounds);
+    for (int y = 0; y < desc.tiles_y; ++y) {
+      for (int x = 0; x < desc.tiles_x; ++x) {
+        ClusterRange range;
+        range.offset = static_cast<uint32_t>(light_indices->size());
+        for (size_t i = 0; i < count; ++i) {
+          const glm::vec4 &sphere = spheres[i];
+          if (range.count < desc.max_lights_per_cluster &&
+              WithinRadius(
+                  AxisDistanceSquared(sphere.x, x_bounds[2 * x],
+                                      x_bounds[2 * x + 1]),
+                  AxisDistanceSquared(sphere.y, y_bounds[2 * y],
+                                      y_bounds[2 * y + 1]),
+                  AxisDistanceSquared(sphere.z, near_depth, far_depth),
+                  sphere.w * sphere.w)) {
+            light_indices->push_back(static_cast<uint32_t>(i));
+            ++range.count;
+          }
+        }
+        clusters->push_back(range);
+      }
+    }
+  }
+}
+
+}  // namespace light_clusters_scalar
+
+}  // namespace bando
@@ -0,0 +1,177 @@
+#ifndef EXAMPLES_LIGHTING_LIGHT_CLUSTERS_H_
+#define EXAMPLES_LIGHTING_LIGHT_CLUSTERS_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "examples/jobs/worker_pool.h"
+
+// Clustered forward lighting: the view frustum is cut into a 3D grid of
+// froxels (screen tiles times exponentially spaced depth slices) and every
+// frame each froxel gets the list of point and spot lights whose bounding
+// sphere touches it. A fragment then looks up its froxel from its window
+// position and depth and shades only those lights.
+//
+// Build() runs on a WorkerPool in three passes: lights are converted and
+// bounded in parallel, binned by the depth slices they span, then every
+// slice tests its lights against its own froxels independently and writes
+// compact per-froxel index lists, which are finally concatenated in slice
+// order. Lists keep lights in ascending index order, so the output does
+// not depend on the thread count.
+//
+// The froxel of depth slice s and screen tile (x, y), with y counted from
+// the top of the screen, is clusters()[(s * tiles_y + y) * tiles_x + x];
+// its lights are light_indices()[offset, offset + count), which index
+// gpu_lights().
+
+namespace bando {
+
+enum class LightType : uint8_t {
+  kPoint,
+  kSpot,
+};
+
+struct Light {
+  LightType type = LightType::kPoint;
+  glm::vec3 position = glm::vec3(0.0f);
+  // Distance at which the light fades out completely.
+  float range = 1.0f;
+  glm::vec3 color = glm::vec3(1.0f);
+  float intensity = 1.0f;
+  // Spot lights only: normalized direction and cone angle cosines.
+  glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+  float inner_cone_cos = 0.9f;
+  float outer_cone_cos = 0.8f;
+};
+
+// std430 storage buffer entry (see hello_3d.frag). Positions and
+// directions stay in world space; the cone factor is
+// clamp((dot(-L, direction) - cos_outer) * spot_scale, 0, 1), which point
+// lights pass with direction 0 and cos_outer -2.
+struct alignas(16) GpuLight {
+  glm::vec4 position_range;
+  glm::vec4 color_spot_scale;
+  glm::vec4 direction_cos_outer;
+};
+
+// std430 uvec2.
+struct ClusterRange {
+  uint32_t offset = 0;
+  uint32_t count = 0;
+};
+
+struct ClusterGridDesc {
+  int tiles_x = 16;
+  int tiles_y = 9;
+  int slices = 24;
+  // Lights beyond this per froxel are dropped (highest indices first),
+  // which bounds the index buffer at cluster_count() * this.
+  uint32_t max_lights_per_cluster = 128;
+};
+
+// Camera the grid is built for. `x_scale` and `y_scale` are projection[0][0]
+// and projection[1][1] of a standard perspective matrix; the sign of
+// y_scale is ignored, so Y-flipped projections work unchanged.
+struct ClusterCamera {
+  glm::mat4 view = glm::mat4(1.0f);
+  float x_scale = 1.0f;
+  float y_scale = 1.0f;
+  float near_plane = 0.1f;
+  float far_plane = 100.0f;
+};
+
+class LightClusters {
+ public:
+  explicit LightClusters(const ClusterGridDesc &desc = ClusterGridDesc());
+
+  LightClusters(const LightClusters &) = delete;
+  LightClusters &operator=(const LightClusters &) = delete;
+
+  const ClusterGridDesc &desc() const { return desc_; }
+  size_t cluster_count() const {
+    return static_cast<size_t>(desc_.tiles_x) * desc_.tiles_y *
+           desc_.slices;
+  }
+
+  // Rebuilds everything for `count` lights. `pool` may be null.
+  void Build(const Light *lights,
+             size_t count,
+             const ClusterCamera &camera,
+             WorkerPool *pool);
+
+  const std::vector<GpuLight> &gpu_lights() const { return gpu_lights_; }
+  const std::vector<ClusterRange> &clusters() const { return clusters_; }
+  const std::vector<uint32_t> &light_indices() const {
+    return light_indices_;
+  }
+  // Froxel light references dropped by max_lights_per_cluster.
+  size_t dropped() const { return dropped_; }
+
+  // The depth slice of view depth d (distance along the view direction) is
+  // floor(log(d) * slice_scale() + slice_bias()), clamped to the grid.
+  float slice_scale() const { return slice_scale_; }
+  float slice_bias() const { return slice_bias_; }
+
+ private:
+  struct Slice {
+    // Every (froxel within the slice, light) hit in light order, then the
+    // slice's compact lists and per-froxel ranges relative to them.
+    std::vector<uint32_t> hit_froxels;
+    std::vector<uint32_t> hit_lights;
+    std::vector<uint32_t> indices;
+    std::vector<ClusterRange> ranges;
+    std::vector<uint32_t> written;
+    size_t dropped = 0;
+    // Tile bounds of the slice and one light's squared column distances.
+    std::vector<float> x_bounds;
+    std::vector<float> y_bounds;
+    std::vector<float> column_distances;
+  };
+
+  void PrepareLights(const Light *lights, size_t begin, size_t end);
+  void BinSlice(int slice);
+
+  ClusterGridDesc desc_;
+  ClusterCamera camera_;
+  float slice_scale_ = 0.0f;
+  float slice_bias_ = 0.0f;
+  // View depth at every slice boundary and view x / depth, y / depth at
+  // every tile boundary.
+  std::vector<float> slice_depths_;
+  std::vector<float> tile_x_slopes_;
+  std::vector<float> tile_y_slopes_;
+
+  // View space bounding sphere (x, y, depth, radius) and depth slice span of
+  // every light.
+  std::vector<glm::vec4> spheres_;
+  std::vector<int> first_slices_;
+  std::vector<int> last_slices_;
+  std::vector<uint32_t> slice_offsets_;
+  std::vector<uint32_t> slice_lights_;
+  std::vector<Slice> slices_;
+
+  std::vector<GpuLight> gpu_lights_;
+  std::vector<ClusterRange> clusters_;
+  std::vector<uint32_t> light_indices_;
+  size_t dropped_ = 0;
+};
+
+namespace light_clusters_scalar {
+
+// Brute force reference: every light against every froxel, same ordering
+// and cap as LightClusters.
+void BuildClusters(const ClusterGridDesc &desc,
+                   const Light *lights,
+                   size_t count,
+                   const ClusterCamera &camera,
+                   std::vector<ClusterRange> *clusters,
+                   std::vector<uint32_t> *light_indices);
+
+}  // namespace light_clusters_scalar
+
+}  // namespace bando
+
+#endif  // EXAMPLES_LIGHTING_LIGHT_CLUSTERS_H_
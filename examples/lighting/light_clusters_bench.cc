@@ -0,0 +1,169 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "examples/bench/bench_harness.h"
+#include "examples/jobs/worker_pool.h"
+#include "examples/lighting/light_clusters.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Clustered light binning benchmarks on a field of point and spot lights
+// scattered around a camera. The threaded build is checked against the
+// brute force reference, with and without the per-cluster cap, before any
+// benchmark runs:
+//   bazel run -c opt //examples/lighting:light_clusters_bench
+
+namespace {
+
+constexpr float kFieldSize = 80.0f;
+
+// Every fourth light is a spot light pointing in a random direction.
+std::vector<bando::Light> MakeLights(size_t count) {
+  std::vector<bando::Light> lights(count);
+  uint32_t state = 7u;
+  for (size_t i = 0; i < count; ++i) {
+    bando::Light &light = lights[i];
+    light.position =
+        glm::vec3((bando::NextUnit(&state) - 0.5f) * kFieldSize,
+                  bando::NextUnit(&state) * 8.0f,
+                  (bando::NextUnit(&state) - 0.5f) * kFieldSize);
+    light.range = 1.0f + 4.0f * bando::NextUnit(&state);
+    light.color = glm::vec3(bando::NextUnit(&state), bando::NextUnit(&state),
+                            bando::NextUnit(&state));
+    if (i % 4 == 3) {
+      light.type = bando::LightType::kSpot;
+      light.direction = glm::normalize(
+          glm::vec3(bando::NextUnit(&state) - 0.5f, -bando::NextUnit(&state),
+                    bando::NextUnit(&state) - 0.5f) +
+          glm::vec3(0.0f, -0.1f, 0.0f));
+      light.outer_cone_cos = 0.2f + 0.75f * bando::NextUnit(&state);
+      light.inner_cone_cos = light.outer_cone_cos + 0.04f;
+    }
+  }
+  return lights;
+}
+
+bando::ClusterCamera MakeCamera() {
+  glm::mat4 projection = glm::perspectiveRH_ZO(
+      glm::radians(60.0f), 16.0f / 9.0f, 0.1f, kFieldSize);
+  bando::ClusterCamera camera;
+  camera.view = glm::lookAt(glm::vec3(0.0f, 3.0f, kFieldSize * 0.5f),
+                            glm::vec3(0.0f, 1.0f, 0.0f),
+                            glm::vec3(0.0f, 1.0f, 0.0f));
+  camera.x_scale = projection[0][0];
+  // Flipped like a Vulkan-style projection; only the magnitude is used.
+  camera.y_scale = -projection[1][1];
+  camera.near_plane = 0.1f;
+  camera.far_plane = kFieldSize;
+  return camera;
+}
+
+bool Matches(const bando::LightClusters &clusters,
+             const std::vector<bando::ClusterRange> &reference_clusters,
+             const std::vector<uint32_t> &reference_indices,
+             const char *name) {
+  if (clusters.clusters().size() != reference_clusters.size() ||
+      clusters.light_indices() != reference_indices) {
+    std::printf("%s: %zu light references, reference %zu\n", name,
+                clusters.light_indices().size(), reference_indices.size());
+    return false;
+  }
+  for (size_t i = 0; i < reference_clusters.size(); ++i) {
+    if (clusters.clusters()[i].offset != reference_clusters[i].offset ||
+        clusters.clusters()[i].count != reference_clusters[i].count) {
+      std::printf("%s: cluster %zu differs from the reference\n", name, i);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Verify() {
+  std::vector<bando::Light> lights = MakeLights(1024);
+  bando::ClusterCamera camera = MakeCamera();
+  bando::WorkerPool pool(4);
+
+  for (uint32_t cap : {128u, 6u}) {
+    bando::ClusterGridDesc desc;
+    desc.max_lights_per_cluster = cap;
+    bando::LightClusters threaded(desc);
+    bando::LightClusters serial(desc);
+    threaded.Build(lights.data(), lights.size(), camera, &pool);
+    serial.Build(lights.data(), lights.size(), camera, nullptr);
+    std::vector<bando::ClusterRange> reference_clusters;
+    std::vector<uint32_t> reference_indices;
+    bando::light_clusters_scalar::BuildClusters(
+        desc, lights.data(), lights.size(), camera, &reference_clusters,
+        &reference_indices);
+    if (!Matches(threaded, reference_clusters, reference_indices,
+                 "Threaded") ||
+        !Matches(serial, reference_clusters, reference_indices, "Serial")) {
+      return false;
+    }
+    if (reference_indices.empty() || (cap < 128u) != (threaded.dropped() > 0)) {
+      std::printf("%zu light references with %zu dropped at cap %u\n",
+                  reference_indices.size(), threaded.dropped(), cap);
+      return false;
+    }
+    size_t occupied = 0;
+    for (const bando::ClusterRange &range : threaded.clusters()) {
+      occupied += range.count > 0 ? 1 : 0;
+    }
+    std::printf("Cap %u: %zu light references in %zu of %zu clusters, "
+                "%zu dropped\n",
+                cap, reference_indices.size(), occupied,
+                threaded.cluster_count(), threaded.dropped());
+  }
+  return true;
+}
+
+// Binning range(0) lights on range(1) threads (0: all cores).
+void BM_BuildLightClusters(benchmark::State &state) {
+  std::vector<bando::Light> lights =
+      MakeLights(static_cast<size_t>(state.range(0)));
+  bando::ClusterCamera camera = MakeCamera();
+  bando::WorkerPool pool(static_cast<int>(state.range(1)));
+  bando::LightClusters clusters;
+  for (auto _ : state) {
+    clusters.Build(lights.data(), lights.size(), camera, &pool);
+    benchmark::DoNotOptimize(clusters.light_indices().data());
+  }
+  bando::SetItemsProcessed(state, static_cast<size_t>(state.range(0)));
+  state.counters["threads"] = static_cast<double>(pool.thread_count());
+  state.counters["references"] =
+      static_cast<double>(clusters.light_indices().size());
+}
+
+void BM_BuildLightClustersReference(benchmark::State &state) {
+  std::vector<bando::Light> lights =
+      MakeLights(static_cast<size_t>(state.range(0)));
+  bando::ClusterCamera camera = MakeCamera();
+  bando::ClusterGridDesc desc;
+  std::vector<bando::ClusterRange> clusters;
+  std::vector<uint32_t> indices;
+  for (auto _ : state) {
+    bando::light_clusters_scalar::BuildClusters(
+        desc, lights.data(), lights.size(), camera, &clusters, &indices);
+    benchmark::DoNotOptimize(indices.data());
+  }
+  bando::SetItemsProcessed(state, static_cast<size_t>(state.range(0)));
+}
+
+BENCHMARK(BM_BuildLightClusters)
+    ->ArgsProduct({{256, 1024, 4096, 16384}, {1, 0}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK(BM_BuildLightClustersReference)
+    ->Arg(1024)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  return bando::RunVerifiedBenchmarks(argc, argv, "Light clustering", Verify);
+}
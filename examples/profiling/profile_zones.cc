@@ -0,0 +1,146 @@
+#include "examples/profiling/profile_zones.h"
+
+#if defined(BANDO_PROFILING)
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+
+namespace bando {
+
+namespace {
+
+struct ProfileEvent {
+  const char *name;
+  int64_t start_ns;
+  int64_t end_ns;
+};
+
+// Events are appended by the owning thread only. `count` is published with
+// release semantics after the event is written, so the exporter can read any
+// event below an acquired count without locking.
+struct ProfileChunk {
+  static constexpr uint32_t kCapacity = 4096;
+  ProfileEvent events[kCapacity];
+  std::atomic<uint32_t> count{0};
+  std::atomic<ProfileChunk *> next{nullptr};
+};
+
+// One per thread that recorded a zone. Buffers are linked into a global list
+// and intentionally never freed, so zones of threads that already exited are
+// still exported.
+struct ThreadBuffer {
+  uint32_t thread_id = 0;
+  std::atomic<const char *> name{nullptr};
+  ProfileChunk *head = nullptr;
+  ProfileChunk *tail = nullptr;
+  ThreadBuffer *next = nullptr;
+};
+
+std::atomic<ThreadBuffer *> g_buffers{nullptr};
+std::atomic<uint32_t> g_next_thread_id{1};
+const std::chrono::steady_clock::time_point g_epoch =
+    std::chrono::steady_clock::now();
+
+ThreadBuffer *CurrentBuffer() {
+  thread_local ThreadBuffer *buffer = [] {
+    ThreadBuffer *created = new ThreadBuffer();
+    created->thread_id = g_next_thread_id.fetch_add(1);
+    created->head = new ProfileChunk();
+    created->tail = created->head;
+    created->next = g_buffers.load(std::memory_order_relaxed);
+    while (!g_buffers.compare_exchange_weak(created->next, created,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed)) {
+    }
+    return created;
+  }();
+  return buffer;
+}
+
+void WriteEscaped(std::FILE *file, const char *text) {
+  for (const char *c = text; *c; ++c) {
+    if (*c == '"' || *c == '\\') {
+      std::fputc('\\', file);
+    }
+    std::fputc(*c, file);
+  }
+}
+
+}  // namespace
+
+int64_t ProfileNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - g_epoch)
+      .count();
+}
+
+void RecordProfileZone(const char *name, int64_t start_ns, int64_t end_ns) {
+  ThreadBuffer *buffer = CurrentBuffer();
+  ProfileChunk *chunk = buffer->tail;
+  uint32_t count = chunk->count.load(std::memory_order_relaxed);
+  if (count == ProfileChunk::kCapacity) {
+    ProfileChunk *fresh = new ProfileChunk();
+    chunk->next.store(fresh, std::memory_order_release);
+    buffer->tail = fresh;
+    chunk = fresh;
+    count = 0;
+  }
+  chunk->events[count] = ProfileEvent{name, start_ns, end_ns};
+  chunk->count.store(count + 1, std::memory_order_release);
+}
+
+void SetProfileThreadName(const char *name) {
+  CurrentBuffer()->name.store(name, std::memory_order_release);
+}
+
+bool WriteChromeTrace(const std::string &path, std::string *error) {
+  std::FILE *file = std::fopen(path.c_str(), "w");
+  if (!file) {
+    if (error) {
+      *error = "Failed to open trace file: " + path;
+    }
+    return false;
+  }
+  std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+  bool first = true;
+  for (ThreadBuffer *buffer = g_buffers.load(std::memory_order_acquire);
+       buffer; buffer = buffer->next) {
+    if (const char *name = buffer->name.load(std::memory_order_acquire)) {
+      std::fprintf(file,
+                   "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                   "\"tid\":%u,\"args\":{\"name\":\"",
+                   first ? "" : ",", buffer->thread_id);
+      WriteEscaped(file, name);
+      std::fputs("\"}}", file);
+      first = false;
+    }
+    for (ProfileChunk *chunk = buffer->head; chunk;
+         chunk = chunk->next.load(std::memory_order_acquire)) {
+      uint32_t count = chunk->count.load(std::memory_order_acquire);
+      for (uint32_t i = 0; i < count; ++i) {
+        const ProfileEvent &event = chunk->events[i];
+        // Chrome traces use microseconds; keep nanosecond precision in the
+        // fractional part.
+        std::fprintf(file, "%s\n{\"name\":\"", first ? "" : ",");
+        WriteEscaped(file, event.name);
+        std::fprintf(file,
+                     "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                     "\"dur\":%.3f}",
+                     buffer->thread_id, event.start_ns / 1000.0,
+                     (event.end_ns - event.start_ns) / 1000.0);
+        first = false;
+      }
+    }
+  }
+  std::fputs("\n]}\n", file);
+  bool ok = std::fclose(file) == 0;
+  if (!ok && error) {
+    *error = "Failed to write trace file: " + path;
+  }
+  return ok;
+}
+
+}  // namespace bando
+
+#endif  // BANDO_PROFILING
@@ -0,0 +1,67 @@
+#ifndef EXAMPLES_PROFILING_PROFILE_ZONES_H_
+#define EXAMPLES_PROFILING_PROFILE_ZONES_H_
+
+#include <cstdint>
+#include <string>
+
+// Scoped timing zones recorded into per-thread buffers and exported as
+// Chrome trace_event JSON (open in Perfetto or chrome://tracing).
+//
+// Zones are only recorded when BANDO_PROFILING is defined, which the
+// //examples/profiling:profile_zones target does under
+// --define=bando_profiling=1. Otherwise the macros expand to nothing and the
+// export functions are inline no-ops.
+//
+// Zone and thread names must be string literals or otherwise outlive the
+// export; only the pointer is stored.
+
+#define BANDO_PROFILE_CONCAT_INNER(a, b) a##b
+#define BANDO_PROFILE_CONCAT(a, b) BANDO_PROFILE_CONCAT_INNER(a, b)
+
+namespace bando {
+
+#if defined(BANDO_PROFILING)
+
+int64_t ProfileNowNs();
+void RecordProfileZone(const char *name, int64_t start_ns, int64_t end_ns);
+void SetProfileThreadName(const char *name);
+// Writes every zone recorded so far. Safe to call while other threads keep
+// recording; zones that finish during the export may or may not be included.
+bool WriteChromeTrace(const std::string &path, std::string *error);
+
+class ProfileZone {
+ public:
+  explicit ProfileZone(const char *name)
+      : name_(name), start_ns_(ProfileNowNs()) {}
+  ~ProfileZone() { RecordProfileZone(name_, start_ns_, ProfileNowNs()); }
+
+  ProfileZone(const ProfileZone &) = delete;
+  ProfileZone &operator=(const ProfileZone &) = delete;
+
+ private:
+  const char *name_;
+  int64_t start_ns_;
+};
+
+#define BANDO_PROFILE_ZONE(name)                                 \
+  ::bando::ProfileZone BANDO_PROFILE_CONCAT(bando_profile_zone_, \
+                                            __COUNTER__)(name)
+#define BANDO_PROFILE_THREAD_NAME(name) ::bando::SetProfileThreadName(name)
+
+#else
+
+inline bool WriteChromeTrace(const std::string &, std::string *error) {
+  if (error) {
+    *error = "Profiling is disabled; rebuild with --define=bando_profiling=1";
+  }
+  return false;
+}
+
+#define BANDO_PROFILE_ZONE(name) (void)0
+#define BANDO_PROFILE_THREAD_NAME(name) (void)0
+
+#endif
+
+}  // namespace bando
+
+#endif  // EXAMPLES_PROFILING_PROFILE_ZONES_H_
@@ -0,0 +1,273 @@
+#include "examples/scene_graph/scene_graph.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <limits>
+
+#include "examples/profiling/profile_zones.h"
+
+namespace bando {
+
+namespace {
+
+// Dirty node totals below this are cheaper to recompute on the calling
+// thread than to wake the pool for.
+constexpr size_t kSerialNodes = 4096;
+// Smallest range worth handing to a worker.
+constexpr size_t kMinJobNodes = 1024;
+
+bool SetError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+// parent * T * R * S without the full 4x4 product: the local matrix has a
+// (0, 0, 0, 1) bottom row, so each world column is a combination of the
+// parent's columns.
+glm::mat4 ComposeWorld(const glm::mat4 &parent,
+                       const glm::vec3 &translation,
+                       const glm::quat &rotation,
+                       const glm::vec3 &scale) {
+  glm::mat3 basis = glm::mat3_cast(rotation);
+  glm::mat4 world;
+  for (int column = 0; column < 3; ++column) {
+    glm::vec3 axis = basis[column] * scale[column];
+    world[column] =
+        parent[0] * axis.x + parent[1] * axis.y + parent[2] * axis.z;
+  }
+  world[3] = parent[0] * translation.x + parent[1] * translation.y +
+             parent[2] * translation.z + parent[3];
+  return world;
+}
+
+}  // namespace
+
+bool SceneGraph::Build(const std::vector<SceneGraphNode> &nodes,
+                       std::vector<uint32_t> *node_index,
+                       std::string *error) {
+  BANDO_PROFILE_ZONE("BuildSceneGraph");
+  size_t count = nodes.size();
+  if (count >= std::numeric_limits<uint32_t>::max()) {
+    return SetError(error, "Scene graph has too many nodes");
+  }
+  // Children of every node, back to back in input order.
+  std::vector<uint32_t> child_offsets(count + 1, 0);
+  std::vector<uint32_t> roots;
+  for (size_t i = 0; i < count; ++i) {
+    int parent = nodes[i].parent;
+    if (parent < -1 || parent >= static_cast<int>(count)) {
+      return SetError(error, "Scene graph node " + std::to_string(i) +
+                                 " has an out of range parent");
+    }
+    if (parent < 0) {
+      roots.push_back(static_cast<uint32_t>(i));
+    } else {
+      ++child_offsets[parent + 1];
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    child_offsets[i + 1] += child_offsets[i];
+  }
+  std::vector<uint32_t> children(count - roots.size());
+  std::vector<uint32_t> fill(child_offsets.begin(), child_offsets.end() - 1);
+  for (size_t i = 0; i < count; ++i) {
+    if (nodes[i].parent >= 0) {
+      children[fill[nodes[i].parent]++] = static_cast<uint32_t>(i);
+    }
+  }
+
+  // Depth-first preorder, pushing children in reverse so siblings keep
+  // their input order.
+  std::vector<uint32_t> order;
+  order.reserve(count);
+  std::vector<uint32_t> stack(roots.rbegin(), roots.rend());
+  while (!stack.empty()) {
+    uint32_t input = stack.back();
+    stack.pop_back();
+    order.push_back(input);
+    for (uint32_t c = child_offsets[input + 1]; c > child_offsets[input];
+         --c) {
+      stack.push_back(children[c - 1]);
+    }
+  }
+  // Every node has at most one parent, so nodes the walk from the roots
+  // misses sit on a cycle.
+  if (order.size() != count) {
+    return SetError(error, "Scene graph has a cycle");
+  }
+
+  std::vector<uint32_t> index(count);
+  for (size_t g = 0; g < count; ++g) {
+    index[order[g]] = static_cast<uint32_t>(g);
+  }
+  parents_.resize(count);
+  translations_.resize(count);
+  rotations_.resize(count);
+  scales_.resize(count);
+  worlds_.assign(count, glm::mat4(1.0f));
+  for (size_t g = 0; g < count; ++g) {
+    const SceneGraphNode &node = nodes[order[g]];
+    parents_[g] = node.parent < 0 ? -1 : static_cast<int>(index[node.parent]);
+    translations_[g] = node.translation;
+    rotations_[g] = node.rotation;
+    scales_[g] = node.scale;
+  }
+  // Parents precede children, so walking backwards accumulates subtree
+  // sizes bottom up.
+  std::vector<uint32_t> sizes(count, 1);
+  for (size_t g = count; g-- > 0;) {
+    if (parents_[g] >= 0) {
+      sizes[parents_[g]] += sizes[g];
+    }
+  }
+  subtree_ends_.resize(count);
+  for (size_t g = 0; g < count; ++g) {
+    subtree_ends_[g] = static_cast<uint32_t>(g) + sizes[g];
+  }
+
+  dirty_.assign(count, 0);
+  dirty_nodes_.clear();
+  updated_ranges_.clear();
+  for (uint32_t root : roots) {
+    MarkDirty(index[root]);
+  }
+  if (node_index) {
+    node_index->swap(index);
+  }
+  return true;
+}
+
+void SceneGraph::SetTranslation(uint32_t node, const glm::vec3 &translation) {
+  translations_[node] = translation;
+  MarkDirty(node);
+}
+
+void SceneGraph::SetRotation(uint32_t node, const glm::quat &rotation) {
+  rotations_[node] = rotation;
+  MarkDirty(node);
+}
+
+void SceneGraph::SetScale(uint32_t node, const glm::vec3 &scale) {
+  scales_[node] = scale;
+  MarkDirty(node);
+}
+
+void SceneGraph::SetLocal(uint32_t node,
+                          const glm::vec3 &translation,
+                          const glm::quat &rotation,
+                          const glm::vec3 &scale) {
+  translations_[node] = translation;
+  rotations_[node] = rotation;
+  scales_[node] = scale;
+  MarkDirty(node);
+}
+
+void SceneGraph::MarkDirty(uint32_t node) {
+  if (!dirty_[node]) {
+    dirty_[node] = 1;
+    dirty_nodes_.push_back(node);
+  }
+}
+
+void SceneGraph::ComputeWorlds(uint32_t begin, uint32_t end) {
+  static const glm::mat4 kIdentity(1.0f);
+  for (uint32_t i = begin; i < end; ++i) {
+    int parent = parents_[i];
+    worlds_[i] = ComposeWorld(parent < 0 ? kIdentity : worlds_[parent],
+                              translations_[i], rotations_[i], scales_[i]);
+  }
+}
+
+void SceneGraph::SplitRange(SceneGraphRange range, size_t max_nodes) {
+  // Pending subtrees too big for one job. Each one's root is computed here,
+  // on the calling thread, which makes its child subtrees independent of
+  // each other; runs of small siblings are then batched into jobs.
+  std::vector<SceneGraphRange> pending(1, range);
+  while (!pending.empty()) {
+    SceneGraphRange subtree = pending.back();
+    pending.pop_back();
+    if (subtree.end - subtree.begin <= max_nodes) {
+      jobs_.push_back(subtree);
+      continue;
+    }
+    ComputeWorlds(subtree.begin, subtree.begin + 1);
+    uint32_t run_begin = subtree.begin + 1;
+    uint32_t child = run_begin;
+    while (child < subtree.end) {
+      uint32_t child_end = subtree_ends_[child];
+      if (child_end - child > max_nodes) {
+        if (run_begin < child) {
+          jobs_.push_back({run_begin, child});
+        }
+        pending.push_back({child, child_end});
+        run_begin = child_end;
+      } else if (child_end - run_begin > max_nodes) {
+        jobs_.push_back({run_begin, child});
+        run_begin = child;
+      }
+      child = child_end;
+    }
+    if (run_begin < subtree.end) {
+      jobs_.push_back({run_begin, subtree.end});
+    }
+  }
+}
+
+void SceneGraph::Update(WorkerPool *pool) {
+  updated_ranges_.clear();
+  if (dirty_nodes_.empty()) {
+    return;
+  }
+  BANDO_PROFILE_ZONE("UpdateSceneGraph");
+  // In depth-first order a dirty node inside an earlier dirty subtree is
+  // covered by it; every other one starts a new disjoint range.
+  std::sort(dirty_nodes_.begin(), dirty_nodes_.end());
+  uint32_t covered_end = 0;
+  size_t total = 0;
+  for (uint32_t node : dirty_nodes_) {
+    dirty_[node] = 0;
+    if (node < covered_end) {
+      continue;
+    }
+    covered_end = subtree_ends_[node];
+    updated_ranges_.push_back({node, covered_end});
+    total += covered_end - node;
+  }
+  dirty_nodes_.clear();
+
+  size_t threads = pool ? pool->thread_count() : 1;
+  if (threads == 1 || total <= kSerialNodes) {
+    for (const SceneGraphRange &range : updated_ranges_) {
+      ComputeWorlds(range.begin, range.end);
+    }
+    return;
+  }
+  // A few jobs per thread so uneven subtrees still balance.
+  size_t max_nodes = std::max(kMinJobNodes, total / (threads * 4));
+  jobs_.clear();
+  for (const SceneGraphRange &range : updated_ranges_) {
+    SplitRange(range, max_nodes);
+  }
+  pool->ParallelFor(jobs_.size(), 1, [this](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      ComputeWorlds(jobs_[i].begin, jobs_[i].end);
+    }
+  });
+}
+
+void ComputeAllWorlds(const SceneGraph &graph,
+                      std::vector<glm::mat4> *worlds) {
+  worlds->resize(graph.size());
+  for (uint32_t i = 0; i < graph.size(); ++i) {
+    glm::mat4 local = glm::translate(glm::mat4(1.0f), graph.translation(i)) *
+                      glm::mat4_cast(graph.rotation(i)) *
+                      glm::scale(glm::mat4(1.0f), graph.scale(i));
+    int parent = graph.parent(i);
+    (*worlds)[i] = parent < 0 ? local : (*worlds)[parent] * local;
+  }
+}
+
+}  // namespace bando
@@ -0,0 +1,116 @@
+#ifndef EXAMPLES_SCENE_GRAPH_SCENE_GRAPH_H_
+#define EXAMPLES_SCENE_GRAPH_SCENE_GRAPH_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "examples/jobs/worker_pool.h"
+
+// Node hierarchy with incremental world transform updates. Parent indices,
+// local TRS and world matrices live in flat arrays sorted depth-first, so
+// parents precede their children and every subtree is the contiguous index
+// range [i, subtree_end(i)).
+//
+// Setting a local transform only flags the node. Update() merges the
+// flagged nodes into disjoint dirty subtrees and recomputes just those,
+// front to back; untouched nodes are never visited, so a 100k node scene
+// with a handful of moving nodes costs a handful of subtrees. Large dirty
+// subtrees are cut at child boundaries into independent ranges that run
+// across a WorkerPool.
+
+namespace bando {
+
+struct SceneGraphNode {
+  // Index of the parent in the input array, -1 for roots.
+  int parent = -1;
+  glm::vec3 translation = glm::vec3(0.0f);
+  glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+  glm::vec3 scale = glm::vec3(1.0f);
+};
+
+// Nodes [begin, end) recomputed by the last Update().
+struct SceneGraphRange {
+  uint32_t begin = 0;
+  uint32_t end = 0;
+};
+
+class SceneGraph {
+ public:
+  SceneGraph() = default;
+
+  SceneGraph(const SceneGraph &) = delete;
+  SceneGraph &operator=(const SceneGraph &) = delete;
+
+  // Replaces the graph with `nodes`, sorted depth-first with siblings kept
+  // in input order. `node_index` (optional) receives the graph index of
+  // every input node. Fails on out of range parents and cycles. All nodes
+  // start dirty, so the first Update() computes every world matrix.
+  bool Build(const std::vector<SceneGraphNode> &nodes,
+             std::vector<uint32_t> *node_index,
+             std::string *error);
+
+  size_t size() const { return parents_.size(); }
+  int parent(uint32_t node) const { return parents_[node]; }
+  uint32_t subtree_end(uint32_t node) const { return subtree_ends_[node]; }
+
+  const glm::vec3 &translation(uint32_t node) const {
+    return translations_[node];
+  }
+  const glm::quat &rotation(uint32_t node) const { return rotations_[node]; }
+  const glm::vec3 &scale(uint32_t node) const { return scales_[node]; }
+
+  void SetTranslation(uint32_t node, const glm::vec3 &translation);
+  void SetRotation(uint32_t node, const glm::quat &rotation);
+  void SetScale(uint32_t node, const glm::vec3 &scale);
+  void SetLocal(uint32_t node,
+                const glm::vec3 &translation,
+                const glm::quat &rotation,
+                const glm::vec3 &scale);
+
+  // Valid for clean nodes, i.e. after Update() for anything set since.
+  const glm::mat4 &world(uint32_t node) const { return worlds_[node]; }
+  const glm::mat4 *worlds() const { return worlds_.data(); }
+
+  size_t dirty_count() const { return dirty_nodes_.size(); }
+
+  // Recomputes the world matrices of every dirty node and its descendants.
+  // `pool` may be null; small updates run on the calling thread anyway.
+  void Update(WorkerPool *pool);
+
+  // Disjoint, ascending subtrees the last Update() recomputed, e.g. to
+  // upload only the world matrices that changed.
+  const std::vector<SceneGraphRange> &updated_ranges() const {
+    return updated_ranges_;
+  }
+
+ private:
+  void MarkDirty(uint32_t node);
+  void ComputeWorlds(uint32_t begin, uint32_t end);
+  void SplitRange(SceneGraphRange range, size_t max_nodes);
+
+  std::vector<int> parents_;
+  std::vector<uint32_t> subtree_ends_;
+  std::vector<glm::vec3> translations_;
+  std::vector<glm::quat> rotations_;
+  std::vector<glm::vec3> scales_;
+  std::vector<glm::mat4> worlds_;
+
+  std::vector<uint8_t> dirty_;
+  std::vector<uint32_t> dirty_nodes_;
+  std::vector<SceneGraphRange> updated_ranges_;
+  // Independent ranges handed to the pool, reused between updates.
+  std::vector<SceneGraphRange> jobs_;
+};
+
+// Reference update: recomputes every world matrix in order on the calling
+// thread, ignoring dirty flags. Used to verify incremental updates.
+void ComputeAllWorlds(const SceneGraph &graph, std::vector<glm::mat4> *worlds);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_SCENE_GRAPH_SCENE_GRAPH_H_
@@ -0,0 +1,270 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "examples/bench/bench_harness.h"
+#include "examples/jobs/worker_pool.h"
+#include "examples/scene_graph/scene_graph.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Scene graph update benchmarks. Incremental, threaded updates are checked
+// against a full single-threaded recompute before any benchmark runs:
+//   bazel run -c opt //examples/scene_graph:scene_graph_bench
+
+namespace {
+
+constexpr size_t kSceneNodes = 100000;
+constexpr size_t kRoots = 8;
+
+uint32_t NextIndex(uint32_t *state, size_t count) {
+  float unit = bando::NextUnit(state);
+  return static_cast<uint32_t>(unit * static_cast<float>(count)) %
+         static_cast<uint32_t>(count);
+}
+
+glm::quat RandomRotation(uint32_t *state) {
+  glm::vec3 axis(bando::NextRange(state, 1.0f), bando::NextRange(state, 1.0f),
+                 bando::NextRange(state, 1.0f));
+  if (glm::length(axis) < 1e-3f) {
+    axis = glm::vec3(0.0f, 1.0f, 0.0f);
+  }
+  return glm::angleAxis(bando::NextRange(state, 3.14159f),
+                        glm::normalize(axis));
+}
+
+// Random recursive tree under kRoots roots, listed children first so Build
+// has to reorder it.
+std::vector<bando::SceneGraphNode> MakeNodes(size_t count, uint32_t seed) {
+  uint32_t state = seed;
+  std::vector<bando::SceneGraphNode> nodes(count);
+  for (size_t i = 0; i < count; ++i) {
+    bando::SceneGraphNode &node = nodes[count - 1 - i];
+    node.parent = i < kRoots ? -1
+                             : static_cast<int>(count - 1 -
+                                                NextIndex(&state, i));
+    node.translation = glm::vec3(bando::NextRange(&state, 2.0f),
+                                 bando::NextRange(&state, 2.0f),
+                                 bando::NextRange(&state, 2.0f));
+    node.rotation = RandomRotation(&state);
+    node.scale = glm::vec3(0.9f + 0.2f * bando::NextUnit(&state));
+  }
+  return nodes;
+}
+
+bool MatricesMatch(const glm::mat4 &a, const glm::mat4 &b) {
+  for (int column = 0; column < 4; ++column) {
+    for (int row = 0; row < 4; ++row) {
+      float difference = std::fabs(a[column][row] - b[column][row]);
+      if (difference > 1e-3f * (1.0f + std::fabs(b[column][row]))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool WorldsMatchReference(const bando::SceneGraph &graph) {
+  std::vector<glm::mat4> expected;
+  bando::ComputeAllWorlds(graph, &expected);
+  for (uint32_t i = 0; i < graph.size(); ++i) {
+    if (!MatricesMatch(graph.world(i), expected[i])) {
+      std::printf("World matrix of node %u differs\n", i);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Verify() {
+  const size_t count = 20000;
+  std::vector<bando::SceneGraphNode> nodes = MakeNodes(count, 3u);
+  bando::SceneGraph graph;
+  std::vector<uint32_t> node_index;
+  std::string error;
+  if (!graph.Build(nodes, &node_index, &error)) {
+    std::printf("%s\n", error.c_str());
+    return false;
+  }
+  // Parents first, subtrees contiguous, and the input mapping intact.
+  for (size_t i = 0; i < count; ++i) {
+    uint32_t g = node_index[i];
+    int expected_parent =
+        nodes[i].parent < 0 ? -1
+                            : static_cast<int>(node_index[nodes[i].parent]);
+    if (graph.parent(g) != expected_parent) {
+      std::printf("Node %zu lost its parent\n", i);
+      return false;
+    }
+    int parent = graph.parent(g);
+    if (parent >= 0 &&
+        (parent >= static_cast<int>(g) || graph.subtree_end(g) >
+                                              graph.subtree_end(parent))) {
+      std::printf("Node %zu is outside its parent's subtree\n", i);
+      return false;
+    }
+  }
+
+  bando::WorkerPool pool(4);
+  graph.Update(&pool);
+  if (graph.updated_ranges().size() != kRoots ||
+      !WorldsMatchReference(graph)) {
+    std::printf("Initial update is incomplete\n");
+    return false;
+  }
+
+  // Sparse and dense edits, including roots, threaded and not.
+  uint32_t state = 17u;
+  const size_t edits[] = {1, 3, 40, 900, 5000, 1, 0, 20000};
+  for (size_t round = 0; round < sizeof(edits) / sizeof(edits[0]); ++round) {
+    for (size_t e = 0; e < edits[round]; ++e) {
+      uint32_t node = NextIndex(&state, count);
+      switch (e % 3) {
+        case 0:
+          graph.SetRotation(node, RandomRotation(&state));
+          break;
+        case 1:
+          graph.SetTranslation(node, glm::vec3(bando::NextRange(&state, 2.0f)));
+          break;
+        default:
+          graph.SetScale(node, glm::vec3(0.5f + bando::NextUnit(&state)));
+          break;
+      }
+    }
+    graph.Update(round % 2 == 0 ? &pool : nullptr);
+    if (graph.dirty_count() != 0 || !WorldsMatchReference(graph)) {
+      std::printf("Update after %zu edits is wrong\n", edits[round]);
+      return false;
+    }
+    uint32_t previous_end = 0;
+    for (const bando::SceneGraphRange &range : graph.updated_ranges()) {
+      if (range.begin < previous_end || range.end <= range.begin) {
+        std::printf("Updated ranges overlap\n");
+        return false;
+      }
+      previous_end = range.end;
+    }
+  }
+
+  // A single deep chain still splits correctly (into one job per level).
+  std::vector<bando::SceneGraphNode> chain(kSceneNodes / 10);
+  for (size_t i = 0; i < chain.size(); ++i) {
+    chain[i].parent = static_cast<int>(i) - 1;
+    chain[i].translation = glm::vec3(0.0f, 0.01f, 0.0f);
+  }
+  bando::SceneGraph chain_graph;
+  if (!chain_graph.Build(chain, nullptr, &error)) {
+    std::printf("%s\n", error.c_str());
+    return false;
+  }
+  chain_graph.Update(&pool);
+  if (!WorldsMatchReference(chain_graph)) {
+    return false;
+  }
+
+  std::vector<bando::SceneGraphNode> cycle(3);
+  cycle[0].parent = 2;
+  cycle[1].parent = 0;
+  cycle[2].parent = 1;
+  if (chain_graph.Build(cycle, nullptr, &error)) {
+    std::printf("A cycle was accepted\n");
+    return false;
+  }
+  return true;
+}
+
+// range(0) random nodes of a 100k node scene move every frame, updated on
+// range(1) threads (0: all cores).
+void BM_SceneGraphUpdate_Sparse(benchmark::State &state) {
+  std::vector<bando::SceneGraphNode> nodes = MakeNodes(kSceneNodes, 7u);
+  bando::SceneGraph graph;
+  graph.Build(nodes, nullptr, nullptr);
+  bando::WorkerPool pool(static_cast<int>(state.range(1)));
+  graph.Update(&pool);
+  size_t moving = static_cast<size_t>(state.range(0));
+  std::vector<uint32_t> movers(moving);
+  std::vector<glm::quat> rotations(moving);
+  uint32_t random = 29u;
+  for (size_t i = 0; i < moving; ++i) {
+    movers[i] = NextIndex(&random, kSceneNodes);
+    rotations[i] = RandomRotation(&random);
+  }
+  size_t recomputed = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < moving; ++i) {
+      graph.SetRotation(movers[i], rotations[i]);
+    }
+    graph.Update(&pool);
+    benchmark::DoNotOptimize(graph.worlds());
+    for (const bando::SceneGraphRange &range : graph.updated_ranges()) {
+      recomputed += range.end - range.begin;
+    }
+  }
+  bando::SetItemsProcessed(state, moving);
+  state.counters["nodes_per_frame"] = benchmark::Counter(
+      static_cast<double>(recomputed), benchmark::Counter::kAvgIterations);
+  state.counters["threads"] = static_cast<double>(pool.thread_count());
+}
+
+// Every root moves, so all 100k nodes are recomputed.
+void BM_SceneGraphUpdate_Full(benchmark::State &state) {
+  std::vector<bando::SceneGraphNode> nodes = MakeNodes(kSceneNodes, 7u);
+  bando::SceneGraph graph;
+  std::vector<uint32_t> node_index;
+  graph.Build(nodes, &node_index, nullptr);
+  bando::WorkerPool pool(static_cast<int>(state.range(0)));
+  std::vector<uint32_t> roots;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    if (nodes[i].parent < 0) {
+      roots.push_back(node_index[i]);
+    }
+  }
+  float angle = 0.0f;
+  for (auto _ : state) {
+    angle += 0.01f;
+    for (uint32_t root : roots) {
+      graph.SetRotation(root,
+                        glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+    }
+    graph.Update(&pool);
+    benchmark::DoNotOptimize(graph.worlds());
+  }
+  bando::SetItemsProcessed(state, kSceneNodes);
+  state.counters["threads"] = static_cast<double>(pool.thread_count());
+}
+
+// Full traversal with 4x4 products, as a per-frame recompute of every node
+// would do.
+void BM_ComputeAllWorlds(benchmark::State &state) {
+  std::vector<bando::SceneGraphNode> nodes = MakeNodes(kSceneNodes, 7u);
+  bando::SceneGraph graph;
+  graph.Build(nodes, nullptr, nullptr);
+  std::vector<glm::mat4> worlds;
+  for (auto _ : state) {
+    bando::ComputeAllWorlds(graph, &worlds);
+    benchmark::DoNotOptimize(worlds.data());
+  }
+  bando::SetItemsProcessed(state, kSceneNodes);
+}
+
+BENCHMARK(BM_SceneGraphUpdate_Sparse)
+    ->ArgsProduct({{1, 16, 256, 4096}, {1, 0}})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK(BM_SceneGraphUpdate_Full)
+    ->Arg(1)
+    ->Arg(0)
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK(BM_ComputeAllWorlds)->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  return bando::RunVerifiedBenchmarks(argc, argv, "Scene graph update", Verify);
+}
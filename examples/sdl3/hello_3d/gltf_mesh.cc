@@ -0,0 +1,859 @@
+#include "examples/sdl3/hello_3d/gltf_mesh.h"
+
+#include "examples/profiling/profile_zones.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace bando {
+
+namespace {
+
+constexpr const char *kMeshoptExtension = "EXT_meshopt_compression";
+
+// glTF componentType values.
+constexpr int kComponentByte = 5120;
+constexpr int kComponentUnsignedByte = 5121;
+constexpr int kComponentShort = 5122;
+constexpr int kComponentUnsignedShort = 5123;
+constexpr int kComponentUnsignedInt = 5125;
+constexpr int kComponentFloat = 5126;
+
+bool SetError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+template <typename T>
+float Dequantize(T value, bool normalized) {
+  if constexpr (std::is_floating_point_v<T>) {
+    return value;
+  } else if (!normalized) {
+    return static_cast<float>(value);
+  } else if constexpr (std::is_signed_v<T>) {
+    return std::max(static_cast<float>(value) /
+                        static_cast<float>(std::numeric_limits<T>::max()),
+                    -1.0f);
+  } else {
+    return static_cast<float>(value) /
+           static_cast<float>(std::numeric_limits<T>::max());
+  }
+}
+
+template <typename T, typename Vec>
+void ConvertElements(const unsigned char *data,
+                     size_t stride,
+                     bool normalized,
+                     size_t count,
+                     Vec *out) {
+  constexpr int kComponents = Vec::length();
+  for (size_t i = 0; i < count; ++i) {
+    const unsigned char *element = data + i * stride;
+    for (int c = 0; c < kComponents; ++c) {
+      T value;
+      std::memcpy(&value, element + c * sizeof(T), sizeof(T));
+      out[i][c] = Dequantize(value, normalized);
+    }
+  }
+}
+
+template <typename T>
+void ConvertFloats(const unsigned char *data,
+                   size_t stride,
+                   bool normalized,
+                   size_t count,
+                   int components,
+                   float *out) {
+  for (size_t i = 0; i < count; ++i) {
+    const unsigned char *element = data + i * stride;
+    for (int c = 0; c < components; ++c) {
+      T value;
+      std::memcpy(&value, element + c * sizeof(T), sizeof(T));
+      *out++ = Dequantize(value, normalized);
+    }
+  }
+}
+
+template <typename T>
+void ConvertIndices(const unsigned char *data,
+                    size_t stride,
+                    size_t count,
+                    uint32_t *out) {
+  for (size_t i = 0; i < count; ++i) {
+    T value;
+    std::memcpy(&value, data + i * stride, sizeof(T));
+    out[i] = value;
+  }
+}
+
+size_t ComponentSize(int component_type) {
+  switch (component_type) {
+    case kComponentByte:
+    case kComponentUnsignedByte:
+      return 1;
+    case kComponentShort:
+    case kComponentUnsignedShort:
+      return 2;
+    case kComponentUnsignedInt:
+    case kComponentFloat:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+// An accessor resolved down to its bytes, shared by the readers below.
+struct AccessorBytes {
+  // Null for accessors without a buffer view, which read as zeros.
+  const unsigned char *data = nullptr;
+  size_t stride = 0;
+  size_t count = 0;
+  int component_type = 0;
+  int components = 0;
+  bool normalized = false;
+};
+
+// Checks that every element of `accessor` lies inside the `available`
+// bytes following its first element and fills in the packed stride.
+bool CheckAccessorRange(AccessorBytes *accessor,
+                        size_t available,
+                        std::string *error) {
+  size_t element_size =
+      ComponentSize(accessor->component_type) * accessor->components;
+  if (accessor->stride == 0) {
+    accessor->stride = element_size;
+  }
+  // Written as a division so huge counts or strides cannot wrap around.
+  if (accessor->count > 0 &&
+      (element_size > available ||
+       (accessor->stride > 0 &&
+        accessor->count - 1 >
+            (available - element_size) / accessor->stride))) {
+    return SetError(error, "Accessor reads past the end of its buffer");
+  }
+  return true;
+}
+
+bool ResolveAccessor(const GltfScene &scene,
+                     int accessor_index,
+                     AccessorBytes *out,
+                     std::string *error) {
+  if (accessor_index < 0 || accessor_index >=
+                                static_cast<int>(scene.accessors.size())) {
+    return SetError(error, "Missing accessor");
+  }
+  const SceneAccessor &accessor = scene.accessors[accessor_index];
+  if (accessor.sparse) {
+    return SetError(error, "Sparse accessors are not supported");
+  }
+  *out = AccessorBytes();
+  out->count = accessor.count;
+  out->component_type = accessor.component_type;
+  out->components = accessor.components;
+  out->normalized = accessor.normalized;
+  if (accessor.buffer_view < 0 || accessor.count == 0) {
+    return true;
+  }
+  if (accessor.buffer_view >= static_cast<int>(scene.buffer_views.size())) {
+    return SetError(error, "Accessor buffer view out of range");
+  }
+  const SceneBufferView &view = scene.buffer_views[accessor.buffer_view];
+  if (view.buffer < 0 ||
+      view.buffer >= static_cast<int>(scene.buffers.size())) {
+    return SetError(error, "Buffer view buffer out of range");
+  }
+  const SceneBuffer &buffer = scene.buffers[view.buffer];
+  size_t offset = view.byte_offset + accessor.byte_offset;
+  if (!buffer.data || offset > buffer.size) {
+    return SetError(error, "Accessor reads past the end of its buffer");
+  }
+  out->data = buffer.data + offset;
+  out->stride = view.byte_stride;
+  return CheckAccessorRange(out, buffer.size - offset, error);
+}
+
+// Float accessors plus the integer encodings KHR_mesh_quantization allows
+// for positions, normals and texture coordinates, normalized or not.
+template <typename Vec>
+bool CheckVertexAccessor(const AccessorBytes &accessor,
+                         const char *type_error,
+                         std::string *error) {
+  if (accessor.components != Vec::length()) {
+    return SetError(error, type_error);
+  }
+  switch (accessor.component_type) {
+    case kComponentFloat:
+    case kComponentByte:
+    case kComponentUnsignedByte:
+    case kComponentShort:
+    case kComponentUnsignedShort:
+      return true;
+    default:
+      return SetError(error, "Unsupported vertex component type");
+  }
+}
+
+bool CheckIndexAccessor(const AccessorBytes &accessor, std::string *error) {
+  if (accessor.components != 1) {
+    return SetError(error, "Expected scalar index accessor");
+  }
+  switch (accessor.component_type) {
+    case kComponentUnsignedByte:
+    case kComponentUnsignedShort:
+    case kComponentUnsignedInt:
+      return true;
+    default:
+      return SetError(error, "Unsupported index component type");
+  }
+}
+
+// Converts elements [first, first + count) of a checked vertex accessor.
+// Elements past its end, or all of them when it has no data, read as zero.
+template <typename Vec>
+void ConvertVertexRange(const AccessorBytes &accessor,
+                        size_t first,
+                        size_t count,
+                        Vec *out) {
+  size_t available = 0;
+  if (accessor.data && first < accessor.count) {
+    available = std::min(count, accessor.count - first);
+  }
+  if (available > 0) {
+    const unsigned char *data = accessor.data + first * accessor.stride;
+    size_t stride = accessor.stride;
+    bool normalized = accessor.normalized;
+    switch (accessor.component_type) {
+      case kComponentFloat:
+        ConvertElements<float>(data, stride, normalized, available, out);
+        break;
+      case kComponentByte:
+        ConvertElements<int8_t>(data, stride, normalized, available, out);
+        break;
+      case kComponentUnsignedByte:
+        ConvertElements<uint8_t>(data, stride, normalized, available, out);
+        break;
+      case kComponentShort:
+        ConvertElements<int16_t>(data, stride, normalized, available, out);
+        break;
+      case kComponentUnsignedShort:
+        ConvertElements<uint16_t>(data, stride, normalized, available, out);
+        break;
+    }
+  }
+  std::fill(out + available, out + count, Vec(0.0f));
+}
+
+// Same for a checked index accessor.
+void ConvertIndexRange(const AccessorBytes &accessor,
+                       size_t first,
+                       size_t count,
+                       uint32_t *out) {
+  size_t available = 0;
+  if (accessor.data && first < accessor.count) {
+    available = std::min(count, accessor.count - first);
+  }
+  if (available > 0) {
+    const unsigned char *data = accessor.data + first * accessor.stride;
+    switch (accessor.component_type) {
+      case kComponentUnsignedByte:
+        ConvertIndices<uint8_t>(data, accessor.stride, available, out);
+        break;
+      case kComponentUnsignedShort:
+        ConvertIndices<uint16_t>(data, accessor.stride, available, out);
+        break;
+      case kComponentUnsignedInt:
+        ConvertIndices<uint32_t>(data, accessor.stride, available, out);
+        break;
+    }
+  }
+  std::fill(out + available, out + count, 0u);
+}
+
+template <typename Vec>
+bool ReadAccessorVec(const GltfScene &scene,
+                     int accessor_index,
+                     const char *type_error,
+                     std::vector<Vec> *out,
+                     std::string *error) {
+  if (!out) {
+    return false;
+  }
+  AccessorBytes accessor;
+  if (!ResolveAccessor(scene, accessor_index, &accessor, error) ||
+      !CheckVertexAccessor<Vec>(accessor, type_error, error)) {
+    return false;
+  }
+  out->resize(accessor.count);
+  ConvertVertexRange(accessor, 0, accessor.count, out->data());
+  return true;
+}
+
+bool ReadIndices(const GltfScene &scene,
+                 int accessor_index,
+                 std::vector<uint32_t> *out,
+                 std::string *error) {
+  if (!out) {
+    return false;
+  }
+  AccessorBytes accessor;
+  if (!ResolveAccessor(scene, accessor_index, &accessor, error) ||
+      !CheckIndexAccessor(accessor, error)) {
+    return false;
+  }
+  out->resize(accessor.count);
+  ConvertIndexRange(accessor, 0, accessor.count, out->data());
+  return true;
+}
+
+// Accessor indices of the attributes the mesh is built from, -1 when
+// absent.
+struct PrimitiveAccessors {
+  int position = -1;
+  int normal = -1;
+  int uv = -1;
+  int indices = -1;
+  // Only resolved when `skinned` is set, and then required.
+  bool skinned = false;
+  int joints = -1;
+  int weights = -1;
+};
+
+// PrimitiveAccessors resolved and checked; absent attributes keep a
+// default AccessorBytes, which converts to zeros.
+struct ResolvedPrimitive {
+  AccessorBytes position;
+  AccessorBytes normal;
+  AccessorBytes uv;
+  AccessorBytes indices;
+  AccessorBytes joints;
+  AccessorBytes weights;
+  bool has_normals = false;
+  bool has_indices = false;
+  bool skinned = false;
+
+  size_t vertex_count() const { return position.count; }
+  size_t index_count() const {
+    return has_indices ? indices.count : position.count;
+  }
+};
+
+bool ResolvePrimitive(const GltfScene &scene,
+                      const PrimitiveAccessors &primitive,
+                      ResolvedPrimitive *out,
+                      std::string *error) {
+  *out = ResolvedPrimitive();
+  if (primitive.position < 0) {
+    return SetError(error, "glTF mesh missing POSITION attribute");
+  }
+  if (!ResolveAccessor(scene, primitive.position, &out->position, error) ||
+      !CheckVertexAccessor<glm::vec3>(out->position, "Expected VEC3 accessor",
+                                      error)) {
+    return false;
+  }
+  if (primitive.normal >= 0) {
+    out->has_normals = true;
+    if (!ResolveAccessor(scene, primitive.normal, &out->normal, error) ||
+        !CheckVertexAccessor<glm::vec3>(out->normal, "Expected VEC3 accessor",
+                                        error)) {
+      return false;
+    }
+  }
+  if (primitive.uv >= 0 &&
+      (!ResolveAccessor(scene, primitive.uv, &out->uv, error) ||
+       !CheckVertexAccessor<glm::vec2>(out->uv, "Expected VEC2 accessor",
+                                       error))) {
+    return false;
+  }
+  if (primitive.indices >= 0) {
+    out->has_indices = true;
+    if (!ResolveAccessor(scene, primitive.indices, &out->indices, error) ||
+        !CheckIndexAccessor(out->indices, error)) {
+      return false;
+    }
+  }
+  if (primitive.skinned) {
+    out->skinned = true;
+    if (!ResolveAccessor(scene, primitive.joints, &out->joints, error) ||
+        !CheckVertexAccessor<glm::vec4>(out->joints, "Expected VEC4 accessor",
+                                        error) ||
+        !ResolveAccessor(scene, primitive.weights, &out->weights, error) ||
+        !CheckVertexAccessor<glm::vec4>(out->weights,
+                                        "Expected VEC4 accessor", error)) {
+      return false;
+    }
+    if (out->joints.count < out->position.count ||
+        out->weights.count < out->position.count) {
+      return SetError(error,
+                      "Skin attributes have fewer elements than POSITION");
+    }
+  }
+  return true;
+}
+
+// Adds the unit face normal of every in-range, non-degenerate triangle to
+// its three vertices. `position_at(i)` and `normal_at(i)` return the
+// position and a reference to the normal sum of vertex i.
+template <typename PositionAt, typename NormalAt>
+void AccumulateFaceNormals(const uint32_t *indices,
+                           size_t index_count,
+                           size_t vertex_count,
+                           PositionAt position_at,
+                           NormalAt normal_at) {
+  for (size_t i = 0; i + 2 < index_count; i += 3) {
+    uint32_t i0 = indices[i];
+    uint32_t i1 = indices[i + 1];
+    uint32_t i2 = indices[i + 2];
+    if (i0 >= vertex_count || i1 >= vertex_count || i2 >= vertex_count) {
+      continue;
+    }
+    const glm::vec3 &p0 = position_at(i0);
+    glm::vec3 normal = glm::cross(position_at(i1) - p0, position_at(i2) - p0);
+    float length = glm::length(normal);
+    if (length <= 0.0f) {
+      continue;
+    }
+    normal /= length;
+    normal_at(i0) += normal;
+    normal_at(i1) += normal;
+    normal_at(i2) += normal;
+  }
+}
+
+glm::vec3 FinishNormal(const glm::vec3 &sum) {
+  return glm::length(sum) > 0.0f ? glm::normalize(sum)
+                                 : glm::vec3(0.0f, 1.0f, 0.0f);
+}
+
+void BoundsFromMinMax(const glm::vec3 &min_pos,
+                      const glm::vec3 &max_pos,
+                      glm::vec3 *center,
+                      float *radius) {
+  *center = (min_pos + max_pos) * 0.5f;
+  *radius = glm::length(max_pos - min_pos) * 0.5f;
+  if (*radius <= 0.0f) {
+    *radius = 1.0f;
+  }
+}
+
+// Vertices and indices converted per chunk before being written out, so
+// every attribute of a chunk stays in L1 and the output is written once,
+// front to back, in whole vertices. That keeps write-combined mappings of
+// GPU transfer memory on their fast path. A multiple of 3 so index chunks
+// hold whole triangles.
+constexpr size_t kDecodeChunk = 384;
+
+// Decodes `primitive` in chunks of kDecodeChunk vertices, handing each to
+// `emit` (a bool(const GltfVertexChunk &) callable; decoding stops when it
+// returns false), and computes its bounds. Indices go to `indices` (sized
+// by index_count()) unless it is null. Only a primitive without normals
+// needs temporary arrays, to sum face normals before any vertex is
+// emitted. The outputs are never read back.
+template <typename Emit>
+bool DecodePrimitive(const ResolvedPrimitive &primitive,
+                     uint32_t *indices,
+                     Emit emit,
+                     glm::vec3 *center,
+                     float *radius) {
+  size_t vertex_count = primitive.vertex_count();
+  size_t index_count = primitive.index_count();
+  bool generate_normals = !primitive.has_normals;
+  std::vector<glm::vec3> positions;
+  std::vector<glm::vec3> normal_sums;
+  if (generate_normals) {
+    positions.resize(vertex_count);
+    ConvertVertexRange(primitive.position, 0, vertex_count, positions.data());
+    normal_sums.assign(vertex_count, glm::vec3(0.0f));
+  }
+
+  if (indices || generate_normals) {
+    BANDO_PROFILE_ZONE("DecodeIndices");
+    uint32_t chunk[kDecodeChunk];
+    for (size_t first = 0; first < index_count; first += kDecodeChunk) {
+      size_t count = std::min(kDecodeChunk, index_count - first);
+      if (primitive.has_indices) {
+        ConvertIndexRange(primitive.indices, first, count, chunk);
+      } else {
+        for (size_t i = 0; i < count; ++i) {
+          chunk[i] = static_cast<uint32_t>(first + i);
+        }
+      }
+      if (indices) {
+        std::memcpy(indices + first, chunk, count * sizeof(uint32_t));
+      }
+      if (generate_normals) {
+        AccumulateFaceNormals(
+            chunk, count, vertex_count,
+            [&positions](uint32_t i) -> const glm::vec3 & {
+              return positions[i];
+            },
+            [&normal_sums](uint32_t i) -> glm::vec3 & {
+              return normal_sums[i];
+            });
+      }
+    }
+  }
+
+  BANDO_PROFILE_ZONE("DecodeVertices");
+  glm::vec3 min_pos(std::numeric_limits<float>::max());
+  glm::vec3 max_pos(std::numeric_limits<float>::lowest());
+  glm::vec3 chunk_positions[kDecodeChunk];
+  glm::vec3 chunk_normals[kDecodeChunk];
+  glm::vec2 chunk_uvs[kDecodeChunk];
+  glm::vec4 chunk_joints[kDecodeChunk];
+  glm::vec4 chunk_weights[kDecodeChunk];
+  GltfVertexChunk chunk;
+  chunk.normals = chunk_normals;
+  chunk.uvs = chunk_uvs;
+  if (primitive.skinned) {
+    chunk.joints = chunk_joints;
+    chunk.weights = chunk_weights;
+  }
+  for (size_t first = 0; first < vertex_count; first += kDecodeChunk) {
+    size_t count = std::min(kDecodeChunk, vertex_count - first);
+    chunk.first = first;
+    chunk.count = count;
+    chunk.positions = chunk_positions;
+    if (generate_normals) {
+      chunk.positions = positions.data() + first;
+      for (size_t i = 0; i < count; ++i) {
+        chunk_normals[i] = FinishNormal(normal_sums[first + i]);
+      }
+    } else {
+      ConvertVertexRange(primitive.position, first, count, chunk_positions);
+      ConvertVertexRange(primitive.normal, first, count, chunk_normals);
+    }
+    ConvertVertexRange(primitive.uv, first, count, chunk_uvs);
+    if (primitive.skinned) {
+      ConvertVertexRange(primitive.joints, first, count, chunk_joints);
+      ConvertVertexRange(primitive.weights, first, count, chunk_weights);
+    }
+    for (size_t i = 0; i < count; ++i) {
+      min_pos = glm::min(min_pos, chunk.positions[i]);
+      max_pos = glm::max(max_pos, chunk.positions[i]);
+    }
+    if (!emit(chunk)) {
+      return false;
+    }
+  }
+  if (vertex_count > 0) {
+    BoundsFromMinMax(min_pos, max_pos, center, radius);
+  }
+  return true;
+}
+
+bool FirstPrimitive(const GltfScene &scene,
+                    PrimitiveAccessors *out,
+                    std::string *error) {
+  if (scene.meshes.empty() || scene.meshes[0].primitive_count == 0) {
+    return SetError(error, "glTF has no meshes to draw");
+  }
+  const ScenePrimitive &first =
+      scene.primitives[scene.meshes[0].first_primitive];
+  out->position = first.position;
+  out->normal = first.normal;
+  out->uv = first.texcoord0;
+  out->indices = first.indices;
+  out->joints = first.joints0;
+  out->weights = first.weights0;
+  return true;
+}
+
+// Base color factor and texture images of the first primitive's material.
+void ApplySceneMaterial(const GltfScene &scene, GltfMesh *mesh) {
+  mesh->base_color = glm::vec4(1.0f);
+  mesh->base_color_image = -1;
+  mesh->metallic_roughness_image = -1;
+  mesh->normal_image = -1;
+  mesh->occlusion_image = -1;
+  mesh->emissive_image = -1;
+  if (scene.meshes.empty() || scene.meshes[0].primitive_count == 0) {
+    return;
+  }
+  int material_index =
+      scene.primitives[scene.meshes[0].first_primitive].material;
+  if (material_index < 0 ||
+      material_index >= static_cast<int>(scene.materials.size())) {
+    return;
+  }
+  const SceneMaterial &material = scene.materials[material_index];
+  const float *factor = material.base_color_factor;
+  mesh->base_color = glm::vec4(factor[0], factor[1], factor[2], factor[3]);
+  mesh->base_color_image =
+      SceneTextureImage(scene, material.base_color_texture);
+  mesh->metallic_roughness_image =
+      SceneTextureImage(scene, material.metallic_roughness_texture);
+  mesh->normal_image = SceneTextureImage(scene, material.normal_texture);
+  mesh->occlusion_image = SceneTextureImage(scene, material.occlusion_texture);
+  mesh->emissive_image = SceneTextureImage(scene, material.emissive_texture);
+}
+
+}  // namespace
+
+bool ReadAccessorVec3(const GltfScene &scene,
+                      int accessor_index,
+                      std::vector<glm::vec3> *out,
+                      std::string *error) {
+  BANDO_PROFILE_ZONE("ReadAccessorVec3");
+  return ReadAccessorVec(scene, accessor_index, "Expected VEC3 accessor", out,
+                         error);
+}
+
+bool ReadAccessorVec2(const GltfScene &scene,
+                      int accessor_index,
+                      std::vector<glm::vec2> *out,
+                      std::string *error) {
+  return ReadAccessorVec(scene, accessor_index, "Expected VEC2 accessor", out,
+                         error);
+}
+
+bool ReadIndexAccessor(const GltfScene &scene,
+                       int accessor_index,
+                       std::vector<uint32_t> *out,
+                       std::string *error) {
+  BANDO_PROFILE_ZONE("ReadIndexAccessor");
+  return ReadIndices(scene, accessor_index, out, error);
+}
+
+void ComputeBounds(const std::vector<Vertex> &vertices,
+                   glm::vec3 *center,
+                   float *radius) {
+  BANDO_PROFILE_ZONE("ComputeBounds");
+  if (!center || !radius || vertices.empty()) {
+    return;
+  }
+  glm::vec3 min_pos(std::numeric_limits<float>::max());
+  glm::vec3 max_pos(std::numeric_limits<float>::lowest());
+  for (const Vertex &vertex : vertices) {
+    min_pos = glm::min(min_pos, vertex.position);
+    max_pos = glm::max(max_pos, vertex.position);
+  }
+  BoundsFromMinMax(min_pos, max_pos, center, radius);
+}
+
+void ComputeNormalsFromIndices(std::vector<Vertex> *vertices,
+                               const std::vector<uint32_t> &indices) {
+  BANDO_PROFILE_ZONE("ComputeNormalsFromIndices");
+  if (!vertices || indices.size() < 3) {
+    return;
+  }
+  for (Vertex &vertex : *vertices) {
+    vertex.normal = glm::vec3(0.0f);
+  }
+  AccumulateFaceNormals(
+      indices.data(), indices.size(), vertices->size(),
+      [vertices](uint32_t i) -> const glm::vec3 & {
+        return (*vertices)[i].position;
+      },
+      [vertices](uint32_t i) -> glm::vec3 & {
+        return (*vertices)[i].normal;
+      });
+  for (Vertex &vertex : *vertices) {
+    vertex.normal = FinishNormal(vertex.normal);
+  }
+}
+
+bool BuildGltfMesh(const GltfScene &scene,
+                   GltfMesh *mesh,
+                   std::string *error) {
+  BANDO_PROFILE_ZONE("BuildGltfMesh");
+  if (!mesh) {
+    return false;
+  }
+  GltfMeshLayout layout;
+  if (!MeasureGltfMesh(scene, &layout, error)) {
+    return false;
+  }
+  mesh->vertices.resize(layout.vertex_count);
+  mesh->indices.resize(layout.index_count);
+  if (!DecodeGltfMeshInto(scene, layout, mesh->vertices.data(),
+                          mesh->indices.data(), mesh, error)) {
+    return false;
+  }
+  ApplySceneMaterial(scene, mesh);
+  return true;
+}
+
+bool MeasureGltfMesh(const GltfScene &scene,
+                     GltfMeshLayout *layout,
+                     std::string *error) {
+  if (!layout) {
+    return false;
+  }
+  PrimitiveAccessors accessors;
+  ResolvedPrimitive resolved;
+  if (!FirstPrimitive(scene, &accessors, error) ||
+      !ResolvePrimitive(scene, accessors, &resolved, error)) {
+    return false;
+  }
+  layout->vertex_count = resolved.vertex_count();
+  layout->index_count = resolved.index_count();
+  return true;
+}
+
+bool DecodeGltfMeshInto(const GltfScene &scene,
+                        const GltfMeshLayout &layout,
+                        Vertex *vertices,
+                        uint32_t *indices,
+                        GltfMesh *mesh,
+                        std::string *error) {
+  BANDO_PROFILE_ZONE("DecodeGltfMeshInto");
+  if (!mesh || (!vertices && layout.vertex_count > 0) ||
+      (!indices && layout.index_count > 0)) {
+    return false;
+  }
+  PrimitiveAccessors accessors;
+  ResolvedPrimitive resolved;
+  if (!FirstPrimitive(scene, &accessors, error) ||
+      !ResolvePrimitive(scene, accessors, &resolved, error)) {
+    return false;
+  }
+  if (resolved.vertex_count() != layout.vertex_count ||
+      resolved.index_count() != layout.index_count) {
+    return SetError(error, "Mesh layout does not match the scene");
+  }
+  return DecodePrimitive(
+      resolved, indices,
+      [vertices](const GltfVertexChunk &chunk) {
+        for (size_t i = 0; i < chunk.count; ++i) {
+          Vertex vertex;
+          vertex.position = chunk.positions[i];
+          vertex.normal = chunk.normals[i];
+          vertex.uv = chunk.uvs[i];
+          vertices[chunk.first + i] = vertex;
+        }
+        return true;
+      },
+      &mesh->center, &mesh->radius);
+}
+
+bool DecodeGltfSkinnedVertices(const GltfScene &scene,
+                               const GltfVertexChunkVisitor &visit,
+                               std::string *error) {
+  BANDO_PROFILE_ZONE("DecodeGltfSkinnedVertices");
+  PrimitiveAccessors accessors;
+  ResolvedPrimitive resolved;
+  if (!FirstPrimitive(scene, &accessors, error)) {
+    return false;
+  }
+  accessors.skinned = true;
+  if (!ResolvePrimitive(scene, accessors, &resolved, error)) {
+    return false;
+  }
+  glm::vec3 center(0.0f);
+  float radius = 1.0f;
+  return DecodePrimitive(
+      resolved, nullptr,
+      [&visit, error](const GltfVertexChunk &chunk) {
+        return visit(chunk, error);
+      },
+      &center, &radius);
+}
+
+bool ReadGltfMeshMaterial(const GltfScene &scene,
+                          GltfMesh *mesh,
+                          std::string *error) {
+  if (!mesh) {
+    return false;
+  }
+  ApplySceneMaterial(scene, mesh);
+  mesh->encoded_images.assign(scene.images.size(), {});
+  for (int image : {mesh->base_color_image, mesh->metallic_roughness_image,
+                    mesh->normal_image, mesh->occlusion_image,
+                    mesh->emissive_image}) {
+    if (image >= 0 && mesh->encoded_images[image].empty() &&
+        !ReadSceneImage(scene, image, &mesh->encoded_images[image], error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string GltfSceneWarnings(const GltfScene &scene) {
+  std::string warning;
+  for (std::string_view extension : scene.extensions_required) {
+    if (extension != kMeshoptExtension &&
+        extension != "KHR_mesh_quantization") {
+      warning += (warning.empty() ? "Ignoring required extensions: " : ", ") +
+                 std::string(extension);
+    }
+  }
+  return warning;
+}
+
+bool ReadSceneAccessorFloats(const GltfScene &scene,
+                             int accessor_index,
+                             int components,
+                             std::vector<float> *out,
+                             std::string *error) {
+  if (!out) {
+    return false;
+  }
+  AccessorBytes accessor;
+  if (!ResolveAccessor(scene, accessor_index, &accessor, error)) {
+    return false;
+  }
+  if (accessor.components != components) {
+    return SetError(error, "Accessor has " +
+                               std::to_string(accessor.components) +
+                               " components, expected " +
+                               std::to_string(components));
+  }
+  out->assign(accessor.count * components, 0.0f);
+  if (!accessor.data) {
+    return true;
+  }
+  const unsigned char *data = accessor.data;
+  size_t stride = accessor.stride;
+  bool normalized = accessor.normalized;
+  size_t count = accessor.count;
+  float *floats = out->data();
+  switch (accessor.component_type) {
+    case kComponentFloat:
+      ConvertFloats<float>(data, stride, normalized, count, components,
+                           floats);
+      return true;
+    case kComponentByte:
+      ConvertFloats<int8_t>(data, stride, normalized, count, components,
+                            floats);
+      return true;
+    case kComponentUnsignedByte:
+      ConvertFloats<uint8_t>(data, stride, normalized, count, components,
+                             floats);
+      return true;
+    case kComponentShort:
+      ConvertFloats<int16_t>(data, stride, normalized, count, components,
+                             floats);
+      return true;
+    case kComponentUnsignedShort:
+      ConvertFloats<uint16_t>(data, stride, normalized, count, components,
+                              floats);
+      return true;
+    default:
+      return SetError(error, "Unsupported accessor component type");
+  }
+}
+
+bool LoadGltfMesh(const std::string &path,
+                  GltfMesh *mesh,
+                  std::string *error,
+                  std::string *warning) {
+  BANDO_PROFILE_ZONE("LoadGltfMesh");
+  if (!mesh) {
+    return false;
+  }
+  GltfScene scene;
+  if (!LoadGltfScene(path, &scene, error)) {
+    return false;
+  }
+  if (warning) {
+    *warning = GltfSceneWarnings(scene);
+  }
+  return BuildGltfMesh(scene, mesh, error) &&
+         ReadGltfMeshMaterial(scene, mesh, error);
+}
+
+}  // namespace bando
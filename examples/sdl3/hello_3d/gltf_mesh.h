@@ -0,0 +1,159 @@
+#ifndef EXAMPLES_SDL3_HELLO_3D_GLTF_MESH_H_
+#define EXAMPLES_SDL3_HELLO_3D_GLTF_MESH_H_
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "examples/sdl3/hello_3d/gltf_scene.h"
+
+// glTF mesh extraction used by hello_3d: reads the first primitive of the
+// first mesh into an interleaved position/normal/uv vertex array, generating
+// normals and bounds when the asset does not provide them. Images are kept
+// in their encoded form so they can be decoded on worker threads (see
+// //examples/textures:texture_cache).
+
+namespace bando {
+
+struct Vertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 uv;
+};
+
+struct GltfMesh {
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  glm::vec3 center = glm::vec3(0.0f);
+  float radius = 1.0f;
+  glm::vec4 base_color = glm::vec4(1.0f);
+  // Indices into `encoded_images`, -1 when the material has no such texture.
+  int base_color_image = -1;
+  int metallic_roughness_image = -1;
+  int normal_image = -1;
+  int occlusion_image = -1;
+  int emissive_image = -1;
+  // Undecoded (PNG/JPEG) bytes indexed like the asset's images. LoadGltfMesh
+  // only fills the entries the material above references.
+  std::vector<std::vector<uint8_t>> encoded_images;
+};
+
+// Vertex attribute readers. Besides float they accept the (normalized or
+// integer) byte and short encodings of KHR_mesh_quantization.
+bool ReadAccessorVec3(const GltfScene &scene,
+                      int accessor_index,
+                      std::vector<glm::vec3> *out,
+                      std::string *error);
+
+bool ReadAccessorVec2(const GltfScene &scene,
+                      int accessor_index,
+                      std::vector<glm::vec2> *out,
+                      std::string *error);
+
+// Widens 8, 16 or 32 bit indices to uint32_t.
+bool ReadIndexAccessor(const GltfScene &scene,
+                       int accessor_index,
+                       std::vector<uint32_t> *out,
+                       std::string *error);
+
+// Bounding sphere around the vertex AABB. Leaves the outputs untouched for
+// an empty mesh and never reports a radius of zero.
+void ComputeBounds(const std::vector<Vertex> &vertices,
+                   glm::vec3 *center,
+                   float *radius);
+
+// Replaces every vertex normal with the normalized sum of the face normals
+// of the triangles using it. Out of range triangles are skipped.
+void ComputeNormalsFromIndices(std::vector<Vertex> *vertices,
+                               const std::vector<uint32_t> &indices);
+
+// Extracts the first primitive of an already loaded scene and its
+// material's base color and image indices. Leaves `encoded_images` alone.
+bool BuildGltfMesh(const GltfScene &scene,
+                   GltfMesh *mesh,
+                   std::string *error);
+
+// Sizes of the first primitive, known from accessor counts alone.
+struct GltfMeshLayout {
+  size_t vertex_count = 0;
+  size_t index_count = 0;
+};
+
+// Two-phase loading for uploads: MeasureGltfMesh sizes the first primitive
+// so GPU buffers can be created and a transfer buffer mapped, then
+// DecodeGltfMeshInto decodes, dequantizes and interleaves it in one pass
+// straight into `vertices` and `indices` (layout.vertex_count and
+// layout.index_count entries, e.g. mapped transfer memory), which are only
+// written, front to back. No vertex or index vectors are built; assets
+// without normals need temporary position/normal arrays to generate them.
+// DecodeGltfMeshInto fills mesh->center and mesh->radius and nothing else.
+bool MeasureGltfMesh(const GltfScene &scene,
+                     GltfMeshLayout *layout,
+                     std::string *error);
+
+bool DecodeGltfMeshInto(const GltfScene &scene,
+                        const GltfMeshLayout &layout,
+                        Vertex *vertices,
+                        uint32_t *indices,
+                        GltfMesh *mesh,
+                        std::string *error);
+
+// A run of consecutive decoded vertices, [first, first + count) of the
+// primitive. Attributes the primitive lacks read as zero; joints and
+// weights are null unless decoding a skinned mesh.
+struct GltfVertexChunk {
+  size_t first = 0;
+  size_t count = 0;
+  const glm::vec3 *positions = nullptr;
+  const glm::vec3 *normals = nullptr;
+  const glm::vec2 *uvs = nullptr;
+  const glm::vec4 *joints = nullptr;
+  const glm::vec4 *weights = nullptr;
+};
+
+// Returns false, with `error` set, to stop decoding.
+using GltfVertexChunkVisitor =
+    std::function<bool(const GltfVertexChunk &chunk, std::string *error)>;
+
+// Decodes the first primitive with its JOINTS_0 and WEIGHTS_0 attributes
+// through the same chunked path as DecodeGltfMeshInto, handing each chunk
+// of a few hundred vertices to `visit` so callers convert straight into
+// their own vertex layout. Indices are not written.
+bool DecodeGltfSkinnedVertices(const GltfScene &scene,
+                               const GltfVertexChunkVisitor &visit,
+                               std::string *error);
+
+// Sets the base color, image indices and encoded bytes of the images the
+// first primitive's material references.
+bool ReadGltfMeshMaterial(const GltfScene &scene,
+                          GltfMesh *mesh,
+                          std::string *error);
+
+// Reads `components` floats per element of a scene accessor, dequantizing
+// normalized or integer byte/short data like the vertex attribute readers.
+// Used for skin joints, weights, inverse bind matrices and animation keys.
+bool ReadSceneAccessorFloats(const GltfScene &scene,
+                             int accessor_index,
+                             int components,
+                             std::vector<float> *out,
+                             std::string *error);
+
+// Required extensions the loader does not implement, empty when there are
+// none.
+std::string GltfSceneWarnings(const GltfScene &scene);
+
+// Streams the file into a GltfScene (see gltf_scene.h), then extracts its
+// first primitive and reads the encoded images its material uses. Required
+// extensions the loader does not implement are reported through `warning`.
+bool LoadGltfMesh(const std::string &path,
+                  GltfMesh *mesh,
+                  std::string *error,
+                  std::string *warning);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_SDL3_HELLO_3D_GLTF_MESH_H_
@@ -0,0 +1,535 @@
+#include "examples/sdl3/hello_3d/gltf_mesh.h"
+
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <tiny_gltf.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Throughput of the hello_3d mesh path on synthetic grid meshes from 1k to
+// 10M triangles, and of streamed versus tinygltf parsing of JSON-heavy
+// scenes. Results go to stdout as JSON unless another
+// --benchmark_format is given, so runs can be diffed between releases:
+//   bazel run -c opt //examples/sdl3/hello_3d:gltf_mesh_bench > mesh.json
+
+namespace {
+
+constexpr int64_t kMinTriangles = 1000;
+constexpr int64_t kMaxTriangles = 10000000;
+// Writing and re-reading a .glb every iteration is dominated by file I/O;
+// larger sizes only add minutes without telling anything new.
+constexpr int64_t kMaxLoadTriangles = 1000000;
+// Object counts for the JSON-heavy scene benchmarks; 100k objects is about
+// 30 MB of JSON.
+constexpr int64_t kMinSceneObjects = 1000;
+constexpr int64_t kMaxSceneObjects = 100000;
+
+constexpr uint32_t kGlbMagic = 0x46546C67;       // "glTF"
+constexpr uint32_t kGlbChunkJson = 0x4E4F534A;    // "JSON"
+constexpr uint32_t kGlbChunkBinary = 0x004E4942;  // "BIN\0"
+
+struct SyntheticMesh {
+  int64_t triangles = 0;
+  // The mesh as the bytes of a .glb file.
+  std::vector<unsigned char> glb;
+  // `glb` loaded through LoadGltfScene, like hello_3d loads its assets.
+  bando::GltfScene scene;
+  int position_accessor = 0;
+  int index_accessor = 1;
+  // Set when `scene` could not be loaded.
+  std::string error;
+};
+
+void AppendBytes(std::vector<unsigned char> *buffer,
+                 const void *data,
+                 size_t size) {
+  const unsigned char *bytes = static_cast<const unsigned char *>(data);
+  buffer->insert(buffer->end(), bytes, bytes + size);
+}
+
+void AppendU32(std::vector<unsigned char> *buffer, uint32_t value) {
+  AppendBytes(buffer, &value, sizeof(value));
+}
+
+std::string FloatList(const float *values, int count) {
+  std::string list;
+  char number[32];
+  for (int i = 0; i < count; ++i) {
+    std::snprintf(number, sizeof(number), "%s%.9g", i ? "," : "",
+                  values[i]);
+    list += number;
+  }
+  return list;
+}
+
+// A GLB container holding `json` and `binary`, each padded to 4 bytes.
+std::vector<unsigned char> MakeGlb(std::string json,
+                                   std::vector<unsigned char> binary) {
+  json.resize((json.size() + 3) / 4 * 4, ' ');
+  binary.resize((binary.size() + 3) / 4 * 4, 0);
+  std::vector<unsigned char> glb;
+  glb.reserve(28 + json.size() + binary.size());
+  AppendU32(&glb, kGlbMagic);
+  AppendU32(&glb, 2);
+  AppendU32(&glb, static_cast<uint32_t>(28 + json.size() + binary.size()));
+  AppendU32(&glb, static_cast<uint32_t>(json.size()));
+  AppendU32(&glb, kGlbChunkJson);
+  AppendBytes(&glb, json.data(), json.size());
+  AppendU32(&glb, static_cast<uint32_t>(binary.size()));
+  AppendU32(&glb, kGlbChunkBinary);
+  AppendBytes(&glb, binary.data(), binary.size());
+  return glb;
+}
+
+// Writes a .glb in the temp directory, removing it again when destroyed.
+class TempGlb {
+ public:
+  TempGlb(const std::vector<unsigned char> &glb, int64_t triangles)
+      : path_(std::filesystem::temp_directory_path() /
+              ("bando_gltf_mesh_bench_" + std::to_string(triangles) +
+               ".glb")) {
+    std::ofstream file(path_, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(glb.data()),
+               static_cast<std::streamsize>(glb.size()));
+    ok_ = file.good();
+  }
+  ~TempGlb() {
+    std::error_code remove_error;
+    std::filesystem::remove(path_, remove_error);
+  }
+
+  bool ok() const { return ok_; }
+  std::string path() const { return path_.string(); }
+
+ private:
+  std::filesystem::path path_;
+  bool ok_ = false;
+};
+
+// A square grid of quads with a gentle height field, giving at least
+// `triangles` triangles, POSITION and uint32 indices only so normals are
+// generated on load like for assets without a NORMAL attribute.
+std::unique_ptr<SyntheticMesh> MakeSyntheticMesh(int64_t triangles) {
+  auto mesh = std::make_unique<SyntheticMesh>();
+  uint32_t quads_per_side = static_cast<uint32_t>(
+      std::ceil(std::sqrt(static_cast<double>(triangles) / 2.0)));
+  uint32_t verts_per_side = quads_per_side + 1;
+  size_t vertex_count = static_cast<size_t>(verts_per_side) * verts_per_side;
+  size_t index_count = static_cast<size_t>(quads_per_side) * quads_per_side * 6;
+  mesh->triangles = static_cast<int64_t>(index_count / 3);
+
+  std::vector<unsigned char> binary;
+  binary.reserve(vertex_count * sizeof(float) * 3 +
+                 index_count * sizeof(uint32_t));
+  float min_pos[3] = {0.0f, 0.0f, 0.0f};
+  float max_pos[3] = {static_cast<float>(quads_per_side), 0.0f,
+                      static_cast<float>(quads_per_side)};
+  for (uint32_t z = 0; z < verts_per_side; ++z) {
+    for (uint32_t x = 0; x < verts_per_side; ++x) {
+      float position[3] = {static_cast<float>(x),
+                           std::sin(x * 0.37f) * std::cos(z * 0.21f),
+                           static_cast<float>(z)};
+      min_pos[1] = std::fmin(min_pos[1], position[1]);
+      max_pos[1] = std::fmax(max_pos[1], position[1]);
+      AppendBytes(&binary, position, sizeof(position));
+    }
+  }
+  size_t index_offset = binary.size();
+  for (uint32_t z = 0; z < quads_per_side; ++z) {
+    for (uint32_t x = 0; x < quads_per_side; ++x) {
+      uint32_t i0 = z * verts_per_side + x;
+      uint32_t i1 = i0 + 1;
+      uint32_t i2 = i0 + verts_per_side;
+      uint32_t i3 = i2 + 1;
+      uint32_t quad[6] = {i0, i2, i1, i1, i2, i3};
+      AppendBytes(&binary, quad, sizeof(quad));
+    }
+  }
+
+  std::string json =
+      "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":" +
+      std::to_string(binary.size()) +
+      "}],\"bufferViews\":[{\"buffer\":0,\"byteLength\":" +
+      std::to_string(index_offset) +
+      ",\"target\":34962},{\"buffer\":0,\"byteOffset\":" +
+      std::to_string(index_offset) +
+      ",\"byteLength\":" + std::to_string(index_count * sizeof(uint32_t)) +
+      ",\"target\":34963}],\"accessors\":[{\"bufferView\":0,"
+      "\"componentType\":5126,\"type\":\"VEC3\",\"count\":" +
+      std::to_string(vertex_count) + ",\"min\":[" + FloatList(min_pos, 3) +
+      "],\"max\":[" + FloatList(max_pos, 3) +
+      "]},{\"bufferView\":1,\"componentType\":5125,\"type\":\"SCALAR\","
+      "\"count\":" +
+      std::to_string(index_count) +
+      "}],\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0},"
+      "\"indices\":1,\"mode\":4}]}],\"nodes\":[{\"mesh\":0}],"
+      "\"scenes\":[{\"nodes\":[0]}],\"scene\":0}";
+  mesh->glb = MakeGlb(std::move(json), std::move(binary));
+
+  TempGlb file(mesh->glb, mesh->triangles);
+  if (!file.ok()) {
+    mesh->error = "Failed to write synthetic .glb";
+  } else {
+    bando::LoadGltfScene(file.path(), &mesh->scene, &mesh->error);
+  }
+  return mesh;
+}
+
+// The 10M triangle mesh is a few hundred MB, so only the most recent size
+// is kept; benchmarks are registered grouped by size to make this hit.
+// Returns null after skipping `state` when the mesh could not be loaded.
+const SyntheticMesh *GetSyntheticMesh(benchmark::State &state) {
+  static std::unique_ptr<SyntheticMesh> cached;
+  static int64_t cached_request = 0;
+  int64_t triangles = state.range(0);
+  if (!cached || cached_request != triangles) {
+    cached.reset();
+    cached = MakeSyntheticMesh(triangles);
+    cached_request = triangles;
+  }
+  if (!cached->error.empty()) {
+    state.SkipWithError(cached->error.c_str());
+    return nullptr;
+  }
+  return cached.get();
+}
+
+void SetTrianglesProcessed(benchmark::State &state, int64_t triangles) {
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          triangles);
+  state.counters["triangles"] = static_cast<double>(triangles);
+}
+
+void BM_ReadAccessorVec3(benchmark::State &state) {
+  const SyntheticMesh *mesh = GetSyntheticMesh(state);
+  if (!mesh) {
+    return;
+  }
+  std::vector<glm::vec3> positions;
+  std::string error;
+  for (auto _ : state) {
+    if (!bando::ReadAccessorVec3(mesh->scene, mesh->position_accessor,
+                                 &positions, &error)) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(positions.data());
+  }
+  SetTrianglesProcessed(state, mesh->triangles);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(positions.size() *
+                                               sizeof(glm::vec3)));
+}
+
+void BM_ReadIndexAccessor(benchmark::State &state) {
+  const SyntheticMesh *mesh = GetSyntheticMesh(state);
+  if (!mesh) {
+    return;
+  }
+  std::vector<uint32_t> indices;
+  std::string error;
+  for (auto _ : state) {
+    if (!bando::ReadIndexAccessor(mesh->scene, mesh->index_accessor,
+                                  &indices, &error)) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(indices.data());
+  }
+  SetTrianglesProcessed(state, mesh->triangles);
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(indices.size() *
+                                               sizeof(uint32_t)));
+}
+
+void BM_ComputeNormalsFromIndices(benchmark::State &state) {
+  const SyntheticMesh *source = GetSyntheticMesh(state);
+  if (!source) {
+    return;
+  }
+  bando::GltfMesh mesh;
+  std::string error;
+  if (!bando::BuildGltfMesh(source->scene, &mesh, &error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  for (auto _ : state) {
+    bando::ComputeNormalsFromIndices(&mesh.vertices, mesh.indices);
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  SetTrianglesProcessed(state, source->triangles);
+}
+
+void BM_ComputeBounds(benchmark::State &state) {
+  const SyntheticMesh *source = GetSyntheticMesh(state);
+  if (!source) {
+    return;
+  }
+  bando::GltfMesh mesh;
+  std::string error;
+  if (!bando::BuildGltfMesh(source->scene, &mesh, &error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  for (auto _ : state) {
+    glm::vec3 center(0.0f);
+    float radius = 0.0f;
+    bando::ComputeBounds(mesh.vertices, &center, &radius);
+    benchmark::DoNotOptimize(center);
+    benchmark::DoNotOptimize(radius);
+  }
+  SetTrianglesProcessed(state, source->triangles);
+}
+
+void BM_BuildGltfMesh(benchmark::State &state) {
+  const SyntheticMesh *source = GetSyntheticMesh(state);
+  if (!source) {
+    return;
+  }
+  std::string error;
+  for (auto _ : state) {
+    bando::GltfMesh mesh;
+    if (!bando::BuildGltfMesh(source->scene, &mesh, &error)) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  SetTrianglesProcessed(state, source->triangles);
+}
+
+void BM_LoadGltfMesh(benchmark::State &state) {
+  const SyntheticMesh *source = GetSyntheticMesh(state);
+  if (!source) {
+    return;
+  }
+  TempGlb glb(source->glb, source->triangles);
+  if (!glb.ok()) {
+    state.SkipWithError("Failed to write synthetic .glb");
+    return;
+  }
+  std::string error;
+  std::string warning;
+  for (auto _ : state) {
+    bando::GltfMesh mesh;
+    if (!bando::LoadGltfMesh(glb.path(), &mesh, &error, &warning)) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(mesh.vertices.data());
+  }
+  SetTrianglesProcessed(state, source->triangles);
+}
+
+// Decoding into a preallocated staging area, as hello_3d does with the
+// mapped transfer buffer.
+void BM_DecodeGltfMeshInto(benchmark::State &state) {
+  const SyntheticMesh *source = GetSyntheticMesh(state);
+  if (!source) {
+    return;
+  }
+  bando::GltfMeshLayout layout;
+  std::string error;
+  if (!bando::MeasureGltfMesh(source->scene, &layout, &error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  std::vector<bando::Vertex> staging_vertices(layout.vertex_count);
+  std::vector<uint32_t> staging_indices(layout.index_count);
+  for (auto _ : state) {
+    bando::GltfMesh mesh;
+    if (!bando::DecodeGltfMeshInto(source->scene, layout,
+                                   staging_vertices.data(),
+                                   staging_indices.data(), &mesh, &error)) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(staging_vertices.data());
+    benchmark::ClobberMemory();
+  }
+  SetTrianglesProcessed(state, source->triangles);
+}
+
+// The upload path before DecodeGltfMeshInto: build vectors, then copy them
+// into the staging area.
+void BM_BuildGltfMeshAndCopy(benchmark::State &state) {
+  const SyntheticMesh *source = GetSyntheticMesh(state);
+  if (!source) {
+    return;
+  }
+  bando::GltfMeshLayout layout;
+  std::string error;
+  if (!bando::MeasureGltfMesh(source->scene, &layout, &error)) {
+    state.SkipWithError(error.c_str());
+    return;
+  }
+  std::vector<bando::Vertex> staging_vertices(layout.vertex_count);
+  std::vector<uint32_t> staging_indices(layout.index_count);
+  for (auto _ : state) {
+    bando::GltfMesh mesh;
+    if (!bando::BuildGltfMesh(source->scene, &mesh, &error)) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    std::memcpy(staging_vertices.data(), mesh.vertices.data(),
+                mesh.vertices.size() * sizeof(bando::Vertex));
+    std::memcpy(staging_indices.data(), mesh.indices.data(),
+                mesh.indices.size() * sizeof(uint32_t));
+    benchmark::DoNotOptimize(staging_vertices.data());
+    benchmark::ClobberMemory();
+  }
+  SetTrianglesProcessed(state, source->triangles);
+}
+
+// A glTF document whose JSON dwarfs its binary data, like large scenes
+// exported from DCC tools: `objects` accessors, meshes and nodes sharing
+// one tiny embedded buffer, with the names, bounds and extras those tools
+// write.
+std::string MakeLargeSceneJson(int64_t objects) {
+  std::string json =
+      "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":36,"
+      "\"uri\":\"data:application/octet-stream;base64,"
+      "AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAA\"}],"
+      "\"bufferViews\":[{\"buffer\":0,\"byteLength\":36}],"
+      "\"materials\":[{\"pbrMetallicRoughness\":"
+      "{\"baseColorFactor\":[1,1,1,1]}}]";
+  auto append_array = [&](const char *name, auto &&append_element) {
+    json += ",\"";
+    json += name;
+    json += "\":[";
+    for (int64_t i = 0; i < objects; ++i) {
+      json += i ? "," : "";
+      append_element(std::to_string(i));
+    }
+    json += "]";
+  };
+  append_array("accessors", [&](const std::string &i) {
+    json += "{\"bufferView\":0,\"componentType\":5126,\"count\":3,"
+            "\"type\":\"VEC3\",\"min\":[0,0,0],\"max\":[1,1,0],"
+            "\"name\":\"positions_" +
+            i + "\"}";
+  });
+  append_array("meshes", [&](const std::string &i) {
+    json += "{\"name\":\"mesh_" + i +
+            "\",\"primitives\":[{\"attributes\":{\"POSITION\":" + i +
+            "},\"material\":0}],\"extras\":{\"source_id\":" + i + "}}";
+  });
+  append_array("nodes", [&](const std::string &i) {
+    json += "{\"name\":\"node_" + i + "\",\"mesh\":" + i +
+            ",\"translation\":[" + i + ",0,0]}";
+  });
+  json += "}";
+  return json;
+}
+
+void BM_ParseSceneJson(benchmark::State &state) {
+  std::string json = MakeLargeSceneJson(state.range(0));
+  std::string error;
+  size_t arena_bytes = 0;
+  for (auto _ : state) {
+    bando::GltfScene scene;
+    if (!bando::ParseGltfSceneJson(json.data(), json.size(), &scene,
+                                   &error)) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    arena_bytes = scene.arena.reserved_bytes();
+    benchmark::DoNotOptimize(scene.accessors.begin());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(json.size()));
+  state.counters["json_bytes"] = static_cast<double>(json.size());
+  state.counters["arena_bytes"] = static_cast<double>(arena_bytes);
+}
+
+void BM_ParseSceneJsonTinygltf(benchmark::State &state) {
+  std::string json = MakeLargeSceneJson(state.range(0));
+  std::string error;
+  std::string warning;
+  for (auto _ : state) {
+    tinygltf::TinyGLTF loader;
+    tinygltf::Model model;
+    if (!loader.LoadASCIIFromString(&model, &error, &warning, json.c_str(),
+                                    static_cast<unsigned int>(json.size()),
+                                    "")) {
+      state.SkipWithError(error.c_str());
+      break;
+    }
+    benchmark::DoNotOptimize(model.accessors.data());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          static_cast<int64_t>(json.size()));
+  state.counters["json_bytes"] = static_cast<double>(json.size());
+}
+
+void RegisterBenchmarks() {
+  for (int64_t triangles = kMinTriangles; triangles <= kMaxTriangles;
+       triangles *= 10) {
+    benchmark::RegisterBenchmark("BM_ReadAccessorVec3", BM_ReadAccessorVec3)
+        ->Arg(triangles)
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("BM_ReadIndexAccessor", BM_ReadIndexAccessor)
+        ->Arg(triangles)
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("BM_ComputeNormalsFromIndices",
+                                 BM_ComputeNormalsFromIndices)
+        ->Arg(triangles)
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("BM_ComputeBounds", BM_ComputeBounds)
+        ->Arg(triangles)
+        ->Unit(benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("BM_BuildGltfMesh", BM_BuildGltfMesh)
+        ->Arg(triangles)
+        ->Unit(benchmark::kMicrosecond);
+    if (triangles <= kMaxLoadTriangles) {
+      benchmark::RegisterBenchmark("BM_LoadGltfMesh", BM_LoadGltfMesh)
+          ->Arg(triangles)
+          ->Unit(benchmark::kMillisecond);
+      benchmark::RegisterBenchmark("BM_DecodeGltfMeshInto",
+                                   BM_DecodeGltfMeshInto)
+          ->Arg(triangles)
+          ->Unit(benchmark::kMicrosecond);
+      benchmark::RegisterBenchmark("BM_BuildGltfMeshAndCopy",
+                                   BM_BuildGltfMeshAndCopy)
+          ->Arg(triangles)
+          ->Unit(benchmark::kMicrosecond);
+    }
+  }
+  for (int64_t objects = kMinSceneObjects; objects <= kMaxSceneObjects;
+       objects *= 10) {
+    benchmark::RegisterBenchmark("BM_ParseSceneJson", BM_ParseSceneJson)
+        ->Arg(objects)
+        ->Unit(benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("BM_ParseSceneJsonTinygltf",
+                                 BM_ParseSceneJsonTinygltf)
+        ->Arg(objects)
+        ->Unit(benchmark::kMillisecond);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  // Default to JSON on stdout; an explicit --benchmark_format still wins
+  // because later flags override earlier ones.
+  std::vector<char *> args(argv, argv + argc);
+  char json_format[] = "--benchmark_format=json";
+  args.insert(args.begin() + (argc > 0 ? 1 : 0), json_format);
+  int arg_count = static_cast<int>(args.size());
+  benchmark::Initialize(&arg_count, args.data());
+  if (benchmark::ReportUnrecognizedArguments(arg_count, args.data())) {
+    return 1;
+  }
+  RegisterBenchmarks();
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
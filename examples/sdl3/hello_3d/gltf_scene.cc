@@ -0,0 +1,1236 @@
+#include "examples/sdl3/hello_3d/gltf_scene.h"
+
+#include <meshoptimizer.h>
+#include <nlohmann/json.hpp>
+
+#include "examples/profiling/profile_zones.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+namespace bando {
+
+namespace {
+
+constexpr uint32_t kGlbMagic = 0x46546C67;       // "glTF"
+constexpr uint32_t kGlbChunkJson = 0x4E4F534A;   // "JSON"
+constexpr uint32_t kGlbChunkBinary = 0x004E4942;  // "BIN\0"
+constexpr uint32_t kGlbHeaderSize = 12;
+constexpr uint32_t kGlbChunkHeaderSize = 8;
+constexpr std::string_view kMeshoptExtension = "EXT_meshopt_compression";
+// Meshopt codecs spend at least a couple of control bits on every block of
+// a byte lane, so even all-zero attributes stay well under this many
+// decoded bytes per encoded byte. Bounds allocations from tiny files.
+constexpr size_t kMaxMeshoptExpansion = 1024;
+
+bool SetError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+uint32_t ReadU32(const unsigned char *bytes) {
+  uint32_t value = 0;
+  std::memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+// Reads a whole file into memory from `arena`.
+bool ReadFileToArena(const std::string &path,
+                     SceneArena *arena,
+                     const unsigned char **data,
+                     size_t *size) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file) {
+    return false;
+  }
+  std::streamsize length = file.tellg();
+  if (length < 0) {
+    return false;
+  }
+  auto *bytes = static_cast<unsigned char *>(
+      arena->Allocate(static_cast<size_t>(length), alignof(uint32_t)));
+  file.seekg(0, std::ios::beg);
+  file.read(reinterpret_cast<char *>(bytes), length);
+  if (!file.good()) {
+    return false;
+  }
+  *data = bytes;
+  *size = static_cast<size_t>(length);
+  return true;
+}
+
+int Base64Value(char c) {
+  if (c >= 'A' && c <= 'Z') {
+    return c - 'A';
+  }
+  if (c >= 'a' && c <= 'z') {
+    return c - 'a' + 26;
+  }
+  if (c >= '0' && c <= '9') {
+    return c - '0' + 52;
+  }
+  if (c == '+' || c == '-') {
+    return 62;
+  }
+  if (c == '/' || c == '_') {
+    return 63;
+  }
+  return -1;
+}
+
+// Upper bound of the decoded size; DecodeBase64 reports the exact one.
+size_t Base64MaxDecodedSize(std::string_view text) {
+  return (text.size() + 3) / 4 * 3;
+}
+
+bool DecodeBase64(std::string_view text, unsigned char *out, size_t *size) {
+  uint32_t bits = 0;
+  int bit_count = 0;
+  size_t written = 0;
+  for (char c : text) {
+    if (c == '=') {
+      break;
+    }
+    int value = Base64Value(c);
+    if (value < 0) {
+      return false;
+    }
+    bits = (bits << 6) | static_cast<uint32_t>(value);
+    bit_count += 6;
+    if (bit_count >= 8) {
+      bit_count -= 8;
+      out[written++] = static_cast<unsigned char>(bits >> bit_count);
+    }
+  }
+  *size = written;
+  return true;
+}
+
+// Payload of a base64 data URI, or an empty view with `is_data` false for
+// any other URI.
+bool DataUriPayload(std::string_view uri,
+                    std::string_view *payload,
+                    bool *is_data) {
+  *is_data = uri.substr(0, 5) == "data:";
+  if (!*is_data) {
+    return true;
+  }
+  size_t marker = uri.find(";base64,");
+  if (marker == std::string_view::npos) {
+    return false;
+  }
+  *payload = uri.substr(marker + std::strlen(";base64,"));
+  return true;
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// glTF URIs are percent-encoded (spaces in file names become %20).
+std::string UriToPath(const std::string &base_dir, std::string_view uri) {
+  std::string decoded;
+  decoded.reserve(uri.size());
+  for (size_t i = 0; i < uri.size(); ++i) {
+    if (uri[i] == '%' && i + 2 < uri.size()) {
+      int high = HexValue(uri[i + 1]);
+      int low = HexValue(uri[i + 2]);
+      if (high >= 0 && low >= 0) {
+        decoded.push_back(static_cast<char>(high * 16 + low));
+        i += 2;
+        continue;
+      }
+    }
+    decoded.push_back(uri[i]);
+  }
+  return (std::filesystem::path(base_dir) / decoded).string();
+}
+
+int ComponentsInType(std::string_view type) {
+  if (type == "SCALAR") {
+    return 1;
+  }
+  if (type == "VEC2") {
+    return 2;
+  }
+  if (type == "VEC3") {
+    return 3;
+  }
+  if (type == "VEC4" || type == "MAT2") {
+    return 4;
+  }
+  if (type == "MAT3") {
+    return 9;
+  }
+  if (type == "MAT4") {
+    return 16;
+  }
+  return 0;
+}
+
+// Sizes are clamped to the doubles that hold integers exactly; anything
+// outside, including negatives, is rejected rather than cast.
+bool ToSize(double value, size_t *out) {
+  if (!(value >= 0.0 && value <= 9007199254740992.0)) {
+    return false;
+  }
+  *out = static_cast<size_t>(value);
+  return true;
+}
+
+int ToIndex(double value) {
+  return value >= 0.0 && value <= 2147483647.0 ? static_cast<int>(value) : -1;
+}
+
+SceneAnimationPath ParseAnimationPath(std::string_view path) {
+  if (path == "translation") {
+    return SceneAnimationPath::kTranslation;
+  }
+  if (path == "rotation") {
+    return SceneAnimationPath::kRotation;
+  }
+  if (path == "scale") {
+    return SceneAnimationPath::kScale;
+  }
+  if (path == "weights") {
+    return SceneAnimationPath::kWeights;
+  }
+  return SceneAnimationPath::kUnknown;
+}
+
+SceneInterpolation ParseInterpolation(std::string_view interpolation) {
+  if (interpolation == "STEP") {
+    return SceneInterpolation::kStep;
+  }
+  if (interpolation == "CUBICSPLINE") {
+    return SceneInterpolation::kCubicSpline;
+  }
+  return SceneInterpolation::kLinear;
+}
+
+// SAX consumer keeping a stack of the glTF objects it is inside. Values
+// whose (object, key) pair is not listed below are dropped as they
+// stream by, and unknown objects or arrays are skipped by depth counting.
+class SceneSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+ public:
+  explicit SceneSaxHandler(GltfScene *scene) : scene_(scene) {}
+
+  const std::string &error() const { return error_; }
+
+  bool null() override { return skip_depth_ > 0 || HasRoot(); }
+
+  bool boolean(bool value) override {
+    if (skip_depth_ > 0) {
+      return true;
+    }
+    if (!HasRoot()) {
+      return false;
+    }
+    switch (Top()) {
+      case Context::kAccessor:
+        if (key_ == "normalized") {
+          scene_->accessors.back().normalized = value;
+        }
+        break;
+      case Context::kBufferMeshopt:
+        if (key_ == "fallback") {
+          scene_->buffers.back().meshopt_fallback = value;
+        }
+        break;
+      default:
+        break;
+    }
+    return true;
+  }
+
+  bool number_integer(number_integer_t value) override {
+    return Number(static_cast<double>(value));
+  }
+
+  bool number_unsigned(number_unsigned_t value) override {
+    return Number(static_cast<double>(value));
+  }
+
+  bool number_float(number_float_t value, const string_t &) override {
+    return Number(value);
+  }
+
+  bool string(string_t &value) override {
+    if (skip_depth_ > 0) {
+      return true;
+    }
+    if (!HasRoot()) {
+      return false;
+    }
+    switch (Top()) {
+      case Context::kBuffer:
+        if (key_ == "uri") {
+          scene_->buffers.back().uri = scene_->arena.CopyString(value);
+        }
+        break;
+      case Context::kViewMeshopt: {
+        MeshoptView &meshopt = scene_->buffer_views.back().meshopt;
+        if (key_ == "mode") {
+          meshopt.mode = ParseMeshoptMode(value);
+          if (meshopt.mode == MeshoptMode::kNone) {
+            return Fail("Unknown meshopt compression mode: " + value);
+          }
+        } else if (key_ == "filter") {
+          meshopt.filter = ParseMeshoptFilter(value);
+          if (meshopt.filter == MeshoptFilter::kNone && value != "NONE") {
+            return Fail("Unknown meshopt filter: " + value);
+          }
+        }
+        break;
+      }
+      case Context::kAccessor:
+        if (key_ == "type") {
+          scene_->accessors.back().components = ComponentsInType(value);
+        }
+        break;
+      case Context::kImage:
+        if (key_ == "uri") {
+          scene_->images.back().uri = scene_->arena.CopyString(value);
+        } else if (key_ == "mimeType") {
+          scene_->images.back().mime_type = scene_->arena.CopyString(value);
+        }
+        break;
+      case Context::kChannelTarget:
+        if (key_ == "path") {
+          scene_->animation_channels.back().path = ParseAnimationPath(value);
+        }
+        break;
+      case Context::kAnimationSampler:
+        if (key_ == "interpolation") {
+          scene_->animation_samplers.back().interpolation =
+              ParseInterpolation(value);
+        }
+        break;
+      case Context::kExtensionsRequired:
+        scene_->extensions_required.Append(&scene_->arena) =
+            scene_->arena.CopyString(value);
+        break;
+      default:
+        break;
+    }
+    return true;
+  }
+
+  bool binary(binary_t &) override { return true; }
+
+  bool start_object(std::size_t) override {
+    if (skip_depth_ > 0) {
+      ++skip_depth_;
+      return true;
+    }
+    if (stack_.empty()) {
+      stack_.push_back(Context::kRoot);
+      return true;
+    }
+    GltfScene &scene = *scene_;
+    switch (Top()) {
+      case Context::kBuffers:
+        scene.buffers.Append(&scene.arena);
+        return Push(Context::kBuffer);
+      case Context::kBufferViews:
+        scene.buffer_views.Append(&scene.arena);
+        return Push(Context::kBufferView);
+      case Context::kAccessors:
+        scene.accessors.Append(&scene.arena);
+        return Push(Context::kAccessor);
+      case Context::kMeshes:
+        scene.meshes.Append(&scene.arena).first_primitive =
+            scene.primitives.size();
+        return Push(Context::kMesh);
+      case Context::kPrimitives:
+        scene.primitives.Append(&scene.arena);
+        ++scene.meshes.back().primitive_count;
+        return Push(Context::kPrimitive);
+      case Context::kMaterials:
+        scene.materials.Append(&scene.arena);
+        return Push(Context::kMaterial);
+      case Context::kTextures:
+        scene.textures.Append(&scene.arena);
+        return Push(Context::kTexture);
+      case Context::kImages:
+        scene.images.Append(&scene.arena);
+        return Push(Context::kImage);
+      case Context::kNodes:
+        scene.nodes.Append(&scene.arena).first_child =
+            scene.node_children.size();
+        return Push(Context::kNode);
+      case Context::kSkins:
+        scene.skins.Append(&scene.arena).first_joint =
+            scene.skin_joints.size();
+        return Push(Context::kSkin);
+      case Context::kAnimations: {
+        SceneAnimation &animation = scene.animations.Append(&scene.arena);
+        animation.first_channel = scene.animation_channels.size();
+        animation.first_sampler = scene.animation_samplers.size();
+        return Push(Context::kAnimation);
+      }
+      case Context::kChannels:
+        scene.animation_channels.Append(&scene.arena);
+        ++scene.animations.back().channel_count;
+        return Push(Context::kChannel);
+      case Context::kAnimationSamplers:
+        scene.animation_samplers.Append(&scene.arena);
+        ++scene.animations.back().sampler_count;
+        return Push(Context::kAnimationSampler);
+      case Context::kChannel:
+        if (key_ == "target") {
+          return Push(Context::kChannelTarget);
+        }
+        break;
+      case Context::kBuffer:
+        if (key_ == "extensions") {
+          return Push(Context::kBufferExtensions);
+        }
+        break;
+      case Context::kBufferExtensions:
+        if (key_ == kMeshoptExtension) {
+          return Push(Context::kBufferMeshopt);
+        }
+        break;
+      case Context::kBufferView:
+        if (key_ == "extensions") {
+          return Push(Context::kViewExtensions);
+        }
+        break;
+      case Context::kViewExtensions:
+        if (key_ == kMeshoptExtension) {
+          return Push(Context::kViewMeshopt);
+        }
+        break;
+      case Context::kAccessor:
+        if (key_ == "sparse") {
+          scene.accessors.back().sparse = true;
+        }
+        break;
+      case Context::kPrimitive:
+        if (key_ == "attributes") {
+          return Push(Context::kAttributes);
+        }
+        break;
+      case Context::kMaterial:
+        if (key_ == "pbrMetallicRoughness") {
+          return Push(Context::kPbr);
+        }
+        if (key_ == "normalTexture") {
+          return Push(Context::kNormalTexture);
+        }
+        if (key_ == "occlusionTexture") {
+          return Push(Context::kOcclusionTexture);
+        }
+        if (key_ == "emissiveTexture") {
+          return Push(Context::kEmissiveTexture);
+        }
+        break;
+      case Context::kPbr:
+        if (key_ == "baseColorTexture") {
+          return Push(Context::kBaseColorTexture);
+        }
+        if (key_ == "metallicRoughnessTexture") {
+          return Push(Context::kMetallicRoughnessTexture);
+        }
+        break;
+      default:
+        break;
+    }
+    skip_depth_ = 1;
+    return true;
+  }
+
+  bool key(string_t &value) override {
+    if (skip_depth_ == 0) {
+      key_ = value;
+    }
+    return true;
+  }
+
+  bool end_object() override { return Pop(); }
+
+  bool start_array(std::size_t) override {
+    if (skip_depth_ > 0) {
+      ++skip_depth_;
+      return true;
+    }
+    if (!HasRoot()) {
+      return false;
+    }
+    switch (Top()) {
+      case Context::kRoot:
+        if (key_ == "buffers") {
+          return Push(Context::kBuffers);
+        }
+        if (key_ == "bufferViews") {
+          return Push(Context::kBufferViews);
+        }
+        if (key_ == "accessors") {
+          return Push(Context::kAccessors);
+        }
+        if (key_ == "meshes") {
+          return Push(Context::kMeshes);
+        }
+        if (key_ == "materials") {
+          return Push(Context::kMaterials);
+        }
+        if (key_ == "textures") {
+          return Push(Context::kTextures);
+        }
+        if (key_ == "images") {
+          return Push(Context::kImages);
+        }
+        if (key_ == "nodes") {
+          return Push(Context::kNodes);
+        }
+        if (key_ == "skins") {
+          return Push(Context::kSkins);
+        }
+        if (key_ == "animations") {
+          return Push(Context::kAnimations);
+        }
+        if (key_ == "extensionsRequired") {
+          return Push(Context::kExtensionsRequired);
+        }
+        break;
+      case Context::kMesh:
+        if (key_ == "primitives") {
+          return Push(Context::kPrimitives);
+        }
+        break;
+      case Context::kNode:
+        array_index_ = 0;
+        if (key_ == "children") {
+          return Push(Context::kNodeChildren);
+        }
+        if (key_ == "translation") {
+          return Push(Context::kNodeTranslation);
+        }
+        if (key_ == "rotation") {
+          return Push(Context::kNodeRotation);
+        }
+        if (key_ == "scale") {
+          return Push(Context::kNodeScale);
+        }
+        if (key_ == "matrix") {
+          scene_->nodes.back().has_matrix = true;
+          return Push(Context::kNodeMatrix);
+        }
+        break;
+      case Context::kSkin:
+        if (key_ == "joints") {
+          return Push(Context::kSkinJoints);
+        }
+        break;
+      case Context::kAnimation:
+        if (key_ == "channels") {
+          return Push(Context::kChannels);
+        }
+        if (key_ == "samplers") {
+          return Push(Context::kAnimationSamplers);
+        }
+        break;
+      case Context::kPbr:
+        if (key_ == "baseColorFactor") {
+          array_index_ = 0;
+          return Push(Context::kBaseColorFactor);
+        }
+        break;
+      default:
+        break;
+    }
+    skip_depth_ = 1;
+    return true;
+  }
+
+  bool end_array() override { return Pop(); }
+
+  bool parse_error(std::size_t position,
+                   const std::string &,
+                   const nlohmann::detail::exception &exception) override {
+    return Fail("glTF JSON parse error at byte " + std::to_string(position) +
+                ": " + exception.what());
+  }
+
+ private:
+  enum class Context : uint8_t {
+    kRoot,
+    kBuffers,
+    kBuffer,
+    kBufferExtensions,
+    kBufferMeshopt,
+    kBufferViews,
+    kBufferView,
+    kViewExtensions,
+    kViewMeshopt,
+    kAccessors,
+    kAccessor,
+    kMeshes,
+    kMesh,
+    kPrimitives,
+    kPrimitive,
+    kAttributes,
+    kMaterials,
+    kMaterial,
+    kPbr,
+    kBaseColorFactor,
+    kBaseColorTexture,
+    kMetallicRoughnessTexture,
+    kNormalTexture,
+    kOcclusionTexture,
+    kEmissiveTexture,
+    kTextures,
+    kTexture,
+    kImages,
+    kImage,
+    kNodes,
+    kNode,
+    kNodeChildren,
+    kNodeTranslation,
+    kNodeRotation,
+    kNodeScale,
+    kNodeMatrix,
+    kSkins,
+    kSkin,
+    kSkinJoints,
+    kAnimations,
+    kAnimation,
+    kChannels,
+    kChannel,
+    kChannelTarget,
+    kAnimationSamplers,
+    kAnimationSampler,
+    kExtensionsRequired,
+  };
+
+  Context Top() const { return stack_.back(); }
+
+  // Only start_object may open the root; every other callback needs it.
+  bool HasRoot() {
+    return !stack_.empty() || Fail("glTF root must be an object");
+  }
+
+  bool Size(double value, size_t *out) {
+    if (!ToSize(value, out)) {
+      return Fail("glTF " + key_ + " out of range");
+    }
+    return true;
+  }
+
+  bool Push(Context context) {
+    stack_.push_back(context);
+    return true;
+  }
+
+  bool Pop() {
+    if (skip_depth_ > 0) {
+      --skip_depth_;
+    } else {
+      stack_.pop_back();
+    }
+    return true;
+  }
+
+  bool Fail(const std::string &message) {
+    if (error_.empty()) {
+      error_ = message;
+    }
+    return false;
+  }
+
+  bool Number(double value) {
+    if (skip_depth_ > 0) {
+      return true;
+    }
+    if (!HasRoot()) {
+      return false;
+    }
+    GltfScene &scene = *scene_;
+    switch (Top()) {
+      case Context::kBuffer:
+        if (key_ == "byteLength") {
+          return Size(value, &scene.buffers.back().byte_length);
+        }
+        break;
+      case Context::kBufferView: {
+        SceneBufferView &view = scene.buffer_views.back();
+        if (key_ == "buffer") {
+          view.buffer = ToIndex(value);
+        } else if (key_ == "byteOffset") {
+          return Size(value, &view.byte_offset);
+        } else if (key_ == "byteLength") {
+          return Size(value, &view.byte_length);
+        } else if (key_ == "byteStride") {
+          return Size(value, &view.byte_stride);
+        }
+        break;
+      }
+      case Context::kViewMeshopt: {
+        MeshoptView &meshopt = scene.buffer_views.back().meshopt;
+        if (key_ == "buffer") {
+          meshopt.buffer = ToIndex(value);
+        } else if (key_ == "byteOffset") {
+          return Size(value, &meshopt.byte_offset);
+        } else if (key_ == "byteLength") {
+          return Size(value, &meshopt.byte_length);
+        } else if (key_ == "byteStride") {
+          return Size(value, &meshopt.byte_stride);
+        } else if (key_ == "count") {
+          return Size(value, &meshopt.count);
+        }
+        break;
+      }
+      case Context::kAccessor: {
+        SceneAccessor &accessor = scene.accessors.back();
+        if (key_ == "bufferView") {
+          accessor.buffer_view = ToIndex(value);
+        } else if (key_ == "byteOffset") {
+          return Size(value, &accessor.byte_offset);
+        } else if (key_ == "componentType") {
+          accessor.component_type = ToIndex(value);
+        } else if (key_ == "count") {
+          return Size(value, &accessor.count);
+        }
+        break;
+      }
+      case Context::kPrimitive: {
+        ScenePrimitive &primitive = scene.primitives.back();
+        if (key_ == "indices") {
+          primitive.indices = ToIndex(value);
+        } else if (key_ == "material") {
+          primitive.material = ToIndex(value);
+        } else if (key_ == "mode") {
+          primitive.mode = ToIndex(value);
+        }
+        break;
+      }
+      case Context::kAttributes: {
+        ScenePrimitive &primitive = scene.primitives.back();
+        if (key_ == "POSITION") {
+          primitive.position = ToIndex(value);
+        } else if (key_ == "NORMAL") {
+          primitive.normal = ToIndex(value);
+        } else if (key_ == "TEXCOORD_0") {
+          primitive.texcoord0 = ToIndex(value);
+        } else if (key_ == "JOINTS_0") {
+          primitive.joints0 = ToIndex(value);
+        } else if (key_ == "WEIGHTS_0") {
+          primitive.weights0 = ToIndex(value);
+        }
+        break;
+      }
+      case Context::kBaseColorFactor:
+        StoreArrayValue(scene.materials.back().base_color_factor, 4, value);
+        break;
+      case Context::kBaseColorTexture:
+        if (key_ == "index") {
+          scene.materials.back().base_color_texture = ToIndex(value);
+        }
+        break;
+      case Context::kMetallicRoughnessTexture:
+        if (key_ == "index") {
+          scene.materials.back().metallic_roughness_texture = ToIndex(value);
+        }
+        break;
+      case Context::kNormalTexture:
+        if (key_ == "index") {
+          scene.materials.back().normal_texture = ToIndex(value);
+        }
+        break;
+      case Context::kOcclusionTexture:
+        if (key_ == "index") {
+          scene.materials.back().occlusion_texture = ToIndex(value);
+        }
+        break;
+      case Context::kEmissiveTexture:
+        if (key_ == "index") {
+          scene.materials.back().emissive_texture = ToIndex(value);
+        }
+        break;
+      case Context::kTexture:
+        if (key_ == "source") {
+          scene.textures.back().source = ToIndex(value);
+        }
+        break;
+      case Context::kImage:
+        if (key_ == "bufferView") {
+          scene.images.back().buffer_view = ToIndex(value);
+        }
+        break;
+      case Context::kNode:
+        if (key_ == "mesh") {
+          scene.nodes.back().mesh = ToIndex(value);
+        } else if (key_ == "skin") {
+          scene.nodes.back().skin = ToIndex(value);
+        }
+        break;
+      case Context::kNodeChildren:
+        scene.node_children.Append(&scene.arena) = ToIndex(value);
+        ++scene.nodes.back().child_count;
+        break;
+      case Context::kNodeTranslation:
+        StoreArrayValue(scene.nodes.back().translation, 3, value);
+        break;
+      case Context::kNodeRotation:
+        StoreArrayValue(scene.nodes.back().rotation, 4, value);
+        break;
+      case Context::kNodeScale:
+        StoreArrayValue(scene.nodes.back().scale, 3, value);
+        break;
+      case Context::kNodeMatrix:
+        StoreArrayValue(scene.nodes.back().matrix, 16, value);
+        break;
+      case Context::kSkin:
+        if (key_ == "inverseBindMatrices") {
+          scene.skins.back().inverse_bind_matrices = ToIndex(value);
+        } else if (key_ == "skeleton") {
+          scene.skins.back().skeleton = ToIndex(value);
+        }
+        break;
+      case Context::kSkinJoints:
+        scene.skin_joints.Append(&scene.arena) = ToIndex(value);
+        ++scene.skins.back().joint_count;
+        break;
+      case Context::kChannel:
+        if (key_ == "sampler") {
+          scene.animation_channels.back().sampler = ToIndex(value);
+        }
+        break;
+      case Context::kChannelTarget:
+        if (key_ == "node") {
+          scene.animation_channels.back().node = ToIndex(value);
+        }
+        break;
+      case Context::kAnimationSampler:
+        if (key_ == "input") {
+          scene.animation_samplers.back().input = ToIndex(value);
+        } else if (key_ == "output") {
+          scene.animation_samplers.back().output = ToIndex(value);
+        }
+        break;
+      default:
+        break;
+    }
+    return true;
+  }
+
+  // Stores element `array_index_` of a fixed-size number array.
+  void StoreArrayValue(float *values, int size, double value) {
+    if (array_index_ < size) {
+      values[array_index_++] = static_cast<float>(value);
+    }
+  }
+
+  GltfScene *scene_;
+  std::vector<Context> stack_;
+  // Key of the value about to arrive in the innermost object.
+  std::string key_;
+  // Nesting depth inside an object or array being skipped.
+  int skip_depth_ = 0;
+  int array_index_ = 0;
+  std::string error_;
+};
+
+bool ResolveBuffers(GltfScene *scene,
+                    const unsigned char *glb_binary,
+                    size_t glb_binary_size,
+                    std::string *error) {
+  BANDO_PROFILE_ZONE("ResolveBuffers");
+  for (size_t i = 0; i < scene->buffers.size(); ++i) {
+    SceneBuffer &buffer = scene->buffers[i];
+    std::string name = "Buffer " + std::to_string(i);
+    if (buffer.uri.empty()) {
+      if (i == 0 && glb_binary) {
+        buffer.data = glb_binary;
+        buffer.size = glb_binary_size;
+      } else if (!buffer.meshopt_fallback) {
+        return SetError(error, name + " has no data");
+      }
+    } else {
+      std::string_view payload;
+      bool is_data = false;
+      if (!DataUriPayload(buffer.uri, &payload, &is_data)) {
+        return SetError(error, name + " has an unsupported data URI");
+      }
+      if (is_data) {
+        auto *bytes = static_cast<unsigned char *>(scene->arena.Allocate(
+            Base64MaxDecodedSize(payload), alignof(uint32_t)));
+        if (!DecodeBase64(payload, bytes, &buffer.size)) {
+          return SetError(error, name + " has invalid base64 data");
+        }
+        buffer.data = bytes;
+      } else if (!ReadFileToArena(UriToPath(scene->base_dir, buffer.uri),
+                                  &scene->arena, &buffer.data,
+                                  &buffer.size)) {
+        return SetError(error, "Failed to read " + std::string(buffer.uri));
+      }
+    }
+    if (buffer.data && buffer.size < buffer.byte_length) {
+      return SetError(error, name + " is shorter than its byteLength");
+    }
+  }
+  return true;
+}
+
+bool DecodeMeshoptViews(GltfScene *scene, std::string *error) {
+  BANDO_PROFILE_ZONE("DecodeMeshoptViews");
+  for (SceneBufferView &view : scene->buffer_views) {
+    const MeshoptView &meshopt = view.meshopt;
+    if (meshopt.mode == MeshoptMode::kNone) {
+      continue;
+    }
+    if (meshopt.buffer < 0 ||
+        meshopt.buffer >= static_cast<int>(scene->buffers.size())) {
+      return SetError(error, "Meshopt buffer view source out of range");
+    }
+    const SceneBuffer &source = scene->buffers[meshopt.buffer];
+    if (!source.data || meshopt.byte_length > source.size ||
+        meshopt.byte_offset > source.size - meshopt.byte_length) {
+      return SetError(error, "Meshopt buffer view source out of range");
+    }
+    size_t size = 0;
+    if (!MeshoptDecodedSize(meshopt, &size, error)) {
+      return false;
+    }
+    auto *decoded = static_cast<unsigned char *>(
+        scene->arena.Allocate(size, alignof(uint32_t)));
+    if (!DecodeMeshoptView(meshopt, source.data + meshopt.byte_offset,
+                           decoded, error)) {
+      return false;
+    }
+    SceneBuffer &buffer = scene->buffers.Append(&scene->arena);
+    buffer.byte_length = size;
+    buffer.data = decoded;
+    buffer.size = size;
+    view.buffer = static_cast<int>(scene->buffers.size() - 1);
+    view.byte_offset = 0;
+    view.byte_length = size;
+    view.meshopt = MeshoptView();
+  }
+  return true;
+}
+
+}  // namespace
+
+SceneArena::SceneArena(size_t block_size) : block_size_(block_size) {}
+
+void *SceneArena::Allocate(size_t size, size_t alignment) {
+  size_t padding =
+      cursor_ ? (alignment - reinterpret_cast<uintptr_t>(cursor_) % alignment) %
+                    alignment
+              : 0;
+  if (!cursor_ || padding + size > remaining_) {
+    // Oversized requests get a dedicated block so the current one keeps
+    // serving small allocations.
+    if (size + alignment > block_size_ / 4) {
+      blocks_.emplace_back(new unsigned char[size + alignment]);
+      reserved_bytes_ += size + alignment;
+      uintptr_t address = reinterpret_cast<uintptr_t>(blocks_.back().get());
+      address += (alignment - address % alignment) % alignment;
+      used_bytes_ += size;
+      return reinterpret_cast<void *>(address);
+    }
+    blocks_.emplace_back(new unsigned char[block_size_]);
+    reserved_bytes_ += block_size_;
+    cursor_ = blocks_.back().get();
+    remaining_ = block_size_;
+    padding = (alignment - reinterpret_cast<uintptr_t>(cursor_) % alignment) %
+              alignment;
+  }
+  void *result = cursor_ + padding;
+  cursor_ += padding + size;
+  remaining_ -= padding + size;
+  used_bytes_ += size;
+  return result;
+}
+
+std::string_view SceneArena::CopyString(std::string_view value) {
+  if (value.empty()) {
+    return std::string_view();
+  }
+  char *copy = static_cast<char *>(Allocate(value.size(), 1));
+  std::memcpy(copy, value.data(), value.size());
+  return std::string_view(copy, value.size());
+}
+
+MeshoptMode ParseMeshoptMode(std::string_view mode) {
+  if (mode == "ATTRIBUTES") {
+    return MeshoptMode::kAttributes;
+  }
+  if (mode == "TRIANGLES") {
+    return MeshoptMode::kTriangles;
+  }
+  if (mode == "INDICES") {
+    return MeshoptMode::kIndices;
+  }
+  return MeshoptMode::kNone;
+}
+
+MeshoptFilter ParseMeshoptFilter(std::string_view filter) {
+  if (filter == "OCTAHEDRAL") {
+    return MeshoptFilter::kOctahedral;
+  }
+  if (filter == "QUATERNION") {
+    return MeshoptFilter::kQuaternion;
+  }
+  if (filter == "EXPONENTIAL") {
+    return MeshoptFilter::kExponential;
+  }
+  return MeshoptFilter::kNone;
+}
+
+bool MeshoptDecodedSize(const MeshoptView &view,
+                        size_t *size,
+                        std::string *error) {
+  size_t count = view.count;
+  size_t stride = view.byte_stride;
+  if (count == 0 || stride == 0) {
+    return SetError(error, "Meshopt buffer view has no elements");
+  }
+  if (stride > 256) {
+    return SetError(error, "Invalid meshopt stride");
+  }
+  switch (view.mode) {
+    case MeshoptMode::kAttributes:
+      if (stride % 4 != 0) {
+        return SetError(error, "Invalid meshopt attribute stride");
+      }
+      break;
+    case MeshoptMode::kTriangles:
+      if ((stride != 2 && stride != 4) || count % 3 != 0) {
+        return SetError(error, "Invalid meshopt triangle index layout");
+      }
+      break;
+    case MeshoptMode::kIndices:
+      if (stride != 2 && stride != 4) {
+        return SetError(error, "Invalid meshopt index stride");
+      }
+      break;
+    case MeshoptMode::kNone:
+      return SetError(error, "Unknown meshopt compression mode");
+  }
+  // Filter strides are checked for every mode; the filters assert on them.
+  switch (view.filter) {
+    case MeshoptFilter::kNone:
+      break;
+    case MeshoptFilter::kOctahedral:
+      if (stride != 4 && stride != 8) {
+        return SetError(error, "Invalid meshopt octahedral filter stride");
+      }
+      break;
+    case MeshoptFilter::kQuaternion:
+      if (stride != 8) {
+        return SetError(error, "Invalid meshopt quaternion filter stride");
+      }
+      break;
+    case MeshoptFilter::kExponential:
+      if (stride % 4 != 0) {
+        return SetError(error, "Invalid meshopt exponential filter stride");
+      }
+      break;
+  }
+  if (count > std::numeric_limits<size_t>::max() / stride ||
+      count * stride / kMaxMeshoptExpansion > view.byte_length) {
+    return SetError(error, "Meshopt buffer view count out of range");
+  }
+  if (size) {
+    *size = count * stride;
+  }
+  return true;
+}
+
+bool DecodeMeshoptView(const MeshoptView &view,
+                       const unsigned char *encoded,
+                       unsigned char *out,
+                       std::string *error) {
+  if (!MeshoptDecodedSize(view, nullptr, error)) {
+    return false;
+  }
+  size_t count = view.count;
+  size_t stride = view.byte_stride;
+  int result = -1;
+  switch (view.mode) {
+    case MeshoptMode::kAttributes:
+      result = meshopt_decodeVertexBuffer(out, count, stride, encoded,
+                                          view.byte_length);
+      break;
+    case MeshoptMode::kTriangles:
+      result = meshopt_decodeIndexBuffer(out, count, stride, encoded,
+                                         view.byte_length);
+      break;
+    case MeshoptMode::kIndices:
+      result = meshopt_decodeIndexSequence(out, count, stride, encoded,
+                                           view.byte_length);
+      break;
+    case MeshoptMode::kNone:
+      break;
+  }
+  if (result != 0) {
+    return SetError(error, "Corrupt meshopt compressed buffer view");
+  }
+  switch (view.filter) {
+    case MeshoptFilter::kNone:
+      break;
+    case MeshoptFilter::kOctahedral:
+      meshopt_decodeFilterOct(out, count, stride);
+      break;
+    case MeshoptFilter::kQuaternion:
+      meshopt_decodeFilterQuat(out, count, stride);
+      break;
+    case MeshoptFilter::kExponential:
+      meshopt_decodeFilterExp(out, count, stride);
+      break;
+  }
+  return true;
+}
+
+bool ParseGltfSceneJson(const char *json,
+                        size_t size,
+                        GltfScene *scene,
+                        std::string *error) {
+  BANDO_PROFILE_ZONE("ParseGltfSceneJson");
+  if (!json || !scene) {
+    return false;
+  }
+  SceneSaxHandler handler(scene);
+  if (!nlohmann::json::sax_parse(json, json + size, &handler)) {
+    return SetError(error, handler.error().empty() ? "Invalid glTF JSON"
+                                                   : handler.error());
+  }
+  return true;
+}
+
+bool LoadGltfScene(const std::string &path,
+                   GltfScene *scene,
+                   std::string *error) {
+  BANDO_PROFILE_ZONE("LoadGltfScene");
+  if (!scene) {
+    return false;
+  }
+  const unsigned char *file = nullptr;
+  size_t file_size = 0;
+  {
+    BANDO_PROFILE_ZONE("ReadFile");
+    if (!ReadFileToArena(path, &scene->arena, &file, &file_size)) {
+      return SetError(error, "Failed to read " + path);
+    }
+  }
+  scene->base_dir = std::filesystem::path(path).parent_path().string();
+
+  const char *json = reinterpret_cast<const char *>(file);
+  size_t json_size = file_size;
+  const unsigned char *binary = nullptr;
+  size_t binary_size = 0;
+  if (file_size >= 4 && ReadU32(file) == kGlbMagic) {
+    if (file_size < kGlbHeaderSize + kGlbChunkHeaderSize) {
+      return SetError(error, "Truncated GLB header");
+    }
+    size_t offset = kGlbHeaderSize;
+    size_t length = std::min<size_t>(ReadU32(file + 8), file_size);
+    json = nullptr;
+    while (offset + kGlbChunkHeaderSize <= length) {
+      size_t chunk_size = ReadU32(file + offset);
+      uint32_t chunk_type = ReadU32(file + offset + 4);
+      size_t chunk_start = offset + kGlbChunkHeaderSize;
+      if (chunk_start + chunk_size > length) {
+        return SetError(error, "GLB chunk runs past the end of the file");
+      }
+      if (chunk_type == kGlbChunkJson && !json) {
+        json = reinterpret_cast<const char *>(file + chunk_start);
+        json_size = chunk_size;
+      } else if (chunk_type == kGlbChunkBinary && !binary) {
+        binary = file + chunk_start;
+        binary_size = chunk_size;
+      }
+      offset = chunk_start + (chunk_size + 3) / 4 * 4;
+    }
+    if (!json) {
+      return SetError(error, "GLB has no JSON chunk");
+    }
+  }
+  return ParseGltfSceneJson(json, json_size, scene, error) &&
+         ResolveBuffers(scene, binary, binary_size, error) &&
+         DecodeMeshoptViews(scene, error);
+}
+
+bool ReadSceneImage(const GltfScene &scene,
+                    int image_index,
+                    std::vector<uint8_t> *out,
+                    std::string *error) {
+  if (!out) {
+    return false;
+  }
+  if (image_index < 0 ||
+      image_index >= static_cast<int>(scene.images.size())) {
+    return SetError(error, "Image index out of range");
+  }
+  const SceneImage &image = scene.images[image_index];
+  if (image.buffer_view >= 0) {
+    if (image.buffer_view >= static_cast<int>(scene.buffer_views.size())) {
+      return SetError(error, "Image buffer view out of range");
+    }
+    const SceneBufferView &view = scene.buffer_views[image.buffer_view];
+    if (view.buffer < 0 ||
+        view.buffer >= static_cast<int>(scene.buffers.size()) ||
+        !scene.buffers[view.buffer].data ||
+        view.byte_offset + view.byte_length >
+            scene.buffers[view.buffer].size) {
+      return SetError(error, "Image buffer view out of range");
+    }
+    const unsigned char *data =
+        scene.buffers[view.buffer].data + view.byte_offset;
+    out->assign(data, data + view.byte_length);
+    return true;
+  }
+  std::string_view payload;
+  bool is_data = false;
+  if (!DataUriPayload(image.uri, &payload, &is_data)) {
+    return SetError(error, "Image has an unsupported data URI");
+  }
+  if (is_data) {
+    out->resize(Base64MaxDecodedSize(payload));
+    size_t size = 0;
+    if (!DecodeBase64(payload, out->data(), &size)) {
+      return SetError(error, "Image has invalid base64 data");
+    }
+    out->resize(size);
+    return true;
+  }
+  std::string path = UriToPath(scene.base_dir, image.uri);
+  std::ifstream file(path, std::ios::binary);
+  if (image.uri.empty() || !file) {
+    return SetError(error, "Failed to read image " + path);
+  }
+  out->assign(std::istreambuf_iterator<char>(file),
+              std::istreambuf_iterator<char>());
+  return true;
+}
+
+int SceneTextureImage(const GltfScene &scene, int texture_index) {
+  if (texture_index < 0 ||
+      texture_index >= static_cast<int>(scene.textures.size())) {
+    return -1;
+  }
+  int source = scene.textures[texture_index].source;
+  if (source < 0 || source >= static_cast<int>(scene.images.size())) {
+    return -1;
+  }
+  return source;
+}
+
+}  // namespace bando
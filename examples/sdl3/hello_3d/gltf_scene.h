@@ -0,0 +1,309 @@
+#ifndef EXAMPLES_SDL3_HELLO_3D_GLTF_SCENE_H_
+#define EXAMPLES_SDL3_HELLO_3D_GLTF_SCENE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Compact glTF scene description for assets whose JSON is too large for
+// tinygltf: the JSON chunk is streamed through nlohmann's SAX interface
+// straight into flat arrays allocated from one arena, keeping only the
+// properties the mesh and animation loaders read. No JSON DOM, per-object
+// strings or maps are built, and extras plus every extension except
+// EXT_meshopt_compression are skipped without being stored.
+
+namespace bando {
+
+// Bump allocator handing out memory from large blocks that are all freed
+// together with the arena. Requests larger than a block get a block of
+// their own, so file contents can live in the arena as well.
+class SceneArena {
+ public:
+  explicit SceneArena(size_t block_size = 64 * 1024);
+  SceneArena(const SceneArena &) = delete;
+  SceneArena &operator=(const SceneArena &) = delete;
+
+  // Never returns null; throws std::bad_alloc like operator new.
+  void *Allocate(size_t size, size_t alignment);
+  std::string_view CopyString(std::string_view value);
+
+  // Bytes handed out, and bytes obtained from the system.
+  size_t used_bytes() const { return used_bytes_; }
+  size_t reserved_bytes() const { return reserved_bytes_; }
+
+ private:
+  size_t block_size_;
+  std::vector<std::unique_ptr<unsigned char[]>> blocks_;
+  unsigned char *cursor_ = nullptr;
+  size_t remaining_ = 0;
+  size_t used_bytes_ = 0;
+  size_t reserved_bytes_ = 0;
+};
+
+// Growable array stored in a SceneArena. Growth copies into an allocation
+// of twice the capacity and abandons the old one to the arena, which
+// bounds the waste to the size of the live array.
+template <typename T>
+class ArenaArray {
+  static_assert(std::is_trivially_copyable_v<T> &&
+                    std::is_trivially_destructible_v<T>,
+                "ArenaArray elements are copied with memcpy and never "
+                "destroyed");
+
+ public:
+  T &Append(SceneArena *arena) {
+    if (size_ == capacity_) {
+      size_t capacity = capacity_ ? capacity_ * 2 : 8;
+      T *data = static_cast<T *>(
+          arena->Allocate(capacity * sizeof(T), alignof(T)));
+      if (size_ > 0) {
+        std::memcpy(static_cast<void *>(data), data_, size_ * sizeof(T));
+      }
+      data_ = data;
+      capacity_ = capacity;
+    }
+    return *new (data_ + size_++) T{};
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T &operator[](size_t index) { return data_[index]; }
+  const T &operator[](size_t index) const { return data_[index]; }
+  T &back() { return data_[size_ - 1]; }
+  T *begin() { return data_; }
+  T *end() { return data_ + size_; }
+  const T *begin() const { return data_; }
+  const T *end() const { return data_ + size_; }
+
+ private:
+  T *data_ = nullptr;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+};
+
+enum class MeshoptMode : uint8_t {
+  kNone,
+  kAttributes,
+  kTriangles,
+  kIndices,
+};
+
+enum class MeshoptFilter : uint8_t {
+  kNone,
+  kOctahedral,
+  kQuaternion,
+  kExponential,
+};
+
+// EXT_meshopt_compression properties of a buffer view.
+struct MeshoptView {
+  MeshoptMode mode = MeshoptMode::kNone;
+  MeshoptFilter filter = MeshoptFilter::kNone;
+  int buffer = -1;
+  size_t byte_offset = 0;
+  size_t byte_length = 0;
+  size_t byte_stride = 0;
+  size_t count = 0;
+};
+
+struct SceneBuffer {
+  // Empty for the GLB binary chunk and for meshopt fallback buffers.
+  std::string_view uri;
+  size_t byte_length = 0;
+  bool meshopt_fallback = false;
+  // Filled in by LoadGltfScene; null for meshopt fallback buffers.
+  const unsigned char *data = nullptr;
+  size_t size = 0;
+};
+
+struct SceneBufferView {
+  int buffer = -1;
+  size_t byte_offset = 0;
+  size_t byte_length = 0;
+  size_t byte_stride = 0;
+  MeshoptView meshopt;
+};
+
+struct SceneAccessor {
+  int buffer_view = -1;
+  size_t byte_offset = 0;
+  size_t count = 0;
+  // glTF componentType value (5120 BYTE ... 5126 FLOAT).
+  int component_type = 0;
+  // 1 for SCALAR up to 16 for MAT4, 0 for an unknown type.
+  int components = 0;
+  bool normalized = false;
+  bool sparse = false;
+};
+
+struct ScenePrimitive {
+  int position = -1;
+  int normal = -1;
+  int texcoord0 = -1;
+  int joints0 = -1;
+  int weights0 = -1;
+  int indices = -1;
+  int material = -1;
+  int mode = 4;  // TRIANGLES
+};
+
+// Primitives of all meshes are stored back to back in GltfScene.
+struct SceneMesh {
+  size_t first_primitive = 0;
+  size_t primitive_count = 0;
+};
+
+struct SceneMaterial {
+  float base_color_factor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  // glTF texture indices, -1 when the material has no such texture.
+  int base_color_texture = -1;
+  int metallic_roughness_texture = -1;
+  int normal_texture = -1;
+  int occlusion_texture = -1;
+  int emissive_texture = -1;
+};
+
+struct SceneTexture {
+  int source = -1;
+};
+
+struct SceneImage {
+  std::string_view uri;
+  std::string_view mime_type;
+  int buffer_view = -1;
+};
+
+struct SceneNode {
+  int mesh = -1;
+  int skin = -1;
+  // Children of all nodes are stored back to back in
+  // GltfScene::node_children.
+  size_t first_child = 0;
+  size_t child_count = 0;
+  float translation[3] = {0.0f, 0.0f, 0.0f};
+  float rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f};  // x, y, z, w
+  float scale[3] = {1.0f, 1.0f, 1.0f};
+  // Column-major local transform, used instead of TRS when `has_matrix`.
+  float matrix[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+                      0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+  bool has_matrix = false;
+};
+
+// Joints of all skins are stored back to back in GltfScene::skin_joints.
+struct SceneSkin {
+  int inverse_bind_matrices = -1;
+  int skeleton = -1;
+  size_t first_joint = 0;
+  size_t joint_count = 0;
+};
+
+enum class SceneAnimationPath : uint8_t {
+  kUnknown,
+  kTranslation,
+  kRotation,
+  kScale,
+  kWeights,
+};
+
+enum class SceneInterpolation : uint8_t {
+  kLinear,
+  kStep,
+  kCubicSpline,
+};
+
+struct SceneAnimationChannel {
+  // Relative to the animation's first_sampler.
+  int sampler = -1;
+  int node = -1;
+  SceneAnimationPath path = SceneAnimationPath::kUnknown;
+};
+
+struct SceneAnimationSampler {
+  int input = -1;
+  int output = -1;
+  SceneInterpolation interpolation = SceneInterpolation::kLinear;
+};
+
+// Channels and samplers of all animations are stored back to back in
+// GltfScene.
+struct SceneAnimation {
+  size_t first_channel = 0;
+  size_t channel_count = 0;
+  size_t first_sampler = 0;
+  size_t sampler_count = 0;
+};
+
+struct GltfScene {
+  SceneArena arena;
+  ArenaArray<SceneBuffer> buffers;
+  ArenaArray<SceneBufferView> buffer_views;
+  ArenaArray<SceneAccessor> accessors;
+  ArenaArray<SceneMesh> meshes;
+  ArenaArray<ScenePrimitive> primitives;
+  ArenaArray<SceneMaterial> materials;
+  ArenaArray<SceneTexture> textures;
+  ArenaArray<SceneImage> images;
+  ArenaArray<SceneNode> nodes;
+  ArenaArray<int> node_children;
+  ArenaArray<SceneSkin> skins;
+  ArenaArray<int> skin_joints;
+  ArenaArray<SceneAnimation> animations;
+  ArenaArray<SceneAnimationChannel> animation_channels;
+  ArenaArray<SceneAnimationSampler> animation_samplers;
+  ArenaArray<std::string_view> extensions_required;
+  // Directory relative buffer and image URIs are resolved against.
+  std::string base_dir;
+};
+
+MeshoptMode ParseMeshoptMode(std::string_view mode);
+MeshoptFilter ParseMeshoptFilter(std::string_view filter);
+
+// Validates the view's mode, stride, filter and count, and sets *size to
+// the decoded byte count (count * byte_stride). Callers check this before
+// allocating the output of DecodeMeshoptView.
+bool MeshoptDecodedSize(const MeshoptView &view,
+                        size_t *size,
+                        std::string *error);
+
+// Decodes one EXT_meshopt_compression buffer view from `encoded` (the
+// view's byte_length bytes) into `out`, which must hold count * byte_stride
+// bytes. Parameters the decoder would assert on are rejected instead.
+bool DecodeMeshoptView(const MeshoptView &view,
+                       const unsigned char *encoded,
+                       unsigned char *out,
+                       std::string *error);
+
+// Streams a glTF JSON document into `scene`, appending to its arrays.
+// Buffers are not resolved; see LoadGltfScene.
+bool ParseGltfSceneJson(const char *json,
+                        size_t size,
+                        GltfScene *scene,
+                        std::string *error);
+
+// Reads a .gltf or .glb file (detected from its header) into `scene`.
+// Buffers are resolved from the GLB binary chunk, base64 data URIs or
+// files next to the asset, all copied into the scene's arena, and meshopt
+// compressed buffer views are decoded into buffers of their own.
+bool LoadGltfScene(const std::string &path,
+                   GltfScene *scene,
+                   std::string *error);
+
+// Encoded (PNG/JPEG) bytes of image `image_index`, from its buffer view,
+// data URI or file.
+bool ReadSceneImage(const GltfScene &scene,
+                    int image_index,
+                    std::vector<uint8_t> *out,
+                    std::string *error);
+
+// Image index behind a material texture index, -1 when there is none.
+int SceneTextureImage(const GltfScene &scene, int texture_index);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_SDL3_HELLO_3D_GLTF_SCENE_H_
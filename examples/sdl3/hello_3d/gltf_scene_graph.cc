@@ -0,0 +1,111 @@
+#include "examples/sdl3/hello_3d/gltf_scene_graph.h"
+
+namespace bando {
+
+namespace {
+
+bool SetError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+}  // namespace
+
+bool GltfNodeParents(const GltfScene &scene,
+                     std::vector<int> *parents,
+                     std::string *error) {
+  parents->assign(scene.nodes.size(), -1);
+  for (size_t i = 0; i < scene.nodes.size(); ++i) {
+    const SceneNode &node = scene.nodes[i];
+    for (size_t c = 0; c < node.child_count; ++c) {
+      int child = scene.node_children[node.first_child + c];
+      if (child < 0 || child >= static_cast<int>(scene.nodes.size())) {
+        return SetError(error, "Node child out of range");
+      }
+      if ((*parents)[child] >= 0) {
+        return SetError(error, "Node " + std::to_string(child) +
+                                   " has more than one parent");
+      }
+      (*parents)[child] = static_cast<int>(i);
+    }
+  }
+  return true;
+}
+
+glm::mat4 GltfNodeLocalMatrix(const SceneNode &node) {
+  if (node.has_matrix) {
+    glm::mat4 matrix;
+    for (int column = 0; column < 4; ++column) {
+      for (int row = 0; row < 4; ++row) {
+        matrix[column][row] = node.matrix[column * 4 + row];
+      }
+    }
+    return matrix;
+  }
+  glm::quat rotation(node.rotation[3], node.rotation[0], node.rotation[1],
+                     node.rotation[2]);
+  glm::mat3 basis = glm::mat3_cast(glm::normalize(rotation));
+  glm::mat4 local(1.0f);
+  local[0] = glm::vec4(basis[0] * node.scale[0], 0.0f);
+  local[1] = glm::vec4(basis[1] * node.scale[1], 0.0f);
+  local[2] = glm::vec4(basis[2] * node.scale[2], 0.0f);
+  local[3] = glm::vec4(node.translation[0], node.translation[1],
+                       node.translation[2], 1.0f);
+  return local;
+}
+
+void GltfNodeTransform(const SceneNode &node,
+                       glm::vec3 *translation,
+                       glm::quat *rotation,
+                       glm::vec3 *scale) {
+  if (!node.has_matrix) {
+    *translation = glm::vec3(node.translation[0], node.translation[1],
+                             node.translation[2]);
+    *rotation = glm::normalize(glm::quat(node.rotation[3], node.rotation[0],
+                                         node.rotation[1], node.rotation[2]));
+    *scale = glm::vec3(node.scale[0], node.scale[1], node.scale[2]);
+    return;
+  }
+  glm::mat4 matrix = GltfNodeLocalMatrix(node);
+  *translation = glm::vec3(matrix[3]);
+  glm::mat3 basis;
+  for (int column = 0; column < 3; ++column) {
+    glm::vec3 axis(matrix[column]);
+    (*scale)[column] = glm::length(axis);
+    basis[column] = (*scale)[column] > 0.0f ? axis / (*scale)[column] : axis;
+  }
+  *rotation = glm::normalize(glm::quat_cast(basis));
+}
+
+int GltfMeshNode(const GltfScene &scene) {
+  for (size_t i = 0; i < scene.nodes.size(); ++i) {
+    if (scene.nodes[i].mesh == 0) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+bool AppendGltfNodes(const GltfScene &scene,
+                     int root_parent,
+                     std::vector<SceneGraphNode> *nodes,
+                     std::string *error) {
+  std::vector<int> parents;
+  if (!GltfNodeParents(scene, &parents, error)) {
+    return false;
+  }
+  int offset = static_cast<int>(nodes->size());
+  nodes->reserve(nodes->size() + scene.nodes.size());
+  for (size_t i = 0; i < scene.nodes.size(); ++i) {
+    SceneGraphNode node;
+    node.parent = parents[i] < 0 ? root_parent : parents[i] + offset;
+    GltfNodeTransform(scene.nodes[i], &node.translation, &node.rotation,
+                      &node.scale);
+    nodes->push_back(node);
+  }
+  return true;
+}
+
+}  // namespace bando
@@ -0,0 +1,46 @@
+#ifndef EXAMPLES_SDL3_HELLO_3D_GLTF_SCENE_GRAPH_H_
+#define EXAMPLES_SDL3_HELLO_3D_GLTF_SCENE_GRAPH_H_
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <string>
+#include <vector>
+
+#include "examples/scene_graph/scene_graph.h"
+#include "examples/sdl3/hello_3d/gltf_scene.h"
+
+// glTF node hierarchy helpers shared by the skin loader and the
+// //examples/scene_graph conversion.
+
+namespace bando {
+
+// Parent of every node, -1 for roots. Fails on out of range children and
+// nodes listed as the child of two nodes.
+bool GltfNodeParents(const GltfScene &scene,
+                     std::vector<int> *parents,
+                     std::string *error);
+
+glm::mat4 GltfNodeLocalMatrix(const SceneNode &node);
+
+// Local transform as TRS with a normalized rotation. Matrix nodes are
+// decomposed assuming no shear; animated nodes must use TRS anyway.
+void GltfNodeTransform(const SceneNode &node,
+                       glm::vec3 *translation,
+                       glm::quat *rotation,
+                       glm::vec3 *scale);
+
+// First node drawing the first mesh, -1 when there is none.
+int GltfMeshNode(const GltfScene &scene);
+
+// Appends every glTF node to `nodes`, so glTF node i becomes input node
+// nodes->size() + i for SceneGraph::Build. glTF roots are parented to
+// `root_parent` (-1 keeps them roots).
+bool AppendGltfNodes(const GltfScene &scene,
+                     int root_parent,
+                     std::vector<SceneGraphNode> *nodes,
+                     std::string *error);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_SDL3_HELLO_3D_GLTF_SCENE_GRAPH_H_
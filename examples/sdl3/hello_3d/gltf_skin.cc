@@ -0,0 +1,309 @@
+#include "examples/sdl3/hello_3d/gltf_skin.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include "examples/profiling/profile_zones.h"
+#include "examples/sdl3/hello_3d/gltf_mesh.h"
+#include "examples/sdl3/hello_3d/gltf_scene_graph.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bando {
+
+namespace {
+
+bool SetError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+const ScenePrimitive *FirstScenePrimitive(const GltfScene &scene) {
+  if (scene.meshes.empty() || scene.meshes[0].primitive_count == 0) {
+    return nullptr;
+  }
+  return &scene.primitives[scene.meshes[0].first_primitive];
+}
+
+// Node drawing the first mesh with a skin, -1 when there is none.
+int SkinnedMeshNode(const GltfScene &scene) {
+  for (size_t i = 0; i < scene.nodes.size(); ++i) {
+    const SceneNode &node = scene.nodes[i];
+    if (node.mesh == 0 && node.skin >= 0 &&
+        node.skin < static_cast<int>(scene.skins.size())) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+// Animated nodes must use TRS, so only static joints reach the matrix
+// decomposition.
+JointTransform NodeRestPose(const SceneNode &node) {
+  JointTransform pose;
+  GltfNodeTransform(node, &pose.translation, &pose.rotation, &pose.scale);
+  return pose;
+}
+
+glm::mat4 NodeWorldMatrix(const GltfScene &scene,
+                          const std::vector<int> &parents,
+                          int node) {
+  glm::mat4 world(1.0f);
+  // A node has at most one parent, so the walk ends within nodes.size()
+  // steps unless the hierarchy has a cycle.
+  for (size_t steps = 0; node >= 0 && steps < parents.size(); ++steps) {
+    world = GltfNodeLocalMatrix(scene.nodes[node]) * world;
+    node = parents[node];
+  }
+  return world;
+}
+
+bool BuildSkeleton(const GltfScene &scene,
+                   const SceneSkin &scene_skin,
+                   const std::vector<int> &parents,
+                   Skeleton *skeleton,
+                   std::vector<int> *node_joint,
+                   std::vector<int> *skin_to_joint,
+                   std::string *error) {
+  size_t joint_count = scene_skin.joint_count;
+  if (joint_count == 0) {
+    return SetError(error, "Skin has no joints");
+  }
+  if (joint_count > 65536) {
+    return SetError(error, "Skin has more than 65536 joints");
+  }
+  std::vector<int> joint_nodes(joint_count);
+  std::vector<size_t> depths(joint_count);
+  node_joint->assign(scene.nodes.size(), -1);
+  for (size_t j = 0; j < joint_count; ++j) {
+    int node = scene.skin_joints[scene_skin.first_joint + j];
+    if (node < 0 || node >= static_cast<int>(scene.nodes.size())) {
+      return SetError(error, "Skin joint node out of range");
+    }
+    joint_nodes[j] = node;
+    size_t depth = 0;
+    for (int p = parents[node]; p >= 0; p = parents[p]) {
+      if (++depth > scene.nodes.size()) {
+        return SetError(error, "Node hierarchy has a cycle");
+      }
+    }
+    depths[j] = depth;
+  }
+
+  // Parents before children: sorting by depth is enough.
+  std::vector<int> order(joint_count);
+  for (size_t j = 0; j < joint_count; ++j) {
+    order[j] = static_cast<int>(j);
+  }
+  std::stable_sort(order.begin(), order.end(), [&depths](int a, int b) {
+    return depths[a] < depths[b];
+  });
+  skin_to_joint->assign(joint_count, -1);
+  for (size_t i = 0; i < joint_count; ++i) {
+    (*skin_to_joint)[order[i]] = static_cast<int>(i);
+    if ((*node_joint)[joint_nodes[order[i]]] >= 0) {
+      return SetError(error, "Skin lists a joint twice");
+    }
+    (*node_joint)[joint_nodes[order[i]]] = static_cast<int>(i);
+  }
+
+  std::vector<float> inverse_bind;
+  if (scene_skin.inverse_bind_matrices >= 0) {
+    if (!ReadSceneAccessorFloats(scene, scene_skin.inverse_bind_matrices, 16,
+                                 &inverse_bind, error)) {
+      return false;
+    }
+    if (inverse_bind.size() < joint_count * 16) {
+      return SetError(error, "Skin has fewer inverse bind matrices than "
+                             "joints");
+    }
+  }
+
+  skeleton->parents.assign(joint_count, -1);
+  skeleton->rest_pose.resize(joint_count);
+  skeleton->inverse_bind.assign(joint_count, glm::mat4(1.0f));
+  skeleton->root_parents.assign(joint_count, glm::mat4(1.0f));
+  for (size_t i = 0; i < joint_count; ++i) {
+    int skin_index = order[i];
+    int node = joint_nodes[skin_index];
+    skeleton->rest_pose[i] = NodeRestPose(scene.nodes[node]);
+    if (!inverse_bind.empty()) {
+      std::memcpy(&skeleton->inverse_bind[i][0][0],
+                  inverse_bind.data() + skin_index * 16,
+                  16 * sizeof(float));
+    }
+    int parent_node = parents[node];
+    if (parent_node >= 0 && (*node_joint)[parent_node] >= 0) {
+      skeleton->parents[i] = (*node_joint)[parent_node];
+    } else if (parent_node >= 0) {
+      skeleton->root_parents[i] =
+          NodeWorldMatrix(scene, parents, parent_node);
+    }
+  }
+  return true;
+}
+
+bool BuildSkinnedVertices(const GltfScene &scene,
+                          const std::vector<int> &skin_to_joint,
+                          std::vector<SkinnedVertex> *vertices,
+                          std::string *error) {
+  GltfMeshLayout layout;
+  if (!MeasureGltfMesh(scene, &layout, error)) {
+    return false;
+  }
+  vertices->resize(layout.vertex_count);
+  SkinnedVertex *out = vertices->data();
+  float joint_limit = static_cast<float>(skin_to_joint.size());
+  return DecodeGltfSkinnedVertices(
+      scene,
+      [&](const GltfVertexChunk &chunk, std::string *chunk_error) {
+        for (size_t i = 0; i < chunk.count; ++i) {
+          SkinnedVertex &vertex = out[chunk.first + i];
+          for (int c = 0; c < 3; ++c) {
+            vertex.position[c] = chunk.positions[i][c];
+            vertex.normal[c] = chunk.normals[i][c];
+          }
+          vertex.uv[0] = chunk.uvs[i][0];
+          vertex.uv[1] = chunk.uvs[i][1];
+          float total = 0.0f;
+          for (int k = 0; k < 4; ++k) {
+            float joint = chunk.joints[i][k];
+            float weight = std::max(chunk.weights[i][k], 0.0f);
+            if (joint < 0.0f || joint >= joint_limit) {
+              return SetError(chunk_error, "Vertex joint index out of range");
+            }
+            vertex.joints[k] = static_cast<uint16_t>(
+                skin_to_joint[static_cast<size_t>(joint)]);
+            vertex.weights[k] = weight;
+            total += weight;
+          }
+          if (total > 0.0f) {
+            for (float &weight : vertex.weights) {
+              weight /= total;
+            }
+          } else {
+            vertex.weights[0] = 1.0f;
+          }
+        }
+        return true;
+      },
+      error);
+}
+
+bool BuildClip(const GltfScene &scene,
+               const SceneAnimation &animation,
+               const std::vector<int> &node_joint,
+               AnimationClip *clip,
+               std::string *error) {
+  clip->channels.clear();
+  clip->duration = 0.0f;
+  for (size_t c = 0; c < animation.channel_count; ++c) {
+    const SceneAnimationChannel &source =
+        scene.animation_channels[animation.first_channel + c];
+    AnimationChannel channel;
+    int components = 3;
+    switch (source.path) {
+      case SceneAnimationPath::kTranslation:
+        channel.path = AnimationPath::kTranslation;
+        break;
+      case SceneAnimationPath::kRotation:
+        channel.path = AnimationPath::kRotation;
+        components = 4;
+        break;
+      case SceneAnimationPath::kScale:
+        channel.path = AnimationPath::kScale;
+        break;
+      default:
+        continue;
+    }
+    if (source.node < 0 ||
+        source.node >= static_cast<int>(node_joint.size())) {
+      return SetError(error, "Animation channel node out of range");
+    }
+    channel.joint = node_joint[source.node];
+    if (channel.joint < 0) {
+      continue;
+    }
+    if (source.sampler < 0 ||
+        source.sampler >= static_cast<int>(animation.sampler_count)) {
+      return SetError(error, "Animation channel sampler out of range");
+    }
+    const SceneAnimationSampler &sampler =
+        scene.animation_samplers[animation.first_sampler + source.sampler];
+    switch (sampler.interpolation) {
+      case SceneInterpolation::kStep:
+        channel.interpolation = AnimationInterpolation::kStep;
+        break;
+      case SceneInterpolation::kCubicSpline:
+        channel.interpolation = AnimationInterpolation::kCubicSpline;
+        break;
+      default:
+        channel.interpolation = AnimationInterpolation::kLinear;
+        break;
+    }
+    if (!ReadSceneAccessorFloats(scene, sampler.input, 1, &channel.times,
+                                 error) ||
+        !ReadSceneAccessorFloats(scene, sampler.output, components,
+                                 &channel.values, error)) {
+      return false;
+    }
+    size_t values_per_key =
+        channel.interpolation == AnimationInterpolation::kCubicSpline ? 3 : 1;
+    if (channel.times.empty() ||
+        channel.values.size() !=
+            channel.times.size() * values_per_key * components) {
+      return SetError(error, "Animation sampler output does not match its "
+                             "input");
+    }
+    if (!std::is_sorted(channel.times.begin(), channel.times.end())) {
+      return SetError(error, "Animation key times are not ascending");
+    }
+    clip->duration = std::max(clip->duration, channel.times.back());
+    clip->channels.push_back(std::move(channel));
+  }
+  return true;
+}
+
+}  // namespace
+
+bool IsGltfMeshSkinned(const GltfScene &scene) {
+  const ScenePrimitive *primitive = FirstScenePrimitive(scene);
+  return primitive && primitive->joints0 >= 0 && primitive->weights0 >= 0 &&
+         SkinnedMeshNode(scene) >= 0;
+}
+
+bool BuildGltfSkin(const GltfScene &scene,
+                   GltfSkin *skin,
+                   std::string *error) {
+  BANDO_PROFILE_ZONE("BuildGltfSkin");
+  if (!skin) {
+    return false;
+  }
+  if (!IsGltfMeshSkinned(scene)) {
+    return SetError(error, "glTF first mesh is not skinned");
+  }
+  int node = SkinnedMeshNode(scene);
+  const SceneSkin &scene_skin = scene.skins[scene.nodes[node].skin];
+  std::vector<int> parents;
+  std::vector<int> node_joint;
+  std::vector<int> skin_to_joint;
+  if (!GltfNodeParents(scene, &parents, error) ||
+      !BuildSkeleton(scene, scene_skin, parents, &skin->skeleton,
+                     &node_joint, &skin_to_joint, error) ||
+      !BuildSkinnedVertices(scene, skin_to_joint, &skin->vertices, error)) {
+    return false;
+  }
+  skin->clips.resize(scene.animations.size());
+  for (size_t i = 0; i < scene.animations.size(); ++i) {
+    if (!BuildClip(scene, scene.animations[i], node_joint, &skin->clips[i],
+                   error)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace bando
@@ -0,0 +1,37 @@
+#ifndef EXAMPLES_SDL3_HELLO_3D_GLTF_SKIN_H_
+#define EXAMPLES_SDL3_HELLO_3D_GLTF_SKIN_H_
+
+#include <string>
+#include <vector>
+
+#include "examples/animation/animation.h"
+#include "examples/animation/skinning.h"
+#include "examples/sdl3/hello_3d/gltf_scene.h"
+
+// Converts the skin and animations driving the first mesh of a GltfScene
+// into //examples/animation data for CPU skinning.
+
+namespace bando {
+
+struct GltfSkin {
+  Skeleton skeleton;
+  // Bind pose of the first primitive, in the same order as the vertices
+  // BuildGltfMesh / DecodeGltfMeshInto produce.
+  std::vector<SkinnedVertex> vertices;
+  // One clip per glTF animation; channels that do not target a joint of
+  // the skin, and morph target weights, are dropped.
+  std::vector<AnimationClip> clips;
+};
+
+// True when the first primitive has JOINTS_0/WEIGHTS_0 and a node draws the
+// first mesh with a skin.
+bool IsGltfMeshSkinned(const GltfScene &scene);
+
+// Joints are reordered so parents precede children. A joint whose parent
+// node is not a joint becomes a root carrying that node's rest world
+// transform. Weights are renormalized to sum to 1.
+bool BuildGltfSkin(const GltfScene &scene, GltfSkin *skin, std::string *error);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_SDL3_HELLO_3D_GLTF_SKIN_H_
@@ -3,17 +3,33 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-
-#include <nlohmann/json.hpp>
-#include <tiny_gltf.h>
+#include <glm/gtc/quaternion.hpp>
+
+#include "examples/animation/skinning.h"
+#include "examples/bench/random.h"
+#include "examples/culling/occlusion_buffer.h"
+#include "examples/jobs/worker_pool.h"
+#include "examples/lighting/light_clusters.h"
+#include "examples/profiling/profile_zones.h"
+#include "examples/scene_graph/scene_graph.h"
+#include "examples/sdl3/hello_3d/gltf_mesh.h"
+#include "examples/sdl3/hello_3d/gltf_scene_graph.h"
+#include "examples/sdl3/hello_3d/gltf_skin.h"
+#include "examples/spdlog/async_log.h"
+#include "examples/textures/texture_cache.h"
+#include "examples/textures/texture_upload.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <future>
 #include <limits>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -25,23 +41,23 @@ constexpr const char *kVertexShaderPath =
     "examples/sdl3/hello_3d/shaders/hello_3d.vert.spv";
 constexpr const char *kFragmentShaderPath =
     "examples/sdl3/hello_3d/shaders/hello_3d.frag.spv";
+// CPU occlusion buffer size and occluder budget; both only need to be large
+// enough to hide objects behind big surfaces.
+constexpr int kOcclusionWidth = 256;
+constexpr int kOcclusionHeight = 144;
+constexpr size_t kMaxOccluderTriangles = 512;
+// Point and spot lights orbiting the model, binned into froxel light lists
+// on the worker pool every frame.
+constexpr size_t kDemoLightCount = 2048;
+constexpr float kNearPlane = 0.1f;
 
 struct Options {
   std::string model_path = kDefaultModelPath;
+  std::string log_binary_path;
+  std::string trace_path;
+  std::string texture_cache_dir;
   double timeout_seconds = 0.0;
-};
-
-struct Vertex {
-  glm::vec3 position;
-  glm::vec3 normal;
-};
-
-struct GltfMesh {
-  std::vector<Vertex> vertices;
-  std::vector<uint32_t> indices;
-  glm::vec3 center = glm::vec3(0.0f);
-  float radius = 1.0f;
-  glm::vec4 base_color = glm::vec4(1.0f);
+  bool occlusion = false;
 };
 
 struct alignas(16) VertexUniforms {
@@ -52,8 +68,64 @@ struct alignas(16) VertexUniforms {
 struct alignas(16) FragmentUniforms {
   glm::vec4 light_dir;
   glm::vec4 base_color;
+  // Tiles per pixel in x and y, depth slice scale and bias.
+  glm::vec4 cluster_scale;
+  // Tiles in x and y, depth slices, nonzero once light lists are uploaded.
+  glm::uvec4 cluster_dims;
+};
+
+// Turntable node -> fit node -> the glTF node hierarchy. The turntable
+// spins the model every frame; the fit node scales and centers the mesh's
+// rest world bounds into a unit sphere, so assets whose nodes place the
+// mesh away from the origin are still framed.
+struct ModelGraph {
+  bando::SceneGraph graph;
+  uint32_t turntable = 0;
+  uint32_t draw_node = 0;
 };
 
+// Skinned meshes ignore their node's transform (the skeleton places them),
+// so they are drawn with the fit node's matrix.
+void BuildModelGraph(const bando::GltfScene &scene,
+                     const bando::GltfMesh &mesh,
+                     bool skinned,
+                     ModelGraph *model) {
+  std::vector<bando::SceneGraphNode> nodes(2);
+  nodes[1].parent = 0;
+  int mesh_node = skinned ? -1 : bando::GltfMeshNode(scene);
+  std::string error;
+  if (!bando::AppendGltfNodes(scene, 1, &nodes, &error)) {
+    SDL_Log("Ignoring glTF nodes: %s", error.c_str());
+    nodes.resize(2);
+    mesh_node = -1;
+  }
+  std::vector<uint32_t> node_index;
+  if (!model->graph.Build(nodes, &node_index, &error)) {
+    SDL_Log("Ignoring glTF nodes: %s", error.c_str());
+    nodes.resize(2);
+    mesh_node = -1;
+    model->graph.Build(nodes, &node_index, nullptr);
+  }
+  model->turntable = node_index[0];
+  uint32_t fit = node_index[1];
+  model->draw_node = mesh_node >= 0 ? node_index[2 + mesh_node] : fit;
+
+  // With the turntable and fit nodes still at identity this is the mesh's
+  // placement in the scene.
+  model->graph.Update(nullptr);
+  const glm::mat4 &placement = model->graph.world(model->draw_node);
+  glm::vec3 center = glm::vec3(placement * glm::vec4(mesh.center, 1.0f));
+  float placement_scale = std::max(
+      {glm::length(glm::vec3(placement[0])),
+       glm::length(glm::vec3(placement[1])),
+       glm::length(glm::vec3(placement[2]))});
+  float radius = mesh.radius * placement_scale;
+  float fit_scale = radius > 0.0f ? 1.0f / radius : 1.0f;
+  model->graph.SetLocal(fit, -center * fit_scale,
+                        glm::quat(1.0f, 0.0f, 0.0f, 0.0f),
+                        glm::vec3(fit_scale));
+}
+
 bool StartsWith(const std::string &value, const std::string &prefix) {
   return value.rfind(prefix, 0) == 0;
 }
@@ -72,7 +144,10 @@ bool ParseDouble(const std::string &value, double *out) {
 }
 
 void PrintUsage(const char *argv0) {
-  SDL_Log("Usage: %s [--model=PATH] [--timeout=SECONDS]", argv0);
+  SDL_Log("Usage: %s [--model=PATH] [--timeout=SECONDS] [--log-binary=PATH] "
+          "[--trace=PATH] [--texture-cache=DIR] [--occlusion]",
+          argv0);
+  SDL_Log("Press F9 to write the profiling trace while running.");
 }
 
 Options ParseOptions(int argc, char **argv) {
@@ -109,6 +184,34 @@ Options ParseOptions(int argc, char **argv) {
       options.model_path = argv[++i];
       continue;
     }
+    if (StartsWith(arg, "--log-binary=")) {
+      options.log_binary_path = arg.substr(std::strlen("--log-binary="));
+      continue;
+    }
+    if (arg == "--log-binary" && i + 1 < argc) {
+      options.log_binary_path = argv[++i];
+      continue;
+    }
+    if (StartsWith(arg, "--trace=")) {
+      options.trace_path = arg.substr(std::strlen("--trace="));
+      continue;
+    }
+    if (arg == "--trace" && i + 1 < argc) {
+      options.trace_path = argv[++i];
+      continue;
+    }
+    if (StartsWith(arg, "--texture-cache=")) {
+      options.texture_cache_dir = arg.substr(std::strlen("--texture-cache="));
+      continue;
+    }
+    if (arg == "--texture-cache" && i + 1 < argc) {
+      options.texture_cache_dir = argv[++i];
+      continue;
+    }
+    if (arg == "--occlusion") {
+      options.occlusion = true;
+      continue;
+    }
     SDL_Log("Unknown argument: %s", arg.c_str());
   }
   return options;
@@ -187,6 +290,7 @@ std::string ResolveRunfile(const std::string &relative, const char *argv0) {
 }
 
 std::vector<uint8_t> LoadBinaryFile(const std::string &path) {
+  BANDO_PROFILE_ZONE("LoadBinaryFile");
   std::ifstream file(path, std::ios::binary | std::ios::ate);
   if (!file) {
     return {};
@@ -201,268 +305,258 @@ std::vector<uint8_t> LoadBinaryFile(const std::string &path) {
   return data;
 }
 
-bool ReadAccessorVec3(const tinygltf::Model &model,
-                      int accessor_index,
-                      std::vector<glm::vec3> *out,
-                      std::string *error) {
-  if (!out) {
-    return false;
-  }
-  if (accessor_index < 0 || accessor_index >=
-                                static_cast<int>(model.accessors.size())) {
-    if (error) {
-      *error = "Missing accessor";
-    }
-    return false;
-  }
-  const tinygltf::Accessor &accessor = model.accessors[accessor_index];
-  if (accessor.type != TINYGLTF_TYPE_VEC3 ||
-      accessor.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT) {
-    if (error) {
-      *error = "Expected VEC3 float accessor";
-    }
-    return false;
-  }
-  const tinygltf::BufferView &view = model.bufferViews[accessor.bufferView];
-  const tinygltf::Buffer &buffer = model.buffers[view.buffer];
-  size_t stride = view.byteStride ? view.byteStride : sizeof(float) * 3u;
-  const unsigned char *data = buffer.data.data() + view.byteOffset +
-                              accessor.byteOffset;
-  out->resize(accessor.count);
-  for (size_t i = 0; i < accessor.count; ++i) {
-    const float *src =
-        reinterpret_cast<const float *>(data + i * stride);
-    (*out)[i] = glm::vec3(src[0], src[1], src[2]);
+// Per-user cache directory used when --texture-cache is not given.
+std::string DefaultTextureCacheDir() {
+  char *pref_path = SDL_GetPrefPath(kWorkspaceName, "hello_3d");
+  if (!pref_path) {
+    return std::string();
   }
-  return true;
+  std::string cache_dir = std::string(pref_path) + "texture_cache";
+  SDL_free(pref_path);
+  return cache_dir;
 }
 
-bool ReadIndexAccessor(const tinygltf::Model &model,
-                       int accessor_index,
-                       std::vector<uint32_t> *out,
-                       std::string *error) {
-  if (!out) {
-    return false;
-  }
-  if (accessor_index < 0 || accessor_index >=
-                                static_cast<int>(model.accessors.size())) {
-    if (error) {
-      *error = "Missing index accessor";
+// Bound in place of a base color texture so one pipeline covers both cases.
+bando::Texture WhiteTexture() {
+  bando::Texture texture;
+  texture.format = bando::TextureFormat::kRgba8;
+  texture.levels.resize(1);
+  texture.levels[0].width = 1;
+  texture.levels[0].height = 1;
+  texture.levels[0].data = {255, 255, 255, 255};
+  return texture;
+}
+
+// One job per (image, usage) the mesh's material references, base color
+// first so its texture is the one the fragment shader samples. An image
+// shared by two slots of the same usage, like a packed occlusion /
+// metallic-roughness map, is only prepared once.
+std::vector<bando::TextureJob> MaterialTextureJobs(
+    const bando::GltfMesh &mesh) {
+  const std::pair<int, bando::TextureUsage> slots[] = {
+      {mesh.base_color_image, bando::TextureUsage::kColorSrgb},
+      {mesh.normal_image, bando::TextureUsage::kNormal},
+      {mesh.metallic_roughness_image, bando::TextureUsage::kColorLinear},
+      {mesh.occlusion_image, bando::TextureUsage::kColorLinear},
+      {mesh.emissive_image, bando::TextureUsage::kColorSrgb},
+  };
+  std::vector<bando::TextureJob> jobs;
+  for (const auto &[image, usage] : slots) {
+    if (image < 0) {
+      continue;
     }
-    return false;
-  }
-  const tinygltf::Accessor &accessor = model.accessors[accessor_index];
-  if (accessor.type != TINYGLTF_TYPE_SCALAR) {
-    if (error) {
-      *error = "Expected scalar index accessor";
+    const std::vector<uint8_t> *encoded = &mesh.encoded_images[image];
+    bool queued = std::any_of(
+        jobs.begin(), jobs.end(), [&](const bando::TextureJob &job) {
+          return job.encoded == encoded && job.usage == usage;
+        });
+    if (!queued) {
+      jobs.push_back({encoded, usage});
     }
-    return false;
   }
-  const tinygltf::BufferView &view = model.bufferViews[accessor.bufferView];
-  const tinygltf::Buffer &buffer = model.buffers[view.buffer];
-  size_t component_size = 0;
-  switch (accessor.componentType) {
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-      component_size = sizeof(uint8_t);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-      component_size = sizeof(uint16_t);
-      break;
-    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-      component_size = sizeof(uint32_t);
-      break;
-    default:
-      if (error) {
-        *error = "Unsupported index component type";
-      }
-      return false;
-  }
-  size_t stride = view.byteStride ? view.byteStride : component_size;
-  const unsigned char *data = buffer.data.data() + view.byteOffset +
-                              accessor.byteOffset;
-  out->resize(accessor.count);
-  for (size_t i = 0; i < accessor.count; ++i) {
-    const unsigned char *element = data + i * stride;
-    switch (accessor.componentType) {
-      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-        (*out)[i] = *reinterpret_cast<const uint8_t *>(element);
-        break;
-      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-        (*out)[i] = *reinterpret_cast<const uint16_t *>(element);
-        break;
-      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-        (*out)[i] = *reinterpret_cast<const uint32_t *>(element);
-        break;
-      default:
-        break;
-    }
-  }
-  return true;
+  return jobs;
 }
 
-glm::vec4 ExtractBaseColor(const tinygltf::Model &model,
-                           const tinygltf::Primitive &primitive) {
-  if (primitive.material < 0 ||
-      primitive.material >= static_cast<int>(model.materials.size())) {
-    return glm::vec4(1.0f);
-  }
-  const tinygltf::Material &material = model.materials[primitive.material];
-  const std::vector<double> &base_color =
-      material.pbrMetallicRoughness.baseColorFactor;
-  if (base_color.size() == 4) {
-    return glm::vec4(static_cast<float>(base_color[0]),
-                     static_cast<float>(base_color[1]),
-                     static_cast<float>(base_color[2]),
-                     static_cast<float>(base_color[3]));
-  }
-  return glm::vec4(1.0f);
+SDL_GPUTexture *CreateDepthTexture(SDL_GPUDevice *device,
+                                   Uint32 width,
+                                   Uint32 height) {
+  SDL_GPUTextureCreateInfo depth_info = {};
+  depth_info.type = SDL_GPU_TEXTURETYPE_2D;
+  depth_info.format = SDL_GPU_TEXTUREFORMAT_D16_UNORM;
+  depth_info.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+  depth_info.width = width;
+  depth_info.height = height;
+  depth_info.layer_count_or_depth = 1;
+  depth_info.num_levels = 1;
+  depth_info.sample_count = SDL_GPU_SAMPLECOUNT_1;
+  return SDL_CreateGPUTexture(device, &depth_info);
 }
 
-void ComputeBounds(const std::vector<Vertex> &vertices,
-                   glm::vec3 *center,
-                   float *radius) {
-  if (!center || !radius || vertices.empty()) {
-    return;
-  }
-  glm::vec3 min_pos(std::numeric_limits<float>::max());
-  glm::vec3 max_pos(std::numeric_limits<float>::lowest());
-  for (const Vertex &vertex : vertices) {
-    min_pos = glm::min(min_pos, vertex.position);
-    max_pos = glm::max(max_pos, vertex.position);
-  }
-  *center = (min_pos + max_pos) * 0.5f;
-  *radius = glm::length(max_pos - min_pos) * 0.5f;
-  if (*radius <= 0.0f) {
-    *radius = 1.0f;
+// Orbit of one demo light around the fitted model's unit sphere.
+struct DemoLight {
+  float orbit_radius = 1.0f;
+  float height = 0.0f;
+  float speed = 1.0f;
+  float phase = 0.0f;
+};
+
+// Every fourth light is a spot light aimed at the model.
+void MakeDemoLights(size_t count,
+                    std::vector<DemoLight> *orbits,
+                    std::vector<bando::Light> *lights) {
+  orbits->resize(count);
+  lights->resize(count);
+  uint32_t state = 1u;
+  for (size_t i = 0; i < count; ++i) {
+    DemoLight &orbit = (*orbits)[i];
+    orbit.orbit_radius = 0.6f + 0.8f * bando::NextUnit(&state);
+    orbit.height = bando::NextSigned(&state);
+    orbit.speed = (0.2f + 0.6f * bando::NextUnit(&state)) *
+                  (bando::NextUnit(&state) < 0.5f ? -1.0f : 1.0f);
+    orbit.phase = 6.2831853f * bando::NextUnit(&state);
+    bando::Light &light = (*lights)[i];
+    float hue = bando::NextUnit(&state);
+    light.color = glm::vec3(0.5f) +
+                  0.5f * glm::vec3(std::cos(6.2831853f * hue),
+                                   std::cos(6.2831853f * (hue + 0.33f)),
+                                   std::cos(6.2831853f * (hue + 0.67f)));
+    light.range = 0.2f + 0.25f * bando::NextUnit(&state);
+    light.intensity = 0.1f;
+    if (i % 4 == 3) {
+      light.type = bando::LightType::kSpot;
+      light.range *= 2.0f;
+      light.inner_cone_cos = 0.95f;
+      light.outer_cone_cos = 0.85f;
+    }
   }
 }
 
-void ComputeNormalsFromIndices(std::vector<Vertex> *vertices,
-                               const std::vector<uint32_t> &indices) {
-  if (!vertices || indices.size() < 3) {
-    return;
-  }
-  for (Vertex &vertex : *vertices) {
-    vertex.normal = glm::vec3(0.0f);
-  }
-  for (size_t i = 0; i + 2 < indices.size(); i += 3) {
-    uint32_t i0 = indices[i];
-    uint32_t i1 = indices[i + 1];
-    uint32_t i2 = indices[i + 2];
-    if (i0 >= vertices->size() || i1 >= vertices->size() ||
-        i2 >= vertices->size()) {
-      continue;
-    }
-    const glm::vec3 &p0 = (*vertices)[i0].position;
-    const glm::vec3 &p1 = (*vertices)[i1].position;
-    const glm::vec3 &p2 = (*vertices)[i2].position;
-    glm::vec3 normal = glm::normalize(glm::cross(p1 - p0, p2 - p0));
-    (*vertices)[i0].normal += normal;
-    (*vertices)[i1].normal += normal;
-    (*vertices)[i2].normal += normal;
-  }
-  for (Vertex &vertex : *vertices) {
-    if (glm::length(vertex.normal) > 0.0f) {
-      vertex.normal = glm::normalize(vertex.normal);
-    } else {
-      vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+void AnimateDemoLights(const std::vector<DemoLight> &orbits,
+                       float seconds,
+                       std::vector<bando::Light> *lights) {
+  for (size_t i = 0; i < orbits.size(); ++i) {
+    const DemoLight &orbit = orbits[i];
+    bando::Light &light = (*lights)[i];
+    float angle = orbit.phase + orbit.speed * seconds;
+    light.position =
+        glm::vec3(orbit.orbit_radius * std::cos(angle), orbit.height,
+                  orbit.orbit_radius * std::sin(angle));
+    if (light.type == bando::LightType::kSpot) {
+      light.direction = glm::normalize(-light.position);
     }
   }
 }
 
-bool LoadGltfMesh(const std::string &path, GltfMesh *mesh) {
-  if (!mesh) {
-    return false;
-  }
-  tinygltf::TinyGLTF loader;
-  tinygltf::Model model;
-  std::string error;
-  std::string warning;
-  bool ok = false;
-  if (path.size() >= 4 && path.substr(path.size() - 4) == ".glb") {
-    ok = loader.LoadBinaryFromFile(&model, &error, &warning, path);
-  } else {
-    ok = loader.LoadASCIIFromFile(&model, &error, &warning, path);
-  }
-  if (!warning.empty()) {
-    SDL_Log("tinygltf warning: %s", warning.c_str());
-  }
-  if (!ok) {
-    SDL_Log("Failed to load glTF: %s", error.c_str());
+// Storage buffers read by hello_3d.frag, sized for the grid's worst case,
+// and the transfer buffer they are refilled from every frame.
+struct LightBuffers {
+  SDL_GPUBuffer *lights = nullptr;
+  SDL_GPUBuffer *clusters = nullptr;
+  SDL_GPUBuffer *indices = nullptr;
+  SDL_GPUTransferBuffer *transfer = nullptr;
+  Uint32 light_bytes = 0;
+  Uint32 cluster_bytes = 0;
+  Uint32 index_bytes = 0;
+};
+
+SDL_GPUBuffer *CreateStorageBuffer(SDL_GPUDevice *device, Uint32 size) {
+  SDL_GPUBufferCreateInfo buffer_info = {};
+  buffer_info.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+  buffer_info.size = size;
+  return SDL_CreateGPUBuffer(device, &buffer_info);
+}
+
+void ReleaseLightBuffers(SDL_GPUDevice *device, LightBuffers *buffers) {
+  SDL_ReleaseGPUTransferBuffer(device, buffers->transfer);
+  SDL_ReleaseGPUBuffer(device, buffers->indices);
+  SDL_ReleaseGPUBuffer(device, buffers->clusters);
+  SDL_ReleaseGPUBuffer(device, buffers->lights);
+  *buffers = LightBuffers();
+}
+
+bool CreateLightBuffers(SDL_GPUDevice *device,
+                        const bando::ClusterGridDesc &desc,
+                        size_t light_count,
+                        LightBuffers *buffers) {
+  size_t cluster_count =
+      static_cast<size_t>(desc.tiles_x) * desc.tiles_y * desc.slices;
+  buffers->light_bytes = static_cast<Uint32>(
+      std::max<size_t>(light_count, 1) * sizeof(bando::GpuLight));
+  buffers->cluster_bytes =
+      static_cast<Uint32>(cluster_count * sizeof(bando::ClusterRange));
+  buffers->index_bytes = static_cast<Uint32>(
+      cluster_count * std::max<uint32_t>(desc.max_lights_per_cluster, 1) *
+      sizeof(uint32_t));
+  buffers->lights = CreateStorageBuffer(device, buffers->light_bytes);
+  buffers->clusters = CreateStorageBuffer(device, buffers->cluster_bytes);
+  buffers->indices = CreateStorageBuffer(device, buffers->index_bytes);
+  SDL_GPUTransferBufferCreateInfo transfer_info = {};
+  transfer_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+  transfer_info.size =
+      buffers->light_bytes + buffers->cluster_bytes + buffers->index_bytes;
+  buffers->transfer = SDL_CreateGPUTransferBuffer(device, &transfer_info);
+  if (!buffers->lights || !buffers->clusters || !buffers->indices ||
+      !buffers->transfer) {
+    ReleaseLightBuffers(device, buffers);
     return false;
   }
-  if (model.meshes.empty() || model.meshes[0].primitives.empty()) {
-    SDL_Log("glTF has no meshes to draw");
+  return true;
+}
+
+// Copies this frame's light lists into the storage buffers. Cycling keeps
+// the previous frame's copies intact while its draws may still read them.
+bool UploadLightClusters(SDL_GPUDevice *device,
+                         SDL_GPUCommandBuffer *command_buffer,
+                         const bando::LightClusters &clusters,
+                         const LightBuffers &buffers) {
+  Uint32 light_bytes = static_cast<Uint32>(clusters.gpu_lights().size() *
+                                           sizeof(bando::GpuLight));
+  Uint32 cluster_bytes = static_cast<Uint32>(clusters.clusters().size() *
+                                             sizeof(bando::ClusterRange));
+  Uint32 index_bytes = static_cast<Uint32>(clusters.light_indices().size() *
+                                           sizeof(uint32_t));
+  if (light_bytes > buffers.light_bytes ||
+      cluster_bytes > buffers.cluster_bytes ||
+      index_bytes > buffers.index_bytes) {
     return false;
   }
-  const tinygltf::Primitive &primitive = model.meshes[0].primitives[0];
-  auto position_it = primitive.attributes.find("POSITION");
-  if (position_it == primitive.attributes.end()) {
-    SDL_Log("glTF mesh missing POSITION attribute");
+  auto *memory = static_cast<uint8_t *>(
+      SDL_MapGPUTransferBuffer(device, buffers.transfer, true));
+  if (!memory) {
     return false;
   }
-  auto normal_it = primitive.attributes.find("NORMAL");
-  std::vector<glm::vec3> positions;
-  std::vector<glm::vec3> normals;
-  std::string accessor_error;
-  if (!ReadAccessorVec3(model, position_it->second, &positions,
-                        &accessor_error)) {
-    SDL_Log("%s", accessor_error.c_str());
-    return false;
+  Uint32 cluster_offset = buffers.light_bytes;
+  Uint32 index_offset = buffers.light_bytes + buffers.cluster_bytes;
+  if (light_bytes > 0) {
+    std::memcpy(memory, clusters.gpu_lights().data(), light_bytes);
   }
-  if (normal_it != primitive.attributes.end()) {
-    if (!ReadAccessorVec3(model, normal_it->second, &normals,
-                          &accessor_error)) {
-      SDL_Log("%s", accessor_error.c_str());
-      return false;
-    }
+  std::memcpy(memory + cluster_offset, clusters.clusters().data(),
+              cluster_bytes);
+  if (index_bytes > 0) {
+    std::memcpy(memory + index_offset, clusters.light_indices().data(),
+                index_bytes);
   }
-  mesh->vertices.resize(positions.size());
-  for (size_t i = 0; i < positions.size(); ++i) {
-    mesh->vertices[i].position = positions[i];
-    if (i < normals.size()) {
-      mesh->vertices[i].normal = normals[i];
-    }
-  }
-  if (primitive.indices >= 0) {
-    if (!ReadIndexAccessor(model, primitive.indices, &mesh->indices,
-                           &accessor_error)) {
-      SDL_Log("%s", accessor_error.c_str());
-      return false;
-    }
-  } else {
-    mesh->indices.resize(mesh->vertices.size());
-    for (size_t i = 0; i < mesh->indices.size(); ++i) {
-      mesh->indices[i] = static_cast<uint32_t>(i);
-    }
+  SDL_UnmapGPUTransferBuffer(device, buffers.transfer);
+
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  if (light_bytes > 0) {
+    SDL_GPUTransferBufferLocation source = {buffers.transfer, 0};
+    SDL_GPUBufferRegion destination = {buffers.lights, 0, light_bytes};
+    SDL_UploadToGPUBuffer(copy_pass, &source, &destination, true);
   }
-  if (normals.empty()) {
-    ComputeNormalsFromIndices(&mesh->vertices, mesh->indices);
+  SDL_GPUTransferBufferLocation cluster_source = {buffers.transfer,
+                                                  cluster_offset};
+  SDL_GPUBufferRegion cluster_destination = {buffers.clusters, 0,
+                                             cluster_bytes};
+  SDL_UploadToGPUBuffer(copy_pass, &cluster_source, &cluster_destination,
+                        true);
+  if (index_bytes > 0) {
+    SDL_GPUTransferBufferLocation index_source = {buffers.transfer,
+                                                  index_offset};
+    SDL_GPUBufferRegion index_destination = {buffers.indices, 0,
+                                             index_bytes};
+    SDL_UploadToGPUBuffer(copy_pass, &index_source, &index_destination,
+                          true);
   }
-  mesh->base_color = ExtractBaseColor(model, primitive);
-  ComputeBounds(mesh->vertices, &mesh->center, &mesh->radius);
+  SDL_EndGPUCopyPass(copy_pass);
   return true;
 }
 
-SDL_GPUTexture *CreateDepthTexture(SDL_GPUDevice *device,
-                                   Uint32 width,
-                                   Uint32 height) {
-  SDL_GPUTextureCreateInfo depth_info = {};
-  depth_info.type = SDL_GPU_TEXTURETYPE_2D;
-  depth_info.format = SDL_GPU_TEXTUREFORMAT_D16_UNORM;
-  depth_info.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
-  depth_info.width = width;
-  depth_info.height = height;
-  depth_info.layer_count_or_depth = 1;
-  depth_info.num_levels = 1;
-  depth_info.sample_count = SDL_GPU_SAMPLECOUNT_1;
-  return SDL_CreateGPUTexture(device, &depth_info);
-}
-
 }  // namespace
 
 int main(int argc, char **argv) {
   Options options = ParseOptions(argc, argv);
+  BANDO_PROFILE_THREAD_NAME("main");
+  // The frame loop logs through the async backend so a failing swapchain
+  // cannot stall frames on console I/O.
+  bando::AsyncLogOptions log_options;
+  log_options.binary_path = options.log_binary_path;
+  std::string log_error;
+  bando::ScopedAsyncLog async_log(log_options, &log_error);
+  if (!async_log.started()) {
+    SDL_Log("Async logging unavailable: %s", log_error.c_str());
+  }
+
   if (SDL_Init(SDL_INIT_VIDEO) != 0) {
     SDL_Log("SDL_Init failed: %s", SDL_GetError());
     return 1;
@@ -482,12 +576,68 @@ int main(int argc, char **argv) {
   const std::string fragment_shader_path =
       ResolveRunfile(kFragmentShaderPath, argv[0]);
 
-  GltfMesh mesh;
-  if (!LoadGltfMesh(model_path, &mesh)) {
+  // Geometry is only measured here; it is decoded straight into the mapped
+  // transfer buffer once the GPU buffers exist, and the scene (which holds
+  // the file contents) is released right after.
+  auto scene = std::make_unique<bando::GltfScene>();
+  bando::GltfMesh mesh;
+  bando::GltfMeshLayout mesh_layout;
+  std::string mesh_error;
+  bool mesh_loaded =
+      bando::LoadGltfScene(model_path, scene.get(), &mesh_error) &&
+      bando::MeasureGltfMesh(*scene, &mesh_layout, &mesh_error) &&
+      bando::ReadGltfMeshMaterial(*scene, &mesh, &mesh_error);
+  std::string mesh_warning = bando::GltfSceneWarnings(*scene);
+  if (!mesh_warning.empty()) {
+    SDL_Log("glTF warning: %s", mesh_warning.c_str());
+  }
+  if (!mesh_loaded) {
+    SDL_Log("%s", mesh_error.c_str());
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 1;
+  }
+  // GPU and transfer buffer sizes are Uint32, and the vertices and indices
+  // share one transfer buffer; meshes that do not fit are rejected before
+  // any buffer is created.
+  constexpr uint64_t kMaxBufferBytes = std::numeric_limits<Uint32>::max();
+  if (mesh_layout.vertex_count > kMaxBufferBytes / sizeof(bando::Vertex) ||
+      mesh_layout.index_count > kMaxBufferBytes / sizeof(uint32_t) ||
+      mesh_layout.vertex_count * sizeof(bando::Vertex) >
+          kMaxBufferBytes - mesh_layout.index_count * sizeof(uint32_t)) {
+    SDL_Log("Mesh with %zu vertices and %zu indices exceeds the GPU buffer "
+            "size limit",
+            mesh_layout.vertex_count, mesh_layout.index_count);
     SDL_DestroyWindow(window);
     SDL_Quit();
     return 1;
   }
+  const Uint32 vertex_bytes =
+      static_cast<Uint32>(mesh_layout.vertex_count * sizeof(bando::Vertex));
+  const Uint32 index_bytes =
+      static_cast<Uint32>(mesh_layout.index_count * sizeof(uint32_t));
+
+  // Skinned assets are animated on the CPU: every frame the worker pool
+  // samples the first clip, builds the joint palette and skins the vertices
+  // into the transfer buffer, which is then re-uploaded to the vertex buffer.
+  // A skin that fails to load leaves the mesh static in its bind pose.
+  bando::GltfSkin skin;
+  bando::WorkerPool worker_pool;
+  bando::SkinnedCrowd crowd(&worker_pool);
+  if (bando::IsGltfMeshSkinned(*scene)) {
+    std::string skin_error;
+    if (!bando::BuildGltfSkin(*scene, &skin, &skin_error)) {
+      SDL_Log("Skinning disabled: %s", skin_error.c_str());
+    } else if (skin.vertices.size() != mesh_layout.vertex_count) {
+      SDL_Log("Skinning disabled: skinned vertex count mismatch");
+    } else {
+      crowd.AddCharacter(&skin.skeleton, &skin.vertices,
+                         skin.clips.empty() ? nullptr : &skin.clips[0], 0.0f);
+      SDL_Log("CPU skinning %zu vertices with %zu joints (%s, %zu threads)",
+              skin.vertices.size(), skin.skeleton.joint_count(),
+              bando::SkinningIsa(), worker_pool.thread_count());
+    }
+  }
 
   if (!SDL_GPUSupportsShaderFormats(SDL_GPU_SHADERFORMAT_SPIRV, nullptr)) {
     SDL_Log("SDL GPU does not report SPIR-V support");
@@ -510,6 +660,33 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  // Every texture the material references is read from the cache or
+  // decoded, mipped and compressed, in parallel on worker threads, while
+  // shaders, pipeline and buffers are set up here.
+  const std::vector<bando::TextureJob> texture_jobs = MaterialTextureJobs(mesh);
+  std::vector<bando::Texture> textures;
+  std::string texture_error;
+  std::future<bool> textures_ready;
+  if (!texture_jobs.empty()) {
+    bando::TextureCacheOptions texture_options;
+    texture_options.cache_dir = options.texture_cache_dir.empty()
+                                    ? DefaultTextureCacheDir()
+                                    : options.texture_cache_dir;
+    texture_options.compress = bando::SupportsBlockCompression(device);
+    textures_ready = std::async(
+        std::launch::async, [&texture_jobs, &textures, &texture_error,
+                             texture_options]() {
+          bando::TextureCacheStats stats;
+          bool ok = bando::PrepareTextures(texture_jobs, texture_options,
+                                           &textures, &stats, &texture_error);
+          BANDO_LOG_INFO("{} material textures ready in {:.1f} ms ({} cached, "
+                         "{} encoded, {} failed)",
+                         texture_jobs.size(), stats.wall_ms, stats.hits,
+                         stats.misses, stats.failures);
+          return ok;
+        });
+  }
+
   std::vector<uint8_t> vertex_shader_code = LoadBinaryFile(vertex_shader_path);
   std::vector<uint8_t> fragment_shader_code =
       LoadBinaryFile(fragment_shader_path);
@@ -529,8 +706,11 @@ int main(int argc, char **argv) {
   vertex_shader_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
   vertex_shader_info.stage = SDL_GPU_SHADERSTAGE_VERTEX;
   vertex_shader_info.num_uniform_buffers = 1;
-  SDL_GPUShader *vertex_shader =
-      SDL_CreateGPUShader(device, &vertex_shader_info);
+  SDL_GPUShader *vertex_shader = nullptr;
+  {
+    BANDO_PROFILE_ZONE("CreateVertexShader");
+    vertex_shader = SDL_CreateGPUShader(device, &vertex_shader_info);
+  }
   if (!vertex_shader) {
     SDL_Log("SDL_CreateGPUShader vertex failed: %s", SDL_GetError());
     SDL_ReleaseWindowFromGPUDevice(device, window);
@@ -546,9 +726,14 @@ int main(int argc, char **argv) {
   fragment_shader_info.entrypoint = "main";
   fragment_shader_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
   fragment_shader_info.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
+  fragment_shader_info.num_samplers = 1;
+  fragment_shader_info.num_storage_buffers = 3;
   fragment_shader_info.num_uniform_buffers = 1;
-  SDL_GPUShader *fragment_shader =
-      SDL_CreateGPUShader(device, &fragment_shader_info);
+  SDL_GPUShader *fragment_shader = nullptr;
+  {
+    BANDO_PROFILE_ZONE("CreateFragmentShader");
+    fragment_shader = SDL_CreateGPUShader(device, &fragment_shader_info);
+  }
   if (!fragment_shader) {
     SDL_Log("SDL_CreateGPUShader fragment failed: %s", SDL_GetError());
     SDL_ReleaseGPUShader(device, vertex_shader);
@@ -561,26 +746,30 @@ int main(int argc, char **argv) {
 
   SDL_GPUVertexBufferDescription vertex_buffer_description = {};
   vertex_buffer_description.slot = 0;
-  vertex_buffer_description.pitch = sizeof(Vertex);
+  vertex_buffer_description.pitch = sizeof(bando::Vertex);
   vertex_buffer_description.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
   vertex_buffer_description.instance_step_rate = 0;
 
-  SDL_GPUVertexAttribute vertex_attributes[2] = {};
+  SDL_GPUVertexAttribute vertex_attributes[3] = {};
   vertex_attributes[0].location = 0;
   vertex_attributes[0].buffer_slot = 0;
   vertex_attributes[0].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3;
-  vertex_attributes[0].offset = offsetof(Vertex, position);
+  vertex_attributes[0].offset = offsetof(bando::Vertex, position);
   vertex_attributes[1].location = 1;
   vertex_attributes[1].buffer_slot = 0;
   vertex_attributes[1].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3;
-  vertex_attributes[1].offset = offsetof(Vertex, normal);
+  vertex_attributes[1].offset = offsetof(bando::Vertex, normal);
+  vertex_attributes[2].location = 2;
+  vertex_attributes[2].buffer_slot = 0;
+  vertex_attributes[2].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
+  vertex_attributes[2].offset = offsetof(bando::Vertex, uv);
 
   SDL_GPUVertexInputState vertex_input_state = {};
   vertex_input_state.vertex_buffer_descriptions =
       &vertex_buffer_description;
   vertex_input_state.num_vertex_buffers = 1;
   vertex_input_state.vertex_attributes = vertex_attributes;
-  vertex_input_state.num_vertex_attributes = 2;
+  vertex_input_state.num_vertex_attributes = 3;
 
   SDL_GPURasterizerState rasterizer_state = {};
   rasterizer_state.fill_mode = SDL_GPU_FILLMODE_FILL;
@@ -633,8 +822,11 @@ int main(int argc, char **argv) {
   pipeline_info.depth_stencil_state = depth_stencil_state;
   pipeline_info.target_info = target_info;
 
-  SDL_GPUGraphicsPipeline *pipeline =
-      SDL_CreateGPUGraphicsPipeline(device, &pipeline_info);
+  SDL_GPUGraphicsPipeline *pipeline = nullptr;
+  {
+    BANDO_PROFILE_ZONE("CreateGraphicsPipeline");
+    pipeline = SDL_CreateGPUGraphicsPipeline(device, &pipeline_info);
+  }
   if (!pipeline) {
     SDL_Log("SDL_CreateGPUGraphicsPipeline failed: %s", SDL_GetError());
     SDL_ReleaseGPUShader(device, fragment_shader);
@@ -648,8 +840,7 @@ int main(int argc, char **argv) {
 
   SDL_GPUBufferCreateInfo vertex_buffer_info = {};
   vertex_buffer_info.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
-  vertex_buffer_info.size =
-      static_cast<Uint32>(mesh.vertices.size() * sizeof(Vertex));
+  vertex_buffer_info.size = vertex_bytes;
   SDL_GPUBuffer *vertex_buffer =
       SDL_CreateGPUBuffer(device, &vertex_buffer_info);
   if (!vertex_buffer) {
@@ -666,8 +857,7 @@ int main(int argc, char **argv) {
 
   SDL_GPUBufferCreateInfo index_buffer_info = {};
   index_buffer_info.usage = SDL_GPU_BUFFERUSAGE_INDEX;
-  index_buffer_info.size =
-      static_cast<Uint32>(mesh.indices.size() * sizeof(uint32_t));
+  index_buffer_info.size = index_bytes;
   SDL_GPUBuffer *index_buffer =
       SDL_CreateGPUBuffer(device, &index_buffer_info);
   if (!index_buffer) {
@@ -683,10 +873,6 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  Uint32 vertex_bytes =
-      static_cast<Uint32>(mesh.vertices.size() * sizeof(Vertex));
-  Uint32 index_bytes =
-      static_cast<Uint32>(mesh.indices.size() * sizeof(uint32_t));
   SDL_GPUTransferBufferCreateInfo transfer_info = {};
   transfer_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
   transfer_info.size = vertex_bytes + index_bytes;
@@ -706,10 +892,46 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  void *transfer_memory =
-      SDL_MapGPUTransferBuffer(device, transfer_buffer, false);
+  // With --occlusion, a simplified copy of the mesh is rasterized into the
+  // CPU occlusion buffer every frame. Skinned meshes move away from their
+  // bind pose, so they are not used as occluders.
+  std::vector<glm::vec3> occluder_positions;
+  std::vector<uint32_t> occluder_indices;
+  auto *transfer_memory = static_cast<uint8_t *>(
+      SDL_MapGPUTransferBuffer(device, transfer_buffer, false));
+  bool mesh_decoded = false;
   if (!transfer_memory) {
     SDL_Log("SDL_MapGPUTransferBuffer failed: %s", SDL_GetError());
+  } else {
+    // Sizes are multiples of sizeof(Vertex), so the indices stay 4 byte
+    // aligned.
+    auto *vertices = reinterpret_cast<bando::Vertex *>(transfer_memory);
+    auto *indices =
+        reinterpret_cast<uint32_t *>(transfer_memory + vertex_bytes);
+    mesh_decoded = bando::DecodeGltfMeshInto(*scene, mesh_layout, vertices,
+                                             indices, &mesh, &mesh_error);
+    // The occluder is simplified from the decoded mesh while it is still
+    // mapped, instead of decoding the scene a second time.
+    if (mesh_decoded && options.occlusion && crowd.character_count() == 0 &&
+        mesh_layout.vertex_count > 0) {
+      bando::BuildOccluderMesh(&vertices[0].position.x,
+                               mesh_layout.vertex_count, sizeof(bando::Vertex),
+                               indices, mesh_layout.index_count,
+                               kMaxOccluderTriangles, &occluder_positions,
+                               &occluder_indices);
+    }
+    SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
+    if (!mesh_decoded) {
+      SDL_Log("%s", mesh_error.c_str());
+    }
+  }
+  ModelGraph model_graph;
+  if (mesh_decoded) {
+    BuildModelGraph(*scene, mesh, crowd.character_count() > 0,
+                    &model_graph);
+  }
+  scene.reset();
+  if (!mesh_decoded) {
     SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
     SDL_ReleaseGPUBuffer(device, index_buffer);
     SDL_ReleaseGPUBuffer(device, vertex_buffer);
@@ -722,10 +944,6 @@ int main(int argc, char **argv) {
     SDL_Quit();
     return 1;
   }
-  std::memcpy(transfer_memory, mesh.vertices.data(), vertex_bytes);
-  std::memcpy(static_cast<uint8_t *>(transfer_memory) + vertex_bytes,
-              mesh.indices.data(), index_bytes);
-  SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
 
   SDL_GPUCommandBuffer *upload_command_buffer =
       SDL_AcquireGPUCommandBuffer(device);
@@ -740,18 +958,115 @@ int main(int argc, char **argv) {
   SDL_EndGPUCopyPass(copy_pass);
   SDL_SubmitGPUCommandBuffer(upload_command_buffer);
 
+  if (textures_ready.valid() && !textures_ready.get()) {
+    SDL_Log("Material texture unavailable: %s", texture_error.c_str());
+  }
+  // textures[0] is sampled as the base color; white stands in when the
+  // material has none or it failed. Other failed jobs have no levels and
+  // are not uploaded.
+  if (mesh.base_color_image < 0) {
+    textures.insert(textures.begin(), WhiteTexture());
+  } else if (textures.empty() || textures[0].levels.empty()) {
+    textures.resize(std::max<size_t>(textures.size(), 1));
+    textures[0] = WhiteTexture();
+  }
+  textures.erase(std::remove_if(textures.begin() + 1, textures.end(),
+                                [](const bando::Texture &texture) {
+                                  return texture.levels.empty();
+                                }),
+                 textures.end());
+  std::vector<SDL_GPUTexture *> gpu_textures;
+  std::string upload_error;
+  SDL_GPUSampler *sampler = nullptr;
+  if (bando::UploadTextures(device, textures, &gpu_textures, &upload_error)) {
+    SDL_GPUSamplerCreateInfo sampler_info = {};
+    sampler_info.min_filter = SDL_GPU_FILTER_LINEAR;
+    sampler_info.mag_filter = SDL_GPU_FILTER_LINEAR;
+    sampler_info.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
+    sampler_info.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+    sampler_info.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+    sampler_info.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+    sampler_info.min_lod = 0.0f;
+    sampler_info.max_lod = static_cast<float>(textures[0].levels.size());
+    sampler = SDL_CreateGPUSampler(device, &sampler_info);
+    if (!sampler) {
+      upload_error = std::string("SDL_CreateGPUSampler failed: ") +
+                     SDL_GetError();
+    }
+  }
+  // Mip data is on the GPU now; drop the CPU copies.
+  textures.clear();
+  if (!sampler) {
+    SDL_Log("%s", upload_error.c_str());
+    for (SDL_GPUTexture *texture : gpu_textures) {
+      SDL_ReleaseGPUTexture(device, texture);
+    }
+    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+    SDL_ReleaseGPUBuffer(device, index_buffer);
+    SDL_ReleaseGPUBuffer(device, vertex_buffer);
+    SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+    SDL_ReleaseGPUShader(device, fragment_shader);
+    SDL_ReleaseGPUShader(device, vertex_shader);
+    SDL_ReleaseWindowFromGPUDevice(device, window);
+    SDL_DestroyGPUDevice(device);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 1;
+  }
+
+  bando::OcclusionBuffer occlusion_buffer(kOcclusionWidth, kOcclusionHeight);
+
+  std::vector<DemoLight> demo_orbits;
+  std::vector<bando::Light> demo_lights;
+  MakeDemoLights(kDemoLightCount, &demo_orbits, &demo_lights);
+  bando::LightClusters light_clusters;
+  LightBuffers light_buffers;
+  if (!CreateLightBuffers(device, light_clusters.desc(), demo_lights.size(),
+                          &light_buffers)) {
+    SDL_Log("Failed to create light buffers: %s", SDL_GetError());
+    SDL_ReleaseGPUSampler(device, sampler);
+    for (SDL_GPUTexture *texture : gpu_textures) {
+      SDL_ReleaseGPUTexture(device, texture);
+    }
+    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+    SDL_ReleaseGPUBuffer(device, index_buffer);
+    SDL_ReleaseGPUBuffer(device, vertex_buffer);
+    SDL_ReleaseGPUGraphicsPipeline(device, pipeline);
+    SDL_ReleaseGPUShader(device, fragment_shader);
+    SDL_ReleaseGPUShader(device, vertex_shader);
+    SDL_ReleaseWindowFromGPUDevice(device, window);
+    SDL_DestroyGPUDevice(device);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 1;
+  }
+  SDL_Log("Clustered lighting: %zu lights in %zu clusters",
+          demo_lights.size(), light_clusters.cluster_count());
+  bool light_lists_uploaded = false;
+
   SDL_GPUTexture *depth_texture = nullptr;
   Uint32 depth_width = 0;
   Uint32 depth_height = 0;
 
   Uint64 start_ticks = SDL_GetTicks();
+  Uint64 last_frame_ticks = start_ticks;
   bool running = true;
   while (running) {
+    BANDO_PROFILE_ZONE("Frame");
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
       if (event.type == SDL_EVENT_QUIT) {
         running = false;
       }
+      if (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_F9 &&
+          !options.trace_path.empty()) {
+        std::string trace_error;
+        if (bando::WriteChromeTrace(options.trace_path, &trace_error)) {
+          BANDO_LOG_INFO("Wrote profiling trace to {}", options.trace_path);
+        } else {
+          BANDO_LOG_WARN("{}", trace_error);
+        }
+      }
     }
     if (options.timeout_seconds > 0.0) {
       Uint64 elapsed = SDL_GetTicks() - start_ticks;
@@ -766,12 +1081,16 @@ int main(int argc, char **argv) {
     SDL_GPUTexture *swapchain_texture = nullptr;
     Uint32 swapchain_width = 0;
     Uint32 swapchain_height = 0;
-    if (!SDL_WaitAndAcquireGPUSwapchainTexture(command_buffer, window,
-                                               &swapchain_texture,
-                                               &swapchain_width,
-                                               &swapchain_height)) {
-      SDL_Log("SDL_WaitAndAcquireGPUSwapchainTexture failed: %s",
-              SDL_GetError());
+    bool acquired = false;
+    {
+      BANDO_PROFILE_ZONE("AcquireSwapchain");
+      acquired = SDL_WaitAndAcquireGPUSwapchainTexture(
+          command_buffer, window, &swapchain_texture, &swapchain_width,
+          &swapchain_height);
+    }
+    if (!acquired) {
+      BANDO_LOG_WARN("SDL_WaitAndAcquireGPUSwapchainTexture failed: {}",
+                     SDL_GetError());
       SDL_SubmitGPUCommandBuffer(command_buffer);
       continue;
     }
@@ -790,37 +1109,126 @@ int main(int argc, char **argv) {
       depth_width = swapchain_width;
       depth_height = swapchain_height;
       if (!depth_texture) {
-        SDL_Log("Failed to create depth texture: %s", SDL_GetError());
+        BANDO_LOG_ERROR("Failed to create depth texture: {}", SDL_GetError());
         SDL_SubmitGPUCommandBuffer(command_buffer);
         continue;
       }
     }
 
+    Uint64 frame_ticks = SDL_GetTicks();
+    float frame_seconds =
+        static_cast<float>(frame_ticks - last_frame_ticks) * 0.001f;
+    last_frame_ticks = frame_ticks;
+    if (crowd.character_count() > 0) {
+      BANDO_PROFILE_ZONE("SkinMesh");
+      // Cycling hands out fresh memory while the previous frame's upload may
+      // still be reading the old one. Only the vertex region is written.
+      auto *skinned = static_cast<bando::Vertex *>(
+          SDL_MapGPUTransferBuffer(device, transfer_buffer, true));
+      if (skinned) {
+        bando::SkinTarget target = {};
+        target.positions = &skinned[0].position.x;
+        target.normals = &skinned[0].normal.x;
+        target.uvs = &skinned[0].uv.x;
+        target.stride = sizeof(bando::Vertex);
+        crowd.Update(frame_seconds, target);
+        SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
+        SDL_GPUCopyPass *skin_pass = SDL_BeginGPUCopyPass(command_buffer);
+        SDL_UploadToGPUBuffer(skin_pass, &vertex_source, &vertex_destination,
+                              true);
+        SDL_EndGPUCopyPass(skin_pass);
+      } else {
+        BANDO_LOG_WARN("SDL_MapGPUTransferBuffer failed: {}",
+                       SDL_GetError());
+      }
+    }
+
+    BANDO_PROFILE_ZONE("RecordFrame");
     float aspect = swapchain_height > 0
                        ? static_cast<float>(swapchain_width) /
                              static_cast<float>(swapchain_height)
                        : 1.0f;
+    float far_plane = mesh.radius * 6.0f;
     glm::mat4 projection = glm::perspectiveRH_ZO(
-        glm::radians(60.0f), aspect, 0.1f, mesh.radius * 6.0f);
+        glm::radians(60.0f), aspect, kNearPlane, far_plane);
     projection[1][1] *= -1.0f;
     float distance = mesh.radius * 2.5f;
     glm::vec3 eye = mesh.center + glm::vec3(0.0f, mesh.radius, distance);
     glm::mat4 view = glm::lookAt(eye, mesh.center, glm::vec3(0.0f, 1.0f, 0.0f));
     float angle = static_cast<float>(SDL_GetTicks()) * 0.0004f;
-    glm::mat4 base_model =
-        glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / mesh.radius)) *
-        glm::translate(glm::mat4(1.0f), -mesh.center);
-    glm::mat4 model =
-        glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 1.0f, 0.0f)) *
-        base_model;
+    model_graph.graph.SetRotation(
+        model_graph.turntable,
+        glm::angleAxis(angle, glm::vec3(0.0f, 1.0f, 0.0f)));
+    model_graph.graph.Update(&worker_pool);
+    glm::mat4 model = model_graph.graph.world(model_graph.draw_node);
 
     VertexUniforms vertex_uniforms = {};
     vertex_uniforms.mvp = projection * view * model;
     vertex_uniforms.model = model;
+
+    // Occluders go into the CPU depth buffer, then every draw's bounds are
+    // tested against it. The mesh is the only occluder and its bounds
+    // enclose it, so it stays visible; the stage is opt-in (--occlusion)
+    // for profiling the OcclusionCulling zone until the scene has more
+    // draws.
+    bool mesh_visible = true;
+    if (!occluder_indices.empty()) {
+      BANDO_PROFILE_ZONE("OcclusionCulling");
+      bando::Occluder occluder;
+      occluder.clip_from_object = vertex_uniforms.mvp;
+      occluder.positions = &occluder_positions[0].x;
+      occluder.stride = sizeof(glm::vec3);
+      occluder.vertex_count = occluder_positions.size();
+      occluder.indices = occluder_indices.data();
+      occluder.index_count = occluder_indices.size();
+      occlusion_buffer.Begin();
+      occlusion_buffer.AddOccluder(occluder);
+      occlusion_buffer.Rasterize(&worker_pool);
+      bando::OcclusionBox bounds;
+      bounds.clip_from_object = vertex_uniforms.mvp;
+      bounds.min = mesh.center - glm::vec3(mesh.radius);
+      bounds.max = mesh.center + glm::vec3(mesh.radius);
+      mesh_visible = occlusion_buffer.IsVisible(bounds);
+    }
+
+    // Lights are binned for this frame's camera and their lists uploaded
+    // before the render pass reads them.
+    {
+      BANDO_PROFILE_ZONE("BinLights");
+      AnimateDemoLights(demo_orbits,
+                        static_cast<float>(frame_ticks - start_ticks) * 0.001f,
+                        &demo_lights);
+      bando::ClusterCamera cluster_camera;
+      cluster_camera.view = view;
+      cluster_camera.x_scale = projection[0][0];
+      cluster_camera.y_scale = projection[1][1];
+      cluster_camera.near_plane = kNearPlane;
+      cluster_camera.far_plane = far_plane;
+      light_clusters.Build(demo_lights.data(), demo_lights.size(),
+                           cluster_camera, &worker_pool);
+      if (UploadLightClusters(device, command_buffer, light_clusters,
+                              light_buffers)) {
+        light_lists_uploaded = true;
+      } else {
+        BANDO_LOG_WARN("Light list upload failed: {}", SDL_GetError());
+      }
+    }
+
     FragmentUniforms fragment_uniforms = {};
     fragment_uniforms.light_dir =
         glm::vec4(glm::normalize(glm::vec3(0.3f, 1.0f, 0.4f)), 0.0f);
     fragment_uniforms.base_color = mesh.base_color;
+    const bando::ClusterGridDesc &grid = light_clusters.desc();
+    fragment_uniforms.cluster_scale = glm::vec4(
+        static_cast<float>(grid.tiles_x) /
+            static_cast<float>(std::max<Uint32>(swapchain_width, 1)),
+        static_cast<float>(grid.tiles_y) /
+            static_cast<float>(std::max<Uint32>(swapchain_height, 1)),
+        light_clusters.slice_scale(), light_clusters.slice_bias());
+    fragment_uniforms.cluster_dims = glm::uvec4(
+        static_cast<uint32_t>(grid.tiles_x),
+        static_cast<uint32_t>(grid.tiles_y),
+        static_cast<uint32_t>(grid.slices), light_lists_uploaded ? 1u : 0u);
 
     SDL_PushGPUVertexUniformData(command_buffer, 0, &vertex_uniforms,
                                  sizeof(vertex_uniforms));
@@ -856,16 +1264,31 @@ int main(int argc, char **argv) {
     SDL_GPUBufferBinding index_binding = {index_buffer, 0};
     SDL_BindGPUIndexBuffer(render_pass, &index_binding,
                            SDL_GPU_INDEXELEMENTSIZE_32BIT);
-    SDL_DrawGPUIndexedPrimitives(render_pass,
-                                 static_cast<Uint32>(mesh.indices.size()), 1,
-                                 0, 0, 0);
+    SDL_GPUTextureSamplerBinding texture_binding = {gpu_textures[0], sampler};
+    SDL_BindGPUFragmentSamplers(render_pass, 0, &texture_binding, 1);
+    SDL_GPUBuffer *storage_buffers[3] = {
+        light_buffers.lights, light_buffers.clusters, light_buffers.indices};
+    SDL_BindGPUFragmentStorageBuffers(render_pass, 0, storage_buffers, 3);
+    if (mesh_visible) {
+      SDL_DrawGPUIndexedPrimitives(
+          render_pass, static_cast<Uint32>(mesh_layout.index_count), 1, 0, 0,
+          0);
+    }
     SDL_EndGPURenderPass(render_pass);
-    SDL_SubmitGPUCommandBuffer(command_buffer);
+    {
+      BANDO_PROFILE_ZONE("Submit");
+      SDL_SubmitGPUCommandBuffer(command_buffer);
+    }
   }
 
   if (depth_texture) {
     SDL_ReleaseGPUTexture(device, depth_texture);
   }
+  ReleaseLightBuffers(device, &light_buffers);
+  SDL_ReleaseGPUSampler(device, sampler);
+  for (SDL_GPUTexture *texture : gpu_textures) {
+    SDL_ReleaseGPUTexture(device, texture);
+  }
   SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
   SDL_ReleaseGPUBuffer(device, index_buffer);
   SDL_ReleaseGPUBuffer(device, vertex_buffer);
@@ -876,5 +1299,11 @@ int main(int argc, char **argv) {
   SDL_DestroyGPUDevice(device);
   SDL_DestroyWindow(window);
   SDL_Quit();
+  if (!options.trace_path.empty()) {
+    std::string trace_error;
+    if (!bando::WriteChromeTrace(options.trace_path, &trace_error)) {
+      SDL_Log("%s", trace_error.c_str());
+    }
+  }
   return 0;
 }
@@ -1,18 +1,83 @@
 #version 450
 
 layout(location = 0) in vec3 vNormal;
+layout(location = 1) in vec2 vUv;
+layout(location = 2) in vec3 vWorldPosition;
+
+layout(set = 2, binding = 0) uniform sampler2D uBaseColorTexture;
+
+// bando::GpuLight, in world space.
+struct Light {
+  vec4 positionRange;
+  vec4 colorSpotScale;
+  vec4 directionCosOuter;
+};
+
+// Clustered light lists built by bando::LightClusters every frame.
+layout(std430, set = 2, binding = 1) readonly buffer Lights {
+  Light lights[];
+};
+layout(std430, set = 2, binding = 2) readonly buffer Clusters {
+  uvec2 clusters[];
+};
+layout(std430, set = 2, binding = 3) readonly buffer LightIndices {
+  uint lightIndices[];
+};
 
 layout(set = 3, binding = 0) uniform FragmentUniforms {
   vec4 uLightDir;
   vec4 uBaseColor;
+  // Tiles per pixel in x and y, then the depth slice scale and bias.
+  vec4 uClusterScale;
+  // Tiles in x and y, depth slices, and nonzero once lists were uploaded.
+  uvec4 uClusterDims;
 } ubo;
 
 layout(location = 0) out vec4 outColor;
 
+vec3 ClusteredLighting(vec3 normal) {
+  if (ubo.uClusterDims.w == 0u) {
+    return vec3(0.0);
+  }
+  // gl_FragCoord.w is 1 / clip w, and clip w is the view depth.
+  float depth = 1.0 / gl_FragCoord.w;
+  uvec3 dims = ubo.uClusterDims.xyz;
+  uvec2 tile = min(uvec2(gl_FragCoord.xy * ubo.uClusterScale.xy),
+                   dims.xy - 1u);
+  int slice = int(floor(log(depth) * ubo.uClusterScale.z +
+                        ubo.uClusterScale.w));
+  uint z = uint(clamp(slice, 0, int(dims.z) - 1));
+  uvec2 range = clusters[(z * dims.y + tile.y) * dims.x + tile.x];
+
+  vec3 result = vec3(0.0);
+  for (uint i = 0u; i < range.y; ++i) {
+    Light light = lights[lightIndices[range.x + i]];
+    vec3 toLight = light.positionRange.xyz - vWorldPosition;
+    float lightDistance = length(toLight);
+    float ratio = lightDistance / light.positionRange.w;
+    if (ratio >= 1.0 || lightDistance <= 0.0) {
+      continue;
+    }
+    vec3 lightDir = toLight / lightDistance;
+    // Smooth window that reaches zero exactly at the light's range.
+    float ratio2 = ratio * ratio;
+    float window = clamp(1.0 - ratio2 * ratio2, 0.0, 1.0);
+    float spot = clamp((dot(-lightDir, light.directionCosOuter.xyz) -
+                        light.directionCosOuter.w) *
+                           light.colorSpotScale.w,
+                       0.0, 1.0);
+    float ndotl = max(dot(normal, lightDir), 0.0);
+    result += light.colorSpotScale.rgb * (ndotl * window * window * spot);
+  }
+  return result;
+}
+
 void main() {
   vec3 normal = normalize(vNormal);
   vec3 lightDir = normalize(-ubo.uLightDir.xyz);
   float ndotl = max(dot(normal, lightDir), 0.0);
-  vec3 litColor = ubo.uBaseColor.rgb * (0.1 + ndotl);
-  outColor = vec4(litColor, ubo.uBaseColor.a);
+  vec4 baseColor = ubo.uBaseColor * texture(uBaseColorTexture, vUv);
+  vec3 litColor =
+      baseColor.rgb * (0.1 + ndotl + ClusteredLighting(normal));
+  outColor = vec4(litColor, baseColor.a);
 }
@@ -2,6 +2,7 @@
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inUv;
 
 layout(set = 1, binding = 0) uniform VertexUniforms {
   mat4 uMvp;
@@ -9,8 +10,12 @@ layout(set = 1, binding = 0) uniform VertexUniforms {
 } ubo;
 
 layout(location = 0) out vec3 vNormal;
+layout(location = 1) out vec2 vUv;
+layout(location = 2) out vec3 vWorldPosition;
 
 void main() {
   vNormal = mat3(ubo.uModel) * inNormal;
+  vUv = inUv;
+  vWorldPosition = (ubo.uModel * vec4(inPosition, 1.0)).xyz;
   gl_Position = ubo.uMvp * vec4(inPosition, 1.0);
 }
@@ -0,0 +1,497 @@
+#include "examples/spdlog/async_log.h"
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#if defined(SPDLOG_FMT_EXTERNAL)
+#include <fmt/args.h>
+#else
+#include <spdlog/fmt/bundled/args.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace bando {
+
+namespace {
+
+// Binary log layout (native endian):
+//   char[4] magic "BLOG", uint32 version
+// followed by entries starting with a one byte kind:
+//   kSiteEntry:   uint32 site id, uint8 level, int32 line,
+//                 uint16 file length, file, uint16 format length, format
+//   kRecordEntry: uint32 site id, int64 timestamp ns, uint32 thread id,
+//                 uint32 suppressed, uint8 truncated, uint8 arg count,
+//                 uint16 payload size, payload
+// Sites are written once per file, before their first record.
+constexpr char kBinaryLogMagic[4] = {'B', 'L', 'O', 'G'};
+constexpr uint32_t kBinaryLogVersion = 1;
+constexpr uint8_t kSiteEntry = 0;
+constexpr uint8_t kRecordEntry = 1;
+constexpr auto kIdleSleep = std::chrono::milliseconds(1);
+
+// Bounded multi-producer single-consumer queue (Vyukov). Producers claim a
+// cell with a single CAS on the enqueue position; each cell carries a
+// sequence number that tells the consumer when the record is published.
+class RecordQueue {
+ public:
+  explicit RecordQueue(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+      size <<= 1;
+    }
+    cells_.reset(new Cell[size]);
+    mask_ = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+  bool TryPush(const LogRecord &record) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell *cell = nullptr;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->record = record;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Must only be called from the backend thread.
+  bool TryPop(LogRecord *record) {
+    Cell *cell = &cells_[dequeue_pos_ & mask_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) -
+            static_cast<intptr_t>(dequeue_pos_ + 1) <
+        0) {
+      return false;
+    }
+    *record = cell->record;
+    cell->sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    ++dequeue_pos_;
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence{0};
+    LogRecord record;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_ = 0;
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) size_t dequeue_pos_ = 0;
+};
+
+// Owned by the backend thread while it runs.
+class Backend {
+ public:
+  bool Open(const AsyncLogOptions &options, std::string *error) {
+    if (options.console) {
+      logger_ = std::make_shared<spdlog::logger>(
+          "bando", std::make_shared<spdlog::sinks::stderr_color_sink_st>());
+      logger_->set_pattern("[%H:%M:%S.%e] [%^%l%$] [%s:%#] %v");
+      logger_->set_level(spdlog::level::trace);
+    }
+    if (!options.binary_path.empty()) {
+      binary_ = std::fopen(options.binary_path.c_str(), "wb");
+      if (!binary_) {
+        if (error) {
+          *error = "Failed to open binary log: " + options.binary_path;
+        }
+        return false;
+      }
+      std::setvbuf(binary_, nullptr, _IOFBF, 1 << 16);
+      std::fwrite(kBinaryLogMagic, 1, sizeof(kBinaryLogMagic), binary_);
+      Write(kBinaryLogVersion);
+    }
+    return true;
+  }
+
+  void Close() {
+    Flush();
+    if (binary_) {
+      std::fclose(binary_);
+      binary_ = nullptr;
+    }
+    logger_.reset();
+    site_ids_.clear();
+  }
+
+  void Dispatch(const LogRecord &record) {
+    if (binary_) {
+      WriteRecord(record);
+    }
+    if (logger_) {
+      LogFormatted(record);
+    }
+    dirty_ = true;
+  }
+
+  void Flush() {
+    if (!dirty_) {
+      return;
+    }
+    if (binary_) {
+      std::fflush(binary_);
+    }
+    if (logger_) {
+      logger_->flush();
+    }
+    dirty_ = false;
+  }
+
+ private:
+  template <typename T>
+  void Write(const T &value) {
+    std::fwrite(&value, sizeof(T), 1, binary_);
+  }
+
+  void WriteString(const char *text) {
+    size_t length = std::strlen(text);
+    uint16_t size = static_cast<uint16_t>(length < 0xffff ? length : 0xffff);
+    Write(size);
+    std::fwrite(text, 1, size, binary_);
+  }
+
+  void WriteRecord(const LogRecord &record) {
+    auto it = site_ids_.find(record.site);
+    if (it == site_ids_.end()) {
+      uint32_t id = static_cast<uint32_t>(site_ids_.size());
+      it = site_ids_.emplace(record.site, id).first;
+      Write(kSiteEntry);
+      Write(id);
+      Write(static_cast<uint8_t>(record.site->level));
+      Write(static_cast<int32_t>(record.site->line));
+      WriteString(record.site->file);
+      WriteString(record.site->format);
+    }
+    Write(kRecordEntry);
+    Write(it->second);
+    Write(record.timestamp_ns);
+    Write(record.thread_id);
+    Write(record.suppressed);
+    Write(record.truncated);
+    Write(record.arg_count);
+    Write(record.payload_size);
+    std::fwrite(record.payload, 1, record.payload_size, binary_);
+  }
+
+  void LogFormatted(const LogRecord &record) {
+    std::string message =
+        FormatLogPayload(record.site->format, record.payload,
+                         record.payload_size, record.arg_count);
+    if (record.truncated) {
+      message += " [truncated]";
+    }
+    if (record.suppressed) {
+      message += " (" + std::to_string(record.suppressed) +
+                 " similar messages suppressed)";
+    }
+    spdlog::log_clock::time_point time(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(
+            std::chrono::nanoseconds(record.timestamp_ns)));
+    logger_->log(time,
+                 spdlog::source_loc{record.site->file, record.site->line, ""},
+                 ToSpdlogLevel(record.site->level), message);
+  }
+
+  static spdlog::level::level_enum ToSpdlogLevel(LogLevel level) {
+    switch (level) {
+      case LogLevel::kTrace:
+        return spdlog::level::trace;
+      case LogLevel::kDebug:
+        return spdlog::level::debug;
+      case LogLevel::kInfo:
+        return spdlog::level::info;
+      case LogLevel::kWarn:
+        return spdlog::level::warn;
+      case LogLevel::kError:
+        return spdlog::level::err;
+    }
+    return spdlog::level::info;
+  }
+
+  std::shared_ptr<spdlog::logger> logger_;
+  std::FILE *binary_ = nullptr;
+  std::unordered_map<const LogSite *, uint32_t> site_ids_;
+  bool dirty_ = false;
+};
+
+std::atomic<uint8_t> g_min_level{static_cast<uint8_t>(LogLevel::kInfo)};
+std::atomic<uint32_t> g_rate_limit_burst{5};
+std::atomic<int64_t> g_rate_limit_window_ns{1000000000};
+std::atomic<uint64_t> g_dropped{0};
+// Claimed by StartAsyncLog before any setup and released by StopAsyncLog
+// after the join, so overlapping starts cannot both spawn a backend.
+// g_running is only published once the queue and thread exist.
+std::atomic<bool> g_started{false};
+std::atomic<bool> g_running{false};
+// Allocated by the first StartAsyncLog and never replaced or freed, so that
+// producers racing with StopAsyncLog never touch released memory. Later
+// starts keep the first capacity.
+std::unique_ptr<RecordQueue> g_queue;
+std::unique_ptr<Backend> g_backend;
+std::thread g_backend_thread;
+std::atomic<bool> g_stop_requested{false};
+
+void BackendLoop() {
+  LogRecord record;
+  for (;;) {
+    bool stop = g_stop_requested.load(std::memory_order_acquire);
+    bool idle = true;
+    while (g_queue->TryPop(&record)) {
+      g_backend->Dispatch(record);
+      idle = false;
+    }
+    if (stop) {
+      break;
+    }
+    if (idle) {
+      g_backend->Flush();
+      std::this_thread::sleep_for(kIdleSleep);
+    }
+  }
+  g_backend->Close();
+}
+
+void WriteSynchronously(const LogRecord &record) {
+  std::string message =
+      FormatLogPayload(record.site->format, record.payload,
+                       record.payload_size, record.arg_count);
+  std::fprintf(stderr, "[%s] [%s:%d] %s\n", LogLevelName(record.site->level),
+               record.site->file, record.site->line, message.c_str());
+}
+
+}  // namespace
+
+const char *LogLevelName(LogLevel level) {
+  switch (level) {
+    case LogLevel::kTrace:
+      return "trace";
+    case LogLevel::kDebug:
+      return "debug";
+    case LogLevel::kInfo:
+      return "info";
+    case LogLevel::kWarn:
+      return "warning";
+    case LogLevel::kError:
+      return "error";
+  }
+  return "unknown";
+}
+
+bool StartAsyncLog(const AsyncLogOptions &options, std::string *error) {
+  bool expected = false;
+  if (!g_started.compare_exchange_strong(expected, true)) {
+    if (error) {
+      *error = "Async logging already started";
+    }
+    return false;
+  }
+  auto backend = std::make_unique<Backend>();
+  if (!backend->Open(options, error)) {
+    g_started.store(false);
+    return false;
+  }
+  if (!g_queue) {
+    g_queue = std::make_unique<RecordQueue>(options.queue_capacity);
+  }
+  g_backend = std::move(backend);
+  g_min_level.store(static_cast<uint8_t>(options.min_level));
+  g_rate_limit_burst.store(options.rate_limit_burst);
+  g_rate_limit_window_ns.store(
+      static_cast<int64_t>(options.rate_limit_window_ms) * 1000000);
+  g_dropped.store(0);
+  g_stop_requested.store(false);
+  g_backend_thread = std::thread(BackendLoop);
+  g_running.store(true, std::memory_order_release);
+  return true;
+}
+
+void StopAsyncLog() {
+  if (!g_running.exchange(false)) {
+    return;
+  }
+  g_stop_requested.store(true, std::memory_order_release);
+  g_backend_thread.join();
+  g_backend.reset();
+  g_started.store(false);
+  uint64_t dropped = g_dropped.load();
+  if (dropped) {
+    std::fprintf(stderr, "[warning] %llu log records dropped (queue full)\n",
+                 static_cast<unsigned long long>(dropped));
+  }
+}
+
+uint64_t DroppedLogRecords() { return g_dropped.load(); }
+
+std::string FormatLogPayload(const char *format,
+                             const uint8_t *payload,
+                             size_t payload_size,
+                             uint8_t arg_count) {
+  fmt::dynamic_format_arg_store<fmt::format_context> args;
+  const std::string corrupt = std::string(format) + " [corrupt payload]";
+  // Payloads may come from a truncated or damaged binary log, so every read
+  // is checked against the payload size first.
+  auto fits = [payload_size](size_t offset, size_t needed) {
+    return needed <= payload_size && offset <= payload_size - needed;
+  };
+  size_t offset = 0;
+  for (uint8_t i = 0; i < arg_count && offset < payload_size; ++i) {
+    LogArgType type = static_cast<LogArgType>(payload[offset++]);
+    const uint8_t *data = payload + offset;
+    size_t needed = 0;
+    switch (type) {
+      case LogArgType::kInt64:
+      case LogArgType::kUint64:
+      case LogArgType::kDouble:
+      case LogArgType::kPointer:
+        needed = sizeof(uint64_t);
+        break;
+      case LogArgType::kBool:
+      case LogArgType::kChar:
+        needed = 1;
+        break;
+      case LogArgType::kString:
+        needed = sizeof(uint16_t);
+        break;
+      default:
+        return corrupt;
+    }
+    if (!fits(offset, needed)) {
+      return corrupt;
+    }
+    switch (type) {
+      case LogArgType::kInt64: {
+        int64_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        args.push_back(value);
+        offset += sizeof(value);
+        break;
+      }
+      case LogArgType::kUint64: {
+        uint64_t value = 0;
+        std::memcpy(&value, data, sizeof(value));
+        args.push_back(value);
+        offset += sizeof(value);
+        break;
+      }
+      case LogArgType::kDouble: {
+        double value = 0.0;
+        std::memcpy(&value, data, sizeof(value));
+        args.push_back(value);
+        offset += sizeof(value);
+        break;
+      }
+      case LogArgType::kBool:
+        args.push_back(data[0] != 0);
+        offset += 1;
+        break;
+      case LogArgType::kChar:
+        args.push_back(static_cast<char>(data[0]));
+        offset += 1;
+        break;
+      case LogArgType::kString: {
+        uint16_t length = 0;
+        std::memcpy(&length, data, sizeof(length));
+        if (!fits(offset + sizeof(length), length)) {
+          return corrupt;
+        }
+        args.push_back(fmt::string_view(
+            reinterpret_cast<const char *>(data + sizeof(length)), length));
+        offset += sizeof(length) + length;
+        break;
+      }
+      case LogArgType::kPointer: {
+        uint64_t address = 0;
+        std::memcpy(&address, data, sizeof(address));
+        args.push_back(
+            reinterpret_cast<const void *>(static_cast<uintptr_t>(address)));
+        offset += sizeof(address);
+        break;
+      }
+      default:
+        return corrupt;
+    }
+  }
+  try {
+    return fmt::vformat(format, args);
+  } catch (const std::exception &) {
+    return std::string(format) + " [format error]";
+  }
+}
+
+namespace log_internal {
+
+bool IsLevelEnabled(LogLevel level) {
+  return static_cast<uint8_t>(level) >=
+         g_min_level.load(std::memory_order_relaxed);
+}
+
+bool AdmitSite(LogSite *site, int64_t now_ns, uint32_t *suppressed) {
+  uint32_t burst = g_rate_limit_burst.load(std::memory_order_relaxed);
+  if (burst != 0) {
+    int64_t window_ns = g_rate_limit_window_ns.load(std::memory_order_relaxed);
+    int64_t start = site->window_start_ns.load(std::memory_order_relaxed);
+    if (now_ns - start >= window_ns &&
+        site->window_start_ns.compare_exchange_strong(
+            start, now_ns, std::memory_order_relaxed)) {
+      site->window_count.store(0, std::memory_order_relaxed);
+    }
+    if (site->window_count.fetch_add(1, std::memory_order_relaxed) >= burst) {
+      site->suppressed.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+  *suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+  return true;
+}
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+uint32_t CurrentThreadId() {
+  static std::atomic<uint32_t> next_id{1};
+  thread_local uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+  return id;
+}
+
+void Submit(const LogRecord &record) {
+  if (!g_running.load(std::memory_order_acquire)) {
+    WriteSynchronously(record);
+    return;
+  }
+  if (!g_queue->TryPush(record)) {
+    g_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace log_internal
+
+}  // namespace bando
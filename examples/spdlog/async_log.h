@@ -0,0 +1,244 @@
+#ifndef EXAMPLES_SPDLOG_ASYNC_LOG_H_
+#define EXAMPLES_SPDLOG_ASYNC_LOG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace bando {
+
+enum class LogLevel : uint8_t {
+  kTrace = 0,
+  kDebug = 1,
+  kInfo = 2,
+  kWarn = 3,
+  kError = 4,
+};
+
+// Static metadata of a single log statement. One instance lives in a
+// function-local static per call site (see BANDO_LOG), which is also where
+// the per-site rate limiting state is kept.
+struct LogSite {
+  const char *format;
+  const char *file;
+  int line;
+  LogLevel level;
+  std::atomic<int64_t> window_start_ns{0};
+  std::atomic<uint32_t> window_count{0};
+  std::atomic<uint32_t> suppressed{0};
+};
+
+constexpr size_t kLogPayloadBytes = 96;
+
+// Tags of the arguments stored in a record payload. Arguments are copied
+// raw and only formatted by the backend thread or the offline decoder.
+enum class LogArgType : uint8_t {
+  kInt64 = 0,
+  kUint64 = 1,
+  kDouble = 2,
+  kBool = 3,
+  kChar = 4,
+  kString = 5,
+  kPointer = 6,
+};
+
+struct LogRecord {
+  const LogSite *site = nullptr;
+  int64_t timestamp_ns = 0;
+  uint32_t thread_id = 0;
+  // Messages of the same site dropped by the rate limiter since the last
+  // record that got through.
+  uint32_t suppressed = 0;
+  uint16_t payload_size = 0;
+  uint8_t arg_count = 0;
+  // Set when arguments did not fit in the payload and were cut off.
+  uint8_t truncated = 0;
+  uint8_t payload[kLogPayloadBytes];
+};
+
+struct AsyncLogOptions {
+  // Rounded up to a power of two. Records are dropped, never blocked on,
+  // when the queue is full. The queue lives for the rest of the process, so
+  // only the first start's capacity takes effect.
+  size_t queue_capacity = 8192;
+  LogLevel min_level = LogLevel::kInfo;
+  // Formats records on the backend thread and writes them to stderr through
+  // spdlog.
+  bool console = true;
+  // When set, records are appended unformatted to this file. Decode it with
+  // //examples/spdlog:log_decode.
+  std::string binary_path;
+  // Each call site may emit `rate_limit_burst` records per window; the rest
+  // are counted and reported with the next record that gets through.
+  uint32_t rate_limit_burst = 5;
+  uint32_t rate_limit_window_ms = 1000;
+};
+
+// Starts the backend thread. Logging before StartAsyncLog or after
+// StopAsyncLog formats synchronously to stderr.
+bool StartAsyncLog(const AsyncLogOptions &options, std::string *error);
+// Drains the queue, flushes the sinks and joins the backend thread.
+void StopAsyncLog();
+// Number of records lost because the queue was full.
+uint64_t DroppedLogRecords();
+
+const char *LogLevelName(LogLevel level);
+
+class ScopedAsyncLog {
+ public:
+  explicit ScopedAsyncLog(const AsyncLogOptions &options, std::string *error) {
+    started_ = StartAsyncLog(options, error);
+  }
+  ~ScopedAsyncLog() {
+    if (started_) {
+      StopAsyncLog();
+    }
+  }
+  ScopedAsyncLog(const ScopedAsyncLog &) = delete;
+  ScopedAsyncLog &operator=(const ScopedAsyncLog &) = delete;
+
+  bool started() const { return started_; }
+
+ private:
+  bool started_ = false;
+};
+
+// Formats an encoded payload with `format`. Shared by the backend thread and
+// the offline decoder.
+std::string FormatLogPayload(const char *format,
+                             const uint8_t *payload,
+                             size_t payload_size,
+                             uint8_t arg_count);
+
+namespace log_internal {
+
+bool IsLevelEnabled(LogLevel level);
+// Applies the per-site rate limit. Returns false when the record should be
+// suppressed; otherwise stores the number of previously suppressed records.
+bool AdmitSite(LogSite *site, int64_t now_ns, uint32_t *suppressed);
+int64_t NowNs();
+uint32_t CurrentThreadId();
+void Submit(const LogRecord &record);
+
+class PayloadWriter {
+ public:
+  explicit PayloadWriter(LogRecord *record) : record_(record) {}
+
+  template <typename T>
+  void Add(const T &value) {
+    if constexpr (std::is_same_v<T, bool>) {
+      uint8_t byte = value ? 1 : 0;
+      Put(LogArgType::kBool, &byte, sizeof(byte));
+    } else if constexpr (std::is_same_v<T, char>) {
+      Put(LogArgType::kChar, &value, sizeof(value));
+    } else if constexpr (std::is_enum_v<T>) {
+      Add(static_cast<std::underlying_type_t<T>>(value));
+    } else if constexpr (std::is_integral_v<T>) {
+      if constexpr (std::is_signed_v<T>) {
+        int64_t wide = static_cast<int64_t>(value);
+        Put(LogArgType::kInt64, &wide, sizeof(wide));
+      } else {
+        uint64_t wide = static_cast<uint64_t>(value);
+        Put(LogArgType::kUint64, &wide, sizeof(wide));
+      }
+    } else if constexpr (std::is_floating_point_v<T>) {
+      double wide = static_cast<double>(value);
+      Put(LogArgType::kDouble, &wide, sizeof(wide));
+    } else if constexpr (std::is_same_v<T, std::string> ||
+                         std::is_same_v<T, std::string_view>) {
+      PutString(value.data(), value.size());
+    } else if constexpr (std::is_convertible_v<T, const char *>) {
+      const char *text = value;
+      PutString(text ? text : "(null)", text ? std::strlen(text) : 6);
+    } else {
+      static_assert(std::is_pointer_v<T>, "Unsupported log argument type");
+      uint64_t address = reinterpret_cast<uintptr_t>(value);
+      Put(LogArgType::kPointer, &address, sizeof(address));
+    }
+  }
+
+ private:
+  void Put(LogArgType type, const void *data, size_t size) {
+    if (record_->truncated ||
+        record_->payload_size + 1 + size > kLogPayloadBytes) {
+      record_->truncated = 1;
+      return;
+    }
+    uint8_t *out = record_->payload + record_->payload_size;
+    out[0] = static_cast<uint8_t>(type);
+    std::memcpy(out + 1, data, size);
+    record_->payload_size = static_cast<uint16_t>(record_->payload_size + 1 +
+                                                  size);
+    ++record_->arg_count;
+  }
+
+  void PutString(const char *text, size_t size) {
+    // Strings are cut to whatever still fits so the message stays readable.
+    size_t header = 1 + sizeof(uint16_t);
+    if (record_->truncated ||
+        record_->payload_size + header > kLogPayloadBytes) {
+      record_->truncated = 1;
+      return;
+    }
+    size_t room = kLogPayloadBytes - record_->payload_size - header;
+    uint16_t length = static_cast<uint16_t>(size < room ? size : room);
+    uint8_t *out = record_->payload + record_->payload_size;
+    out[0] = static_cast<uint8_t>(LogArgType::kString);
+    std::memcpy(out + 1, &length, sizeof(length));
+    std::memcpy(out + header, text, length);
+    record_->payload_size =
+        static_cast<uint16_t>(record_->payload_size + header + length);
+    ++record_->arg_count;
+  }
+
+  LogRecord *record_;
+};
+
+}  // namespace log_internal
+
+// Captures the arguments of a log statement without formatting them and
+// pushes the record onto the lock-free queue.
+template <typename... Args>
+void Log(LogSite *site, const Args &...args) {
+  if (!log_internal::IsLevelEnabled(site->level)) {
+    return;
+  }
+  int64_t now_ns = log_internal::NowNs();
+  uint32_t suppressed = 0;
+  if (!log_internal::AdmitSite(site, now_ns, &suppressed)) {
+    return;
+  }
+  LogRecord record;
+  record.site = site;
+  record.timestamp_ns = now_ns;
+  record.thread_id = log_internal::CurrentThreadId();
+  record.suppressed = suppressed;
+  log_internal::PayloadWriter writer(&record);
+  (writer.Add(args), ...);
+  log_internal::Submit(record);
+}
+
+}  // namespace bando
+
+// Format strings use fmt syntax ("{}"), like spdlog.
+#define BANDO_LOG(level, format, ...)                                       \
+  do {                                                                      \
+    static ::bando::LogSite bando_log_site{format, __FILE__, __LINE__,      \
+                                           level};                          \
+    ::bando::Log(&bando_log_site, ##__VA_ARGS__);                           \
+  } while (0)
+
+#define BANDO_LOG_DEBUG(format, ...) \
+  BANDO_LOG(::bando::LogLevel::kDebug, format, ##__VA_ARGS__)
+#define BANDO_LOG_INFO(format, ...) \
+  BANDO_LOG(::bando::LogLevel::kInfo, format, ##__VA_ARGS__)
+#define BANDO_LOG_WARN(format, ...) \
+  BANDO_LOG(::bando::LogLevel::kWarn, format, ##__VA_ARGS__)
+#define BANDO_LOG_ERROR(format, ...) \
+  BANDO_LOG(::bando::LogLevel::kError, format, ##__VA_ARGS__)
+
+#endif  // EXAMPLES_SPDLOG_ASYNC_LOG_H_
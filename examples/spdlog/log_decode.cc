@@ -0,0 +1,126 @@
+#include "examples/spdlog/async_log.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Prints a binary log written by the async logging backend
+// (AsyncLogOptions::binary_path) as text:
+//   bazel run //examples/spdlog:log_decode -- /tmp/hello_3d.blog
+
+namespace {
+
+struct Site {
+  bando::LogLevel level = bando::LogLevel::kInfo;
+  int32_t line = 0;
+  std::string file;
+  std::string format;
+};
+
+template <typename T>
+bool Read(std::FILE *file, T *value) {
+  return std::fread(value, sizeof(T), 1, file) == 1;
+}
+
+bool ReadString(std::FILE *file, std::string *out) {
+  uint16_t size = 0;
+  if (!Read(file, &size)) {
+    return false;
+  }
+  out->resize(size);
+  return size == 0 || std::fread(&(*out)[0], 1, size, file) == size;
+}
+
+std::string FormatTimestamp(int64_t timestamp_ns) {
+  std::time_t seconds = static_cast<std::time_t>(timestamp_ns / 1000000000);
+  int64_t nanos = timestamp_ns % 1000000000;
+  std::tm local = {};
+  localtime_r(&seconds, &local);
+  char buffer[64];
+  std::size_t length = std::strftime(buffer, sizeof(buffer),
+                                     "%Y-%m-%d %H:%M:%S", &local);
+  std::snprintf(buffer + length, sizeof(buffer) - length, ".%09lld",
+                static_cast<long long>(nanos));
+  return buffer;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    std::printf("Usage: %s LOG_FILE\n", argv[0]);
+    return 1;
+  }
+  std::FILE *file = std::fopen(argv[1], "rb");
+  if (!file) {
+    std::printf("Failed to open %s\n", argv[1]);
+    return 1;
+  }
+  char magic[4] = {};
+  uint32_t version = 0;
+  if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+      std::memcmp(magic, "BLOG", sizeof(magic)) != 0 ||
+      !Read(file, &version) || version != 1) {
+    std::printf("%s is not a supported binary log\n", argv[1]);
+    std::fclose(file);
+    return 1;
+  }
+
+  std::unordered_map<uint32_t, Site> sites;
+  std::vector<uint8_t> payload(bando::kLogPayloadBytes);
+  bool ok = true;
+  uint8_t kind = 0;
+  while (ok && Read(file, &kind)) {
+    uint32_t site_id = 0;
+    if (!Read(file, &site_id)) {
+      ok = false;
+      break;
+    }
+    if (kind == 0) {
+      Site site;
+      uint8_t level = 0;
+      ok = Read(file, &level) && Read(file, &site.line) &&
+           ReadString(file, &site.file) && ReadString(file, &site.format);
+      site.level = static_cast<bando::LogLevel>(level);
+      sites[site_id] = site;
+      continue;
+    }
+    int64_t timestamp_ns = 0;
+    uint32_t thread_id = 0;
+    uint32_t suppressed = 0;
+    uint8_t truncated = 0;
+    uint8_t arg_count = 0;
+    uint16_t payload_size = 0;
+    ok = kind == 1 && Read(file, &timestamp_ns) && Read(file, &thread_id) &&
+         Read(file, &suppressed) && Read(file, &truncated) &&
+         Read(file, &arg_count) && Read(file, &payload_size) &&
+         payload_size <= payload.size() &&
+         std::fread(payload.data(), 1, payload_size, file) == payload_size;
+    auto it = sites.find(site_id);
+    if (!ok || it == sites.end()) {
+      ok = false;
+      break;
+    }
+    const Site &site = it->second;
+    std::string message = bando::FormatLogPayload(
+        site.format.c_str(), payload.data(), payload_size, arg_count);
+    std::printf("[%s] [%s] [T%u] [%s:%d] %s%s",
+                FormatTimestamp(timestamp_ns).c_str(),
+                bando::LogLevelName(site.level), thread_id, site.file.c_str(),
+                site.line, message.c_str(), truncated ? " [truncated]" : "");
+    if (suppressed) {
+      std::printf(" (%u similar messages suppressed)", suppressed);
+    }
+    std::printf("\n");
+  }
+  std::fclose(file);
+  if (!ok) {
+    std::printf("Binary log is truncated or corrupt\n");
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,144 @@
+#include "examples/sdl3/hello_3d/gltf_mesh.h"
+#include "examples/sdl3/hello_3d/gltf_scene.h"
+#include "examples/textures/texture_cache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Offline texture baking: decodes, mips and BC7/BC5 encodes every material
+// texture of a glTF asset into a texture cache directory, so applications
+// pointed at the same directory never decode PNG/JPEG at startup.
+//   bazel run -c opt //examples/textures:texture_bake -- \
+//       --model=$PWD/scene.glb --cache=$PWD/texture_cache
+
+namespace {
+
+struct Options {
+  std::string model_path;
+  std::string cache_dir;
+  int threads = 0;
+  bool compress = true;
+};
+
+bool StartsWith(const std::string &value, const std::string &prefix) {
+  return value.rfind(prefix, 0) == 0;
+}
+
+void PrintUsage(const char *argv0) {
+  std::printf(
+      "Usage: %s --model=PATH --cache=DIR [--threads=N] [--uncompressed]\n",
+      argv0);
+}
+
+Options ParseOptions(int argc, char **argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--help" || arg == "-h") {
+      PrintUsage(argv[0]);
+      std::exit(0);
+    }
+    if (StartsWith(arg, "--model=")) {
+      options.model_path = arg.substr(std::strlen("--model="));
+      continue;
+    }
+    if (StartsWith(arg, "--cache=")) {
+      options.cache_dir = arg.substr(std::strlen("--cache="));
+      continue;
+    }
+    if (StartsWith(arg, "--threads=")) {
+      options.threads = std::atoi(arg.c_str() + std::strlen("--threads="));
+      continue;
+    }
+    if (arg == "--uncompressed") {
+      options.compress = false;
+      continue;
+    }
+    std::printf("Unknown argument: %s\n", arg.c_str());
+  }
+  return options;
+}
+
+// Every (image, usage) pair referenced by a material. An image used both
+// as color and as data is baked once per usage.
+std::set<std::pair<int, bando::TextureUsage>> CollectTextureUsages(
+    const bando::GltfScene &scene) {
+  std::set<std::pair<int, bando::TextureUsage>> usages;
+  auto add = [&](int texture_index, bando::TextureUsage usage) {
+    int image = bando::SceneTextureImage(scene, texture_index);
+    if (image >= 0) {
+      usages.emplace(image, usage);
+    }
+  };
+  for (const bando::SceneMaterial &material : scene.materials) {
+    add(material.base_color_texture, bando::TextureUsage::kColorSrgb);
+    add(material.emissive_texture, bando::TextureUsage::kColorSrgb);
+    add(material.metallic_roughness_texture,
+        bando::TextureUsage::kColorLinear);
+    add(material.occlusion_texture, bando::TextureUsage::kColorLinear);
+    add(material.normal_texture, bando::TextureUsage::kNormal);
+  }
+  return usages;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options options = ParseOptions(argc, argv);
+  if (options.model_path.empty() || options.cache_dir.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  bando::GltfScene scene;
+  std::string error;
+  if (!bando::LoadGltfScene(options.model_path, &scene, &error)) {
+    std::printf("%s\n", error.c_str());
+    return 1;
+  }
+  std::string warning = bando::GltfSceneWarnings(scene);
+  if (!warning.empty()) {
+    std::printf("glTF warning: %s\n", warning.c_str());
+  }
+
+  // Every image is read once, even when it is baked for several usages.
+  std::set<std::pair<int, bando::TextureUsage>> usages =
+      CollectTextureUsages(scene);
+  std::vector<std::vector<uint8_t>> encoded_images(scene.images.size());
+  std::vector<bando::TextureJob> jobs;
+  for (const auto &[image, usage] : usages) {
+    if (encoded_images[image].empty() &&
+        !bando::ReadSceneImage(scene, image, &encoded_images[image],
+                               &error)) {
+      std::printf("%s\n", error.c_str());
+      return 1;
+    }
+    bando::TextureJob job;
+    job.encoded = &encoded_images[image];
+    job.usage = usage;
+    jobs.push_back(job);
+  }
+
+  bando::TextureCacheOptions cache_options;
+  cache_options.cache_dir = options.cache_dir;
+  cache_options.compress = options.compress;
+  cache_options.threads = options.threads;
+  std::vector<bando::Texture> textures;
+  bando::TextureCacheStats stats;
+  bool ok = bando::PrepareTextures(jobs, cache_options, &textures, &stats,
+                                   &error);
+  std::printf("Baked %zu textures into %s: %u cached, %u encoded, %u failed "
+              "in %.1f ms\n",
+              jobs.size(), options.cache_dir.c_str(), stats.hits, stats.misses,
+              stats.failures, stats.wall_ms);
+  if (!ok) {
+    std::printf("%s\n", error.c_str());
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,330 @@
+#include "examples/textures/texture_cache.h"
+
+#include "examples/profiling/profile_zones.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace bando {
+
+namespace {
+
+// File layout (little endian):
+//   char[4]  magic "BTEX"
+//   uint32   version
+//   uint32   TextureFormat
+//   uint32   level count, followed by the levels
+// Each level is:
+//   uint32   width
+//   uint32   height
+//   uint64   byte count, followed by the texel or block data
+constexpr char kTextureMagic[4] = {'B', 'T', 'E', 'X'};
+constexpr uint32_t kTextureVersion = 1;
+// Mixed into cache keys; bump when the decoder, mip filter or encoders
+// change output so old entries are no longer picked up.
+constexpr uint64_t kEncoderVersion = 2;
+constexpr uint32_t kMaxLevels = 32;
+
+template <typename T>
+void WritePod(std::ofstream *file, const T &value) {
+  file->write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadPod(std::ifstream *file, T *value) {
+  file->read(reinterpret_cast<char *>(value), sizeof(T));
+  return file->good();
+}
+
+bool SetError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+// Temporary file suffix that is unique across processes sharing a cache
+// directory (random per process) and across writers within one process.
+std::string TempFileSuffix() {
+  static const uint64_t process_token = []() {
+    std::random_device device;
+    return (static_cast<uint64_t>(device()) << 32) ^ device();
+  }();
+  static std::atomic<uint64_t> next_write{0};
+  char suffix[48];
+  std::snprintf(suffix, sizeof(suffix), ".tmp%016" PRIx64 "-%" PRIu64,
+                process_token, next_write.fetch_add(1));
+  return suffix;
+}
+
+TextureFormat UncompressedFormat(TextureFormat format) {
+  return format == TextureFormat::kBc7Srgb ? TextureFormat::kRgba8Srgb
+         : IsBlockCompressed(format)       ? TextureFormat::kRgba8
+                                           : format;
+}
+
+bool BuildTexture(const std::vector<uint8_t> &encoded,
+                  TextureFormat format,
+                  Texture *texture,
+                  std::string *error) {
+  Texture rgba;
+  rgba.format = UncompressedFormat(format);
+  rgba.levels.resize(1);
+  {
+    BANDO_PROFILE_ZONE("DecodeImage");
+    if (!DecodeImageRgba8(encoded.data(), encoded.size(), &rgba.levels[0],
+                          error)) {
+      return false;
+    }
+  }
+  {
+    BANDO_PROFILE_ZONE("GenerateMipChain");
+    GenerateMipChain(&rgba);
+  }
+  const TextureLevel &base = rgba.levels[0];
+  if (!IsBlockCompressed(format) || base.width % 4 != 0 ||
+      base.height % 4 != 0) {
+    *texture = std::move(rgba);
+    return true;
+  }
+  BANDO_PROFILE_ZONE("CompressTexture");
+  *texture = CompressTexture(rgba, format);
+  return true;
+}
+
+}  // namespace
+
+TextureFormat TargetTextureFormat(TextureUsage usage, bool compress) {
+  switch (usage) {
+    case TextureUsage::kColorSrgb:
+      return compress ? TextureFormat::kBc7Srgb : TextureFormat::kRgba8Srgb;
+    case TextureUsage::kColorLinear:
+      return compress ? TextureFormat::kBc7 : TextureFormat::kRgba8;
+    case TextureUsage::kNormal:
+      return compress ? TextureFormat::kBc5 : TextureFormat::kRgba8;
+  }
+  return TextureFormat::kRgba8;
+}
+
+uint64_t TextureCacheKey(const uint8_t *encoded,
+                         size_t size,
+                         TextureFormat format) {
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= encoded[i];
+    hash *= 1099511628211ull;
+  }
+  uint64_t tags[2] = {kEncoderVersion, static_cast<uint64_t>(format)};
+  for (uint64_t tag : tags) {
+    hash ^= tag;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::string TextureCachePath(const std::string &cache_dir, uint64_t key) {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016" PRIx64 ".btex", key);
+  return (std::filesystem::path(cache_dir) / name).string();
+}
+
+bool ReadTextureFile(const std::string &path,
+                     Texture *texture,
+                     std::string *error) {
+  if (!texture) {
+    return false;
+  }
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return SetError(error, "Failed to open texture file");
+  }
+  char magic[sizeof(kTextureMagic)] = {};
+  file.read(magic, sizeof(magic));
+  uint32_t version = 0;
+  uint32_t format = 0;
+  uint32_t level_count = 0;
+  if (!file.good() || std::memcmp(magic, kTextureMagic, sizeof(magic)) != 0 ||
+      !ReadPod(&file, &version) || version != kTextureVersion) {
+    return SetError(error, "Not a texture file of a supported version");
+  }
+  if (!ReadPod(&file, &format) || !ReadPod(&file, &level_count) ||
+      format > static_cast<uint32_t>(TextureFormat::kBc5) ||
+      level_count == 0 || level_count > kMaxLevels) {
+    return SetError(error, "Corrupt texture file header");
+  }
+  texture->format = static_cast<TextureFormat>(format);
+  texture->levels.resize(level_count);
+  for (TextureLevel &level : texture->levels) {
+    uint64_t size = 0;
+    if (!ReadPod(&file, &level.width) || !ReadPod(&file, &level.height) ||
+        !ReadPod(&file, &size)) {
+      return SetError(error, "Truncated texture file");
+    }
+    if (level.width == 0 || level.height == 0 ||
+        size != TextureLevelSize(texture->format, level.width,
+                                 level.height)) {
+      return SetError(error, "Corrupt texture level");
+    }
+    level.data.resize(static_cast<size_t>(size));
+    file.read(reinterpret_cast<char *>(level.data.data()),
+              static_cast<std::streamsize>(size));
+    if (!file.good()) {
+      return SetError(error, "Truncated texture file");
+    }
+  }
+  return true;
+}
+
+bool WriteTextureFile(const std::string &path,
+                      const Texture &texture,
+                      std::string *error) {
+  // Unique per write so parallel writers, in this process or another one
+  // sharing the cache directory, never share a temporary file.
+  std::string temp_path = path + TempFileSuffix();
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      return SetError(error, "Failed to open texture file for writing");
+    }
+    file.write(kTextureMagic, sizeof(kTextureMagic));
+    WritePod(&file, kTextureVersion);
+    WritePod(&file, static_cast<uint32_t>(texture.format));
+    WritePod(&file, static_cast<uint32_t>(texture.levels.size()));
+    for (const TextureLevel &level : texture.levels) {
+      WritePod(&file, level.width);
+      WritePod(&file, level.height);
+      WritePod(&file, static_cast<uint64_t>(level.data.size()));
+      file.write(reinterpret_cast<const char *>(level.data.data()),
+                 static_cast<std::streamsize>(level.data.size()));
+    }
+    if (!file.good()) {
+      file.close();
+      std::error_code ignored;
+      std::filesystem::remove(temp_path, ignored);
+      return SetError(error, "Failed to write texture file");
+    }
+  }
+  std::error_code rename_error;
+  std::filesystem::rename(temp_path, path, rename_error);
+  if (rename_error) {
+    std::error_code ignored;
+    std::filesystem::remove(temp_path, ignored);
+    return SetError(error, "Failed to move texture file into place: " +
+                               rename_error.message());
+  }
+  return true;
+}
+
+bool PrepareTextures(const std::vector<TextureJob> &jobs,
+                     const TextureCacheOptions &options,
+                     std::vector<Texture> *textures,
+                     TextureCacheStats *stats,
+                     std::string *error) {
+  BANDO_PROFILE_ZONE("PrepareTextures");
+  if (!textures) {
+    return false;
+  }
+  auto start = std::chrono::steady_clock::now();
+  textures->assign(jobs.size(), Texture());
+  bool use_cache = !options.cache_dir.empty();
+  if (use_cache) {
+    std::error_code create_error;
+    std::filesystem::create_directories(options.cache_dir, create_error);
+    if (create_error) {
+      use_cache = false;
+    }
+  }
+
+  std::atomic<size_t> next_job{0};
+  std::atomic<uint32_t> hits{0};
+  std::atomic<uint32_t> misses{0};
+  std::atomic<uint32_t> failures{0};
+  std::mutex error_mutex;
+  std::string first_error;
+  auto fail = [&](const std::string &message) {
+    failures.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(error_mutex);
+    if (first_error.empty()) {
+      first_error = message;
+    }
+  };
+  auto worker = [&]() {
+    for (;;) {
+      size_t index = next_job.fetch_add(1, std::memory_order_relaxed);
+      if (index >= jobs.size()) {
+        return;
+      }
+      BANDO_PROFILE_ZONE("PrepareTexture");
+      const TextureJob &job = jobs[index];
+      Texture &texture = (*textures)[index];
+      if (!job.encoded || job.encoded->empty()) {
+        fail("Texture job has no image data");
+        continue;
+      }
+      TextureFormat format = TargetTextureFormat(job.usage, options.compress);
+      std::string path;
+      if (use_cache) {
+        path = TextureCachePath(
+            options.cache_dir,
+            TextureCacheKey(job.encoded->data(), job.encoded->size(), format));
+        std::string ignored;
+        if (ReadTextureFile(path, &texture, &ignored)) {
+          hits.fetch_add(1, std::memory_order_relaxed);
+          continue;
+        }
+      }
+      misses.fetch_add(1, std::memory_order_relaxed);
+      std::string job_error;
+      if (!BuildTexture(*job.encoded, format, &texture, &job_error)) {
+        texture = Texture();
+        fail(job_error);
+        continue;
+      }
+      // A failed cache write only costs a rebuild next time.
+      if (use_cache) {
+        WriteTextureFile(path, texture, &job_error);
+      }
+    }
+  };
+
+  size_t thread_count = options.threads > 0
+                            ? static_cast<size_t>(options.threads)
+                            : std::max(std::thread::hardware_concurrency(), 1u);
+  thread_count = std::min(thread_count, std::max<size_t>(jobs.size(), 1));
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  for (size_t i = 1; i < thread_count; ++i) {
+    threads.emplace_back([&worker]() {
+      BANDO_PROFILE_THREAD_NAME("texture_worker");
+      worker();
+    });
+  }
+  worker();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  if (stats) {
+    stats->hits = hits.load();
+    stats->misses = misses.load();
+    stats->failures = failures.load();
+    stats->wall_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+  }
+  if (!first_error.empty()) {
+    return SetError(error, first_error);
+  }
+  return true;
+}
+
+}  // namespace bando
@@ -0,0 +1,79 @@
+#ifndef EXAMPLES_TEXTURES_TEXTURE_CACHE_H_
+#define EXAMPLES_TEXTURES_TEXTURE_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "examples/textures/texture_codec.h"
+
+// Turns encoded glTF images into upload-ready mip chains on worker threads,
+// backed by an on-disk cache so PNG/JPEG decoding and BC encoding only
+// happen the first time an image is seen.
+//
+// Cache entries are named after a hash of the encoded image bytes and the
+// target format, so edited images get new entries and stale ones are never
+// read. Entries are written to a temporary file and renamed into place,
+// which makes concurrent bakes of the same directory safe.
+
+namespace bando {
+
+enum class TextureUsage {
+  kColorSrgb,    // Base color, emissive.
+  kColorLinear,  // Metallic-roughness, occlusion.
+  kNormal,       // Tangent space normals; only X and Y are kept.
+};
+
+struct TextureJob {
+  const std::vector<uint8_t> *encoded = nullptr;
+  TextureUsage usage = TextureUsage::kColorSrgb;
+};
+
+struct TextureCacheOptions {
+  // Directory holding cache entries; empty disables the disk cache.
+  std::string cache_dir;
+  // BC7/BC5 when true, RGBA8 mips otherwise (for devices without BC).
+  bool compress = true;
+  // Worker count including the calling thread; 0 uses every core.
+  int threads = 0;
+};
+
+struct TextureCacheStats {
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+  uint32_t failures = 0;
+  double wall_ms = 0.0;
+};
+
+// Format a texture of `usage` is stored in. BC formats are only chosen when
+// `compress` is set.
+TextureFormat TargetTextureFormat(TextureUsage usage, bool compress);
+
+uint64_t TextureCacheKey(const uint8_t *encoded,
+                         size_t size,
+                         TextureFormat format);
+std::string TextureCachePath(const std::string &cache_dir, uint64_t key);
+
+bool ReadTextureFile(const std::string &path,
+                     Texture *texture,
+                     std::string *error);
+bool WriteTextureFile(const std::string &path,
+                      const Texture &texture,
+                      std::string *error);
+
+// Fills `textures` with one mip chain per job, in job order. Each job is
+// read from the cache when possible and otherwise decoded, mipped,
+// compressed and written back. Returns false with the first error if any
+// job failed; failed jobs are left without levels and the rest are still
+// produced. BC compression is skipped for images whose size is not a
+// multiple of 4, which keep RGBA8 mips instead.
+bool PrepareTextures(const std::vector<TextureJob> &jobs,
+                     const TextureCacheOptions &options,
+                     std::vector<Texture> *textures,
+                     TextureCacheStats *stats,
+                     std::string *error);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_TEXTURES_TEXTURE_CACHE_H_
@@ -0,0 +1,514 @@
+#include "examples/textures/texture_codec.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BANDO_TEXTURE_SSE2 1
+#endif
+
+namespace bando {
+
+namespace {
+
+constexpr size_t kBlockBytes = 16;
+
+// BC7 4-bit index interpolation weights (out of 64).
+constexpr int kBc7Weights4[16] = {0,  4,  9,  13, 17, 21, 26, 30,
+                                  34, 38, 43, 47, 51, 55, 60, 64};
+
+struct BitWriter {
+  uint8_t *out;
+  int position = 0;
+
+  void Put(uint32_t value, int bits) {
+    for (int i = 0; i < bits; ++i, ++position) {
+      if ((value >> i) & 1u) {
+        out[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+      }
+    }
+  }
+};
+
+// Gathers a 4x4 block of RGBA texels, repeating the last row/column for
+// partial blocks at the right and bottom edges.
+void FetchBlock(const TextureLevel &rgba,
+                uint32_t block_x,
+                uint32_t block_y,
+                uint8_t texels[16][4]) {
+  for (uint32_t y = 0; y < 4; ++y) {
+    uint32_t source_y = std::min(block_y * 4 + y, rgba.height - 1);
+    for (uint32_t x = 0; x < 4; ++x) {
+      uint32_t source_x = std::min(block_x * 4 + x, rgba.width - 1);
+      const uint8_t *texel =
+          rgba.data.data() +
+          (static_cast<size_t>(source_y) * rgba.width + source_x) * 4;
+      std::memcpy(texels[y * 4 + x], texel, 4);
+    }
+  }
+}
+
+int Bc7Interpolate(int e0, int e1, int index) {
+  int weight = kBc7Weights4[index];
+  return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+}
+
+int Bc7IndexError(const int e0[4], const int e1[4], const uint8_t texel[4],
+                  int index) {
+  int error = 0;
+  for (int c = 0; c < 4; ++c) {
+    int diff = Bc7Interpolate(e0[c], e1[c], index) - texel[c];
+    error += diff * diff;
+  }
+  return error;
+}
+
+// Principal axis of the block's texels, found with a few rounds of power
+// iteration on the covariance matrix. Returns false for flat blocks.
+bool PrincipalAxis(const uint8_t texels[16][4], float mean[4],
+                   float axis[4]) {
+  for (int c = 0; c < 4; ++c) {
+    mean[c] = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+      mean[c] += texels[i][c];
+    }
+    mean[c] /= 16.0f;
+  }
+  float covariance[4][4] = {};
+  for (int i = 0; i < 16; ++i) {
+    float d[4];
+    for (int c = 0; c < 4; ++c) {
+      d[c] = texels[i][c] - mean[c];
+    }
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) {
+        covariance[r][c] += d[r] * d[c];
+      }
+    }
+  }
+  float v[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+  for (int c = 0; c < 4; ++c) {
+    v[c] = covariance[c][c] + 1e-3f;
+  }
+  float length = 0.0f;
+  for (int iteration = 0; iteration < 8; ++iteration) {
+    float next[4] = {};
+    for (int r = 0; r < 4; ++r) {
+      for (int c = 0; c < 4; ++c) {
+        next[r] += covariance[r][c] * v[c];
+      }
+    }
+    length = std::sqrt(next[0] * next[0] + next[1] * next[1] +
+                       next[2] * next[2] + next[3] * next[3]);
+    if (length < 1e-6f) {
+      return false;
+    }
+    for (int c = 0; c < 4; ++c) {
+      v[c] = next[c] / length;
+    }
+  }
+  std::memcpy(axis, v, sizeof(v));
+  return true;
+}
+
+// Quantizes a pair of 8-bit endpoints for every p-bit combination and
+// picks per-texel indices, keeping the lowest squared error result.
+struct Bc7Mode6Fit {
+  int error = INT_MAX;
+  int q[2][4] = {};
+  int p[2] = {};
+  uint8_t indices[16] = {};
+};
+
+void FitBc7Mode6(const uint8_t texels[16][4],
+                 const int low[4],
+                 const int high[4],
+                 Bc7Mode6Fit *best) {
+  for (int p0 = 0; p0 < 2; ++p0) {
+    for (int p1 = 0; p1 < 2; ++p1) {
+      int q[2][4];
+      int e0[4];
+      int e1[4];
+      for (int c = 0; c < 4; ++c) {
+        q[0][c] = std::clamp((low[c] - p0 + 1) >> 1, 0, 127);
+        q[1][c] = std::clamp((high[c] - p1 + 1) >> 1, 0, 127);
+        e0[c] = (q[0][c] << 1) | p0;
+        e1[c] = (q[1][c] << 1) | p1;
+      }
+      int axis[4];
+      int axis_length = 0;
+      for (int c = 0; c < 4; ++c) {
+        axis[c] = e1[c] - e0[c];
+        axis_length += axis[c] * axis[c];
+      }
+      uint8_t indices[16];
+      int error = 0;
+      for (int i = 0; i < 16 && error < best->error; ++i) {
+        int guess = 0;
+        if (axis_length > 0) {
+          int projection = 0;
+          for (int c = 0; c < 4; ++c) {
+            projection += (texels[i][c] - e0[c]) * axis[c];
+          }
+          guess = std::clamp(
+              (projection * 15 + axis_length / 2) / axis_length, 0, 15);
+        }
+        // The weights are not evenly spaced, so check the neighbours too.
+        int best_index = guess;
+        int best_index_error = Bc7IndexError(e0, e1, texels[i], guess);
+        for (int index = std::max(guess - 1, 0);
+             index <= std::min(guess + 1, 15); ++index) {
+          int index_error = Bc7IndexError(e0, e1, texels[i], index);
+          if (index_error < best_index_error) {
+            best_index = index;
+            best_index_error = index_error;
+          }
+        }
+        indices[i] = static_cast<uint8_t>(best_index);
+        error += best_index_error;
+      }
+      if (error < best->error) {
+        best->error = error;
+        std::memcpy(best->q, q, sizeof(q));
+        best->p[0] = p0;
+        best->p[1] = p1;
+        std::memcpy(best->indices, indices, sizeof(indices));
+      }
+    }
+  }
+}
+
+// Mode 6: 7-bit RGBA endpoints plus one shared LSB (p-bit) per endpoint.
+// Endpoints come from the texels' extent along their principal axis, with
+// the per-channel bounding box as a second candidate.
+void EncodeBc7Block(const uint8_t texels[16][4], uint8_t block[16]) {
+  int low[4] = {255, 255, 255, 255};
+  int high[4] = {0, 0, 0, 0};
+  for (int i = 0; i < 16; ++i) {
+    for (int c = 0; c < 4; ++c) {
+      low[c] = std::min<int>(low[c], texels[i][c]);
+      high[c] = std::max<int>(high[c], texels[i][c]);
+    }
+  }
+  Bc7Mode6Fit best;
+  float mean[4];
+  float axis[4];
+  if (PrincipalAxis(texels, mean, axis)) {
+    float t_min = 0.0f;
+    float t_max = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+      float t = 0.0f;
+      for (int c = 0; c < 4; ++c) {
+        t += (texels[i][c] - mean[c]) * axis[c];
+      }
+      t_min = std::min(t_min, t);
+      t_max = std::max(t_max, t);
+    }
+    int axis_low[4];
+    int axis_high[4];
+    for (int c = 0; c < 4; ++c) {
+      axis_low[c] = std::clamp(
+          static_cast<int>(std::lround(mean[c] + t_min * axis[c])), 0, 255);
+      axis_high[c] = std::clamp(
+          static_cast<int>(std::lround(mean[c] + t_max * axis[c])), 0, 255);
+    }
+    FitBc7Mode6(texels, axis_low, axis_high, &best);
+  }
+  FitBc7Mode6(texels, low, high, &best);
+
+  // The anchor (first) index is stored with its top bit implied zero.
+  if (best.indices[0] & 8) {
+    for (int c = 0; c < 4; ++c) {
+      std::swap(best.q[0][c], best.q[1][c]);
+    }
+    std::swap(best.p[0], best.p[1]);
+    for (uint8_t &index : best.indices) {
+      index = static_cast<uint8_t>(15 - index);
+    }
+  }
+
+  std::memset(block, 0, kBlockBytes);
+  BitWriter writer{block};
+  writer.Put(1u << 6, 7);
+  for (int c = 0; c < 4; ++c) {
+    writer.Put(static_cast<uint32_t>(best.q[0][c]), 7);
+    writer.Put(static_cast<uint32_t>(best.q[1][c]), 7);
+  }
+  writer.Put(static_cast<uint32_t>(best.p[0]), 1);
+  writer.Put(static_cast<uint32_t>(best.p[1]), 1);
+  writer.Put(best.indices[0], 3);
+  for (int i = 1; i < 16; ++i) {
+    writer.Put(best.indices[i], 4);
+  }
+}
+
+// BC4 with endpoint0 = max > endpoint1 = min selects the eight value
+// palette: index 0 and 1 are the endpoints, 2..7 step from max to min.
+void EncodeBc4Block(const uint8_t texels[16][4], int channel,
+                    uint8_t block[8]) {
+  int low = 255;
+  int high = 0;
+  for (int i = 0; i < 16; ++i) {
+    low = std::min<int>(low, texels[i][channel]);
+    high = std::max<int>(high, texels[i][channel]);
+  }
+  std::memset(block, 0, 8);
+  block[0] = static_cast<uint8_t>(high);
+  block[1] = static_cast<uint8_t>(low);
+  if (high == low) {
+    return;
+  }
+  int range = high - low;
+  uint64_t bits = 0;
+  for (int i = 0; i < 16; ++i) {
+    int step = ((high - texels[i][channel]) * 7 + range / 2) / range;
+    uint64_t index = step == 0 ? 0 : (step == 7 ? 1 : step + 1);
+    bits |= index << (3 * i);
+  }
+  for (int i = 0; i < 6; ++i) {
+    block[2 + i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+}
+
+template <typename EncodeBlock>
+void EncodeBlocks(const TextureLevel &rgba,
+                  TextureLevel *out,
+                  EncodeBlock encode_block) {
+  out->width = rgba.width;
+  out->height = rgba.height;
+  uint32_t blocks_x = (rgba.width + 3) / 4;
+  uint32_t blocks_y = (rgba.height + 3) / 4;
+  out->data.assign(static_cast<size_t>(blocks_x) * blocks_y * kBlockBytes, 0);
+  uint8_t texels[16][4];
+  uint8_t *block = out->data.data();
+  for (uint32_t by = 0; by < blocks_y; ++by) {
+    for (uint32_t bx = 0; bx < blocks_x; ++bx, block += kBlockBytes) {
+      FetchBlock(rgba, bx, by, texels);
+      encode_block(texels, block);
+    }
+  }
+}
+
+void AverageTexel(const uint8_t *a, const uint8_t *b, const uint8_t *c,
+                  const uint8_t *d, uint8_t *out) {
+  for (int channel = 0; channel < 4; ++channel) {
+    out[channel] = static_cast<uint8_t>(
+        (a[channel] + b[channel] + c[channel] + d[channel] + 2) >> 2);
+  }
+}
+
+float SrgbToLinear(float value) {
+  return value <= 0.04045f ? value / 12.92f
+                           : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+// 8-bit sRGB to linear light, and back by search: `midpoints[i]` is the
+// linear value halfway (in sRGB) between codes i and i + 1, so counting
+// the midpoints below a linear value rounds it to the nearest code.
+struct SrgbTables {
+  float to_linear[256];
+  float midpoints[255];
+
+  SrgbTables() {
+    for (int i = 0; i < 256; ++i) {
+      to_linear[i] = SrgbToLinear(i / 255.0f);
+    }
+    for (int i = 0; i < 255; ++i) {
+      midpoints[i] = SrgbToLinear((i + 0.5f) / 255.0f);
+    }
+  }
+
+  uint8_t Encode(float linear) const {
+    return static_cast<uint8_t>(
+        std::upper_bound(midpoints, midpoints + 255, linear) - midpoints);
+  }
+};
+
+const SrgbTables &GetSrgbTables() {
+  static const SrgbTables tables;
+  return tables;
+}
+
+// AverageTexel for sRGB color: RGB is averaged in linear light, alpha as
+// stored.
+void AverageTexelSrgb(const SrgbTables &tables, const uint8_t *a,
+                      const uint8_t *b, const uint8_t *c, const uint8_t *d,
+                      uint8_t *out) {
+  for (int channel = 0; channel < 3; ++channel) {
+    float sum = tables.to_linear[a[channel]] + tables.to_linear[b[channel]] +
+                tables.to_linear[c[channel]] + tables.to_linear[d[channel]];
+    out[channel] = tables.Encode(sum * 0.25f);
+  }
+  out[3] = static_cast<uint8_t>((a[3] + b[3] + c[3] + d[3] + 2) >> 2);
+}
+
+}  // namespace
+
+bool IsBlockCompressed(TextureFormat format) {
+  return format == TextureFormat::kBc7 || format == TextureFormat::kBc7Srgb ||
+         format == TextureFormat::kBc5;
+}
+
+size_t TextureLevelSize(TextureFormat format,
+                        uint32_t width,
+                        uint32_t height) {
+  if (IsBlockCompressed(format)) {
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) *
+           kBlockBytes;
+  }
+  return static_cast<size_t>(width) * height * 4;
+}
+
+bool DecodeImageRgba8(const uint8_t *bytes,
+                      size_t size,
+                      TextureLevel *out,
+                      std::string *error) {
+  if (!bytes || !out || size == 0 || size > INT_MAX) {
+    if (error) {
+      *error = "Invalid image data";
+    }
+    return false;
+  }
+  int width = 0;
+  int height = 0;
+  int channels = 0;
+  stbi_uc *pixels = stbi_load_from_memory(bytes, static_cast<int>(size),
+                                          &width, &height, &channels, 4);
+  if (!pixels) {
+    if (error) {
+      *error = std::string("Image decode failed: ") + stbi_failure_reason();
+    }
+    return false;
+  }
+  out->width = static_cast<uint32_t>(width);
+  out->height = static_cast<uint32_t>(height);
+  out->data.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+  stbi_image_free(pixels);
+  return true;
+}
+
+void DownsampleRgba8(const TextureLevel &source, TextureLevel *out) {
+  out->width = std::max(source.width / 2, 1u);
+  out->height = std::max(source.height / 2, 1u);
+  out->data.resize(static_cast<size_t>(out->width) * out->height * 4);
+  const size_t source_pitch = static_cast<size_t>(source.width) * 4;
+  for (uint32_t y = 0; y < out->height; ++y) {
+    const uint8_t *row0 =
+        source.data.data() + std::min(y * 2, source.height - 1) * source_pitch;
+    const uint8_t *row1 =
+        source.data.data() +
+        std::min(y * 2 + 1, source.height - 1) * source_pitch;
+    uint8_t *dest =
+        out->data.data() + static_cast<size_t>(y) * out->width * 4;
+    uint32_t x = 0;
+#if defined(BANDO_TEXTURE_SSE2)
+    // Two output texels per step: widen four source texels from each row
+    // to 16 bits, add the rows, then add horizontal neighbours.
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rounding = _mm_set1_epi16(2);
+    for (; (x + 2) * 2 <= source.width; x += 2) {
+      __m128i top = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(row0 + x * 8));
+      __m128i bottom = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(row1 + x * 8));
+      __m128i low = _mm_add_epi16(_mm_unpacklo_epi8(top, zero),
+                                  _mm_unpacklo_epi8(bottom, zero));
+      __m128i high = _mm_add_epi16(_mm_unpackhi_epi8(top, zero),
+                                   _mm_unpackhi_epi8(bottom, zero));
+      low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+      high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+      __m128i sum = _mm_unpacklo_epi64(low, high);
+      sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dest + x * 4),
+                       _mm_packus_epi16(sum, zero));
+    }
+#endif
+    for (; x < out->width; ++x) {
+      uint32_t x0 = std::min(x * 2, source.width - 1) * 4;
+      uint32_t x1 = std::min(x * 2 + 1, source.width - 1) * 4;
+      AverageTexel(row0 + x0, row0 + x1, row1 + x0, row1 + x1, dest + x * 4);
+    }
+  }
+}
+
+void DownsampleSrgb8(const TextureLevel &source, TextureLevel *out) {
+  const SrgbTables &tables = GetSrgbTables();
+  out->width = std::max(source.width / 2, 1u);
+  out->height = std::max(source.height / 2, 1u);
+  out->data.resize(static_cast<size_t>(out->width) * out->height * 4);
+  const size_t source_pitch = static_cast<size_t>(source.width) * 4;
+  for (uint32_t y = 0; y < out->height; ++y) {
+    const uint8_t *row0 =
+        source.data.data() + std::min(y * 2, source.height - 1) * source_pitch;
+    const uint8_t *row1 =
+        source.data.data() +
+        std::min(y * 2 + 1, source.height - 1) * source_pitch;
+    uint8_t *dest =
+        out->data.data() + static_cast<size_t>(y) * out->width * 4;
+    for (uint32_t x = 0; x < out->width; ++x) {
+      uint32_t x0 = std::min(x * 2, source.width - 1) * 4;
+      uint32_t x1 = std::min(x * 2 + 1, source.width - 1) * 4;
+      AverageTexelSrgb(tables, row0 + x0, row0 + x1, row1 + x0, row1 + x1,
+                       dest + x * 4);
+    }
+  }
+}
+
+void GenerateMipChain(Texture *texture) {
+  if (!texture || texture->levels.size() != 1) {
+    return;
+  }
+  bool srgb = texture->format == TextureFormat::kRgba8Srgb;
+  while (texture->levels.back().width > 1 ||
+         texture->levels.back().height > 1) {
+    TextureLevel next;
+    if (srgb) {
+      DownsampleSrgb8(texture->levels.back(), &next);
+    } else {
+      DownsampleRgba8(texture->levels.back(), &next);
+    }
+    texture->levels.push_back(std::move(next));
+  }
+}
+
+void EncodeBc7(const TextureLevel &rgba, TextureLevel *out) {
+  EncodeBlocks(rgba, out, [](const uint8_t texels[16][4], uint8_t *block) {
+    EncodeBc7Block(texels, block);
+  });
+}
+
+void EncodeBc5(const TextureLevel &rgba, TextureLevel *out) {
+  EncodeBlocks(rgba, out, [](const uint8_t texels[16][4], uint8_t *block) {
+    EncodeBc4Block(texels, 0, block);
+    EncodeBc4Block(texels, 1, block + 8);
+  });
+}
+
+Texture CompressTexture(const Texture &rgba, TextureFormat format) {
+  Texture compressed;
+  compressed.format = format;
+  compressed.levels.resize(rgba.levels.size());
+  for (size_t i = 0; i < rgba.levels.size(); ++i) {
+    if (format == TextureFormat::kBc5) {
+      EncodeBc5(rgba.levels[i], &compressed.levels[i]);
+    } else {
+      EncodeBc7(rgba.levels[i], &compressed.levels[i]);
+    }
+  }
+  return compressed;
+}
+
+const char *TextureCodecIsa() {
+#if defined(BANDO_TEXTURE_SSE2)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+}  // namespace bando
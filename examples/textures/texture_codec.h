@@ -0,0 +1,78 @@
+#ifndef EXAMPLES_TEXTURES_TEXTURE_CODEC_H_
+#define EXAMPLES_TEXTURES_TEXTURE_CODEC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU side texture processing: PNG/JPEG decode to RGBA8, box filtered mip
+// chains and BC7/BC5 block compression. Everything here is single threaded
+// and thread safe; callers parallelize across images.
+
+namespace bando {
+
+// Stored as a uint32 in cache files, so values must stay stable.
+enum class TextureFormat : uint32_t {
+  kRgba8 = 0,
+  kRgba8Srgb = 1,
+  kBc7 = 2,
+  kBc7Srgb = 3,
+  kBc5 = 4,
+};
+
+struct TextureLevel {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  // Tightly packed texels, or 4x4 blocks in row order for BC formats.
+  std::vector<uint8_t> data;
+};
+
+struct Texture {
+  TextureFormat format = TextureFormat::kRgba8;
+  std::vector<TextureLevel> levels;
+};
+
+bool IsBlockCompressed(TextureFormat format);
+
+// Bytes of one level in `format`; BC levels round up to whole 4x4 blocks.
+size_t TextureLevelSize(TextureFormat format, uint32_t width, uint32_t height);
+
+// Decodes any stb_image format into a single RGBA8 level.
+bool DecodeImageRgba8(const uint8_t *bytes,
+                      size_t size,
+                      TextureLevel *out,
+                      std::string *error);
+
+// 2x2 box filter halving each dimension (rounding down, minimum 1). A one
+// texel wide or tall source is averaged with itself. Filtering happens on
+// the stored values, which is only right for linear data.
+void DownsampleRgba8(const TextureLevel &source, TextureLevel *out);
+
+// The same filter for sRGB color: RGB is averaged in linear light and
+// rounded to the nearest sRGB value, so mips do not darken; alpha is
+// averaged as stored.
+void DownsampleSrgb8(const TextureLevel &source, TextureLevel *out);
+
+// Appends levels until the last one is 1x1. Expects exactly one RGBA8
+// level; kRgba8Srgb textures are filtered with DownsampleSrgb8.
+void GenerateMipChain(Texture *texture);
+
+// Encodes an RGBA8 level with BC7 mode 6 (one subset, RGBA endpoints,
+// 4-bit indices).
+void EncodeBc7(const TextureLevel &rgba, TextureLevel *out);
+
+// Encodes the red and green channels of an RGBA8 level as BC5, e.g. a
+// tangent space normal map whose blue channel is reconstructed in shaders.
+void EncodeBc5(const TextureLevel &rgba, TextureLevel *out);
+
+// Compresses every level of an RGBA8 texture to `format`, which must be a
+// BC format.
+Texture CompressTexture(const Texture &rgba, TextureFormat format);
+
+// Name of the instruction set the mip filter was compiled for.
+const char *TextureCodecIsa();
+
+}  // namespace bando
+
+#endif  // EXAMPLES_TEXTURES_TEXTURE_CODEC_H_
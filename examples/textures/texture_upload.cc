@@ -0,0 +1,186 @@
+#include "examples/textures/texture_upload.h"
+
+#include <SDL3/SDL.h>
+
+#include "examples/profiling/profile_zones.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace bando {
+
+namespace {
+
+// Each level starts on a 16 byte boundary in the transfer buffer; some
+// backends require it for texture copies and it covers a full BC block.
+constexpr uint64_t kLevelAlignment = 16;
+
+uint64_t AlignLevelOffset(uint64_t offset) {
+  return (offset + kLevelAlignment - 1) & ~(kLevelAlignment - 1);
+}
+
+bool SetError(std::string *error, const std::string &message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+void ReleaseTextures(SDL_GPUDevice *device,
+                     std::vector<SDL_GPUTexture *> *textures) {
+  for (SDL_GPUTexture *texture : *textures) {
+    SDL_ReleaseGPUTexture(device, texture);
+  }
+  textures->clear();
+}
+
+}  // namespace
+
+SDL_GPUTextureFormat ToGpuTextureFormat(TextureFormat format) {
+  switch (format) {
+    case TextureFormat::kRgba8:
+      return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    case TextureFormat::kRgba8Srgb:
+      return SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM_SRGB;
+    case TextureFormat::kBc7:
+      return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+    case TextureFormat::kBc7Srgb:
+      return SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM_SRGB;
+    case TextureFormat::kBc5:
+      return SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM;
+  }
+  return SDL_GPU_TEXTUREFORMAT_INVALID;
+}
+
+bool SupportsBlockCompression(SDL_GPUDevice *device) {
+  const SDL_GPUTextureFormat formats[] = {
+      SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM,
+      SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM_SRGB,
+      SDL_GPU_TEXTUREFORMAT_BC5_RG_UNORM,
+  };
+  for (SDL_GPUTextureFormat format : formats) {
+    if (!SDL_GPUTextureSupportsFormat(device, format, SDL_GPU_TEXTURETYPE_2D,
+                                      SDL_GPU_TEXTUREUSAGE_SAMPLER)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool UploadTextures(SDL_GPUDevice *device,
+                    const std::vector<Texture> &textures,
+                    std::vector<SDL_GPUTexture *> *gpu_textures,
+                    std::string *error) {
+  BANDO_PROFILE_ZONE("UploadTextures");
+  if (!device || !gpu_textures) {
+    return false;
+  }
+  gpu_textures->clear();
+  uint64_t total_bytes = 0;
+  for (const Texture &texture : textures) {
+    if (texture.levels.empty()) {
+      return SetError(error, "Cannot upload a texture without levels");
+    }
+    for (const TextureLevel &level : texture.levels) {
+      total_bytes = AlignLevelOffset(total_bytes) + level.data.size();
+    }
+  }
+  if (textures.empty()) {
+    return true;
+  }
+  if (total_bytes > std::numeric_limits<Uint32>::max()) {
+    return SetError(error, "Textures exceed the transfer buffer size limit");
+  }
+
+  for (const Texture &texture : textures) {
+    SDL_GPUTextureCreateInfo info = {};
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = ToGpuTextureFormat(texture.format);
+    info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    info.width = texture.levels[0].width;
+    info.height = texture.levels[0].height;
+    info.layer_count_or_depth = 1;
+    info.num_levels = static_cast<Uint32>(texture.levels.size());
+    info.sample_count = SDL_GPU_SAMPLECOUNT_1;
+    SDL_GPUTexture *gpu_texture = SDL_CreateGPUTexture(device, &info);
+    if (!gpu_texture) {
+      ReleaseTextures(device, gpu_textures);
+      return SetError(error, std::string("SDL_CreateGPUTexture failed: ") +
+                                 SDL_GetError());
+    }
+    gpu_textures->push_back(gpu_texture);
+  }
+
+  SDL_GPUTransferBufferCreateInfo transfer_info = {};
+  transfer_info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+  transfer_info.size = static_cast<Uint32>(total_bytes);
+  SDL_GPUTransferBuffer *transfer_buffer =
+      SDL_CreateGPUTransferBuffer(device, &transfer_info);
+  if (!transfer_buffer) {
+    ReleaseTextures(device, gpu_textures);
+    return SetError(error, std::string("SDL_CreateGPUTransferBuffer failed: ") +
+                               SDL_GetError());
+  }
+  auto *transfer_memory = static_cast<uint8_t *>(
+      SDL_MapGPUTransferBuffer(device, transfer_buffer, false));
+  if (!transfer_memory) {
+    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+    ReleaseTextures(device, gpu_textures);
+    return SetError(error, std::string("SDL_MapGPUTransferBuffer failed: ") +
+                               SDL_GetError());
+  }
+  uint64_t offset = 0;
+  for (const Texture &texture : textures) {
+    for (const TextureLevel &level : texture.levels) {
+      offset = AlignLevelOffset(offset);
+      std::memcpy(transfer_memory + offset, level.data.data(),
+                  level.data.size());
+      offset += level.data.size();
+    }
+  }
+  SDL_UnmapGPUTransferBuffer(device, transfer_buffer);
+
+  SDL_GPUCommandBuffer *command_buffer = SDL_AcquireGPUCommandBuffer(device);
+  if (!command_buffer) {
+    SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+    ReleaseTextures(device, gpu_textures);
+    return SetError(error, std::string("SDL_AcquireGPUCommandBuffer failed: ") +
+                               SDL_GetError());
+  }
+  SDL_GPUCopyPass *copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+  offset = 0;
+  for (size_t i = 0; i < textures.size(); ++i) {
+    const Texture &texture = textures[i];
+    for (size_t level_index = 0; level_index < texture.levels.size();
+         ++level_index) {
+      const TextureLevel &level = texture.levels[level_index];
+      offset = AlignLevelOffset(offset);
+      // Zero pixels_per_row/rows_per_layer means tightly packed, which is
+      // what the cache stores for both RGBA8 and BC levels.
+      SDL_GPUTextureTransferInfo source = {};
+      source.transfer_buffer = transfer_buffer;
+      source.offset = static_cast<Uint32>(offset);
+      SDL_GPUTextureRegion destination = {};
+      destination.texture = (*gpu_textures)[i];
+      destination.mip_level = static_cast<Uint32>(level_index);
+      destination.w = level.width;
+      destination.h = level.height;
+      destination.d = 1;
+      SDL_UploadToGPUTexture(copy_pass, &source, &destination, false);
+      offset += level.data.size();
+    }
+  }
+  SDL_EndGPUCopyPass(copy_pass);
+  bool submitted = SDL_SubmitGPUCommandBuffer(command_buffer);
+  // Released transfer buffers stay alive until the copy has executed.
+  SDL_ReleaseGPUTransferBuffer(device, transfer_buffer);
+  if (!submitted) {
+    ReleaseTextures(device, gpu_textures);
+    return SetError(error, std::string("SDL_SubmitGPUCommandBuffer failed: ") +
+                               SDL_GetError());
+  }
+  return true;
+}
+
+}  // namespace bando
@@ -0,0 +1,30 @@
+#ifndef EXAMPLES_TEXTURES_TEXTURE_UPLOAD_H_
+#define EXAMPLES_TEXTURES_TEXTURE_UPLOAD_H_
+
+#include <SDL3/SDL_gpu.h>
+
+#include <string>
+#include <vector>
+
+#include "examples/textures/texture_codec.h"
+
+namespace bando {
+
+SDL_GPUTextureFormat ToGpuTextureFormat(TextureFormat format);
+
+// True when `device` can sample both BC7 and BC5 textures; pass it as
+// TextureCacheOptions::compress.
+bool SupportsBlockCompression(SDL_GPUDevice *device);
+
+// Creates one sampled 2D texture per entry with all of its mip levels and
+// uploads them through a single transfer buffer and copy pass. On failure
+// every texture created so far is released, `gpu_textures` is cleared and
+// false is returned.
+bool UploadTextures(SDL_GPUDevice *device,
+                    const std::vector<Texture> &textures,
+                    std::vector<SDL_GPUTexture *> *gpu_textures,
+                    std::string *error);
+
+}  // namespace bando
+
+#endif  // EXAMPLES_TEXTURES_TEXTURE_UPLOAD_H_